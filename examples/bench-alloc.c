@@ -0,0 +1,102 @@
+/*
+ * bench-alloc.c
+ *
+ * counts the heap allocations of building, emptying and rebuilding a large tree and of opening files repeatedly
+ * malloc, calloc and realloc are replaced by counting wrappers around the glibc allocator
+ */
+
+#include "procfuse.c"
+
+#include <stdio.h>
+
+#define DIRECTORIES 1000
+#define FILES 100
+#define OPENS 100000
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocations = 0;
+
+void* malloc(size_t size){
+	allocations++;
+	return __libc_malloc(size);
+}
+void* calloc(size_t nmemb, size_t size){
+	allocations++;
+	return __libc_calloc(nmemb, size);
+}
+void* realloc(void *ptr, size_t size){
+	allocations++;
+	return __libc_realloc(ptr, size);
+}
+
+static void createTree(struct procfuse *pf){
+	char path[64];
+	int d = 0, f = 0;
+
+	for(d=0;d<DIRECTORIES;d++){
+		for(f=0;f<FILES;f++){
+			snprintf(path, sizeof(path), "/dir%d/pod%d", d, f);
+			procfuse_createPOD_i64(pf, path, O_RDWR, NULL);
+		}
+	}
+}
+static void unlinkTree(struct procfuse *pf){
+	char path[64];
+	int d = 0, f = 0;
+
+	for(d=0;d<DIRECTORIES;d++){
+		for(f=0;f<FILES;f++){
+			snprintf(path, sizeof(path), "/dir%d/pod%d", d, f);
+			procfuse_unlink(pf, path);
+		}
+	}
+}
+/* opens a file like the open callback of the high-level backend does, writes to it and closes it */
+static void openFiles(struct procfuse *pf, int flags){
+	struct fuse_file_info fi;
+	int i = 0;
+
+	for(i=0;i<OPENS;i++){
+		memset(&fi, 0, sizeof(fi));
+		fi.flags = flags;
+		if(procfuse_openFileHandle(pf, procfuse_acquireAccessToNode(pf, "/dir0/pod0"), &fi)==0){
+			if((flags & O_ACCMODE)!=O_RDONLY){
+				procfuse_writeFileHandle(pf, &fi, "42", 2, 0);
+			}
+			procfuse_closeFileHandle(pf, &fi);
+		}
+	}
+}
+
+int main(void){
+	struct procfuse *pf = NULL;
+	unsigned long before = 0;
+
+	pf = procfuse_ctor("bench-alloc", "/tmp", NULL, NULL);
+	if(pf==NULL){
+		printf("procfuse_ctor failed: %s\n", strerror(errno));
+		return 1;
+	}
+
+	before = allocations;
+	createTree(pf);
+	printf("creating %d PODs in %d directories: %lu allocations\n", DIRECTORIES*FILES, DIRECTORIES, allocations-before);
+
+	unlinkTree(pf);
+	before = allocations;
+	createTree(pf);
+	printf("re-creating them after unlinking: %lu allocations\n", allocations-before);
+
+	before = allocations;
+	openFiles(pf, O_RDONLY);
+	printf("%d opens for reading: %lu allocations\n", OPENS, allocations-before);
+
+	before = allocations;
+	openFiles(pf, O_WRONLY);
+	printf("%d opens for writing: %lu allocations\n", OPENS, allocations-before);
+
+	return 0;
+}
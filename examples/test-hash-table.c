@@ -0,0 +1,202 @@
+/*
+ * test-hash-table.c
+ *
+ * inserts, lookups, removals and iteration of hash-table.c, from the small array inside the table to the slot arrays
+ * and back through deleted slots, with good and with colliding hashes
+ * exits with 1 if any check fails
+ */
+
+#include "hash-table.h"
+#include "hash-int.h"
+#include "compare-int.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEYS 20000
+
+static int keys[KEYS];
+static int freed[KEYS];
+static long failures = 0;
+
+static void fail(const char *what, int key, int rval){
+	if(failures<20){
+		printf("FAIL %s %d returned %d\n", what, key, rval);
+	}
+	failures++;
+}
+
+/* the value of every key is the key itself, freeing it is counted */
+static void countFree(HashTableValue value){
+	freed[*(int *)value]++;
+}
+
+/* the keys share three hashes, their probe sequences run through the same groups */
+static unsigned long collidingHash(HashTableKey key){
+	return (unsigned long)(*(int *)key % 3);
+}
+
+/* checks that exactly the keys below count and not removed are in the table, and that iterating visits each once */
+static void checkContent(HashTable *table, int count, const char *removed){
+	HashTableIterator iterator;
+	int *visits = NULL, *value = NULL;
+	int i = 0, expected = 0, visited = 0;
+
+	for(i=0;i<count;i++){
+		value = (int *)hash_table_lookup(table, &keys[i]);
+		if(removed!=NULL && removed[i]){
+			if(value!=NULL){
+				fail("lookup of a removed key", i, *value);
+			}
+		}
+		else{
+			expected++;
+			if(value!=&keys[i]){
+				fail("lookup", i, (value!=NULL) ? *value : -1);
+			}
+		}
+	}
+	if(hash_table_num_entries(table)!=expected){
+		fail("number of entries", count, hash_table_num_entries(table));
+	}
+
+	visits = (int *)calloc(KEYS, sizeof(int));
+	hash_table_iterate(table, &iterator);
+	while(hash_table_iter_has_more(&iterator)){
+		value = (int *)hash_table_iter_next(&iterator);
+		if(value==NULL){
+			fail("iteration returned no value", visited, 0);
+			break;
+		}
+		visits[*value]++;
+		visited++;
+	}
+	for(i=0;i<count;i++){
+		if(visits[i]!=((removed!=NULL && removed[i]) ? 0 : 1)){
+			fail("iteration visits", i, visits[i]);
+		}
+	}
+	if(visited!=expected){
+		fail("iterated entries", count, visited);
+	}
+	free(visits);
+}
+
+static void testTable(HashTableHashFunc hash, int count){
+	HashTable *table = NULL;
+	char *removed = NULL;
+	int i = 0, round = 0;
+
+	memset(freed, 0, sizeof(freed));
+	removed = (char *)calloc(count, 1);
+	table = hash_table_new(hash, int_equal);
+	hash_table_register_free_functions(table, NULL, countFree);
+
+	/* every size up to 20 is checked, that covers the switch from the small array to the slot arrays */
+	for(i=0;i<count;i++){
+		if(!hash_table_insert(table, &keys[i], &keys[i])){
+			fail("insert", i, 0);
+		}
+		if(i<20 || i==count-1){
+			checkContent(table, i+1, NULL);
+		}
+	}
+
+	/* inserting a key again replaces and frees its value */
+	hash_table_insert(table, &keys[0], &keys[0]);
+	if(freed[0]!=1 || hash_table_num_entries(table)!=count){
+		fail("insert of an existing key", 0, freed[0]);
+	}
+	freed[0] = 0;
+
+	/* removing every other key leaves deleted slots behind, the later inserts reuse or clean them out */
+	for(round=0;round<4;round++){
+		for(i=round%2;i<count;i+=2){
+			if(hash_table_remove(table, &keys[i])!=1){
+				fail("remove", i, 0);
+			}
+			removed[i] = 1;
+		}
+		if(hash_table_remove(table, &keys[round%2])!=0){
+			fail("remove of a removed key", round%2, 1);
+		}
+		checkContent(table, count, removed);
+		for(i=round%2;i<count;i+=2){
+			hash_table_insert(table, &keys[i], &keys[i]);
+			removed[i] = 0;
+		}
+		checkContent(table, count, NULL);
+	}
+
+	/* down to the last entries, they may stay in the slot arrays */
+	for(i=0;i<count-3;i++){
+		hash_table_remove(table, &keys[i]);
+		removed[i] = 1;
+	}
+	checkContent(table, count, removed);
+
+	for(i=0;i<count;i++){
+		/* removed twice by the rounds, and once more unless it's one of the last entries */
+		if(freed[i]!=((i<count-3) ? 3 : 2)){
+			fail("values freed by removals", i, freed[i]);
+			break;
+		}
+	}
+	hash_table_free(table);
+	for(i=count-3;i<count;i++){
+		if(freed[i]!=3){
+			fail("values freed with the table", i, freed[i]);
+		}
+	}
+	free(removed);
+}
+
+/* removing from the small array moves its last entry into the gap, the hashes have to move along, as the entries are
+ * inserted into the slot arrays with them once the small array is full
+ */
+static void testSmallArray(void){
+	HashTable *table = NULL;
+	char removed[9];
+	int position = 0, i = 0;
+
+	for(position=0;position<6;position++){
+		memset(removed, 0, sizeof(removed));
+		table = hash_table_new(int_hash, int_equal);
+		for(i=0;i<6;i++){
+			hash_table_insert(table, &keys[i], &keys[i]);
+		}
+
+		hash_table_remove(table, &keys[position]);
+		hash_table_remove(table, &keys[(position+3)%6]);
+		removed[position] = removed[(position+3)%6] = 1;
+		checkContent(table, 6, removed);
+
+		/* the fourth insert moves everything into the slot arrays */
+		for(i=6;i<9;i++){
+			hash_table_insert(table, &keys[i], &keys[i]);
+		}
+		checkContent(table, 9, removed);
+
+		hash_table_free(table);
+	}
+}
+
+int main(void){
+	int i = 0;
+
+	for(i=0;i<KEYS;i++){
+		keys[i] = i;
+	}
+
+	testTable(int_hash, 5);
+	testTable(int_hash, 6);
+	testTable(int_hash, 7);
+	testTable(int_hash, KEYS);
+	testTable(collidingHash, 500);
+	testSmallArray();
+
+	printf("%ld failures\n", failures);
+
+	return (failures==0) ? 0 : 1;
+}
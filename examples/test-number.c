@@ -0,0 +1,245 @@
+/*
+ * test-number.c
+ *
+ * round trips of format-number.c through parse-number.c, and parse-number.c against the C library
+ * exits with 1 if any check fails
+ */
+
+#include "format-number.h"
+#include "parse-number.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <inttypes.h>
+
+#define ROUNDS 1000000
+
+static uint64_t state = 88172645463325252ULL;
+static long failures = 0;
+
+/* xorshift, the same values on every run */
+static uint64_t nextRandom(void){
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+static void fail(const char *what, const char *text, int rval){
+	if(failures<20){
+		printf("FAIL %s \"%s\" returned %d\n", what, text, rval);
+	}
+	failures++;
+}
+
+/* the text written by format_* reads back to the same bits and is consumed completely */
+static void testRoundTrip(void){
+	char buffer[FORMAT_NUMBER_MAX];
+	const char *end = NULL;
+	size_t length = 0;
+	uint64_t bits = 0;
+	uint32_t fbits = 0;
+	int32_t i32 = 0, r32 = 0;
+	int64_t i64 = 0, r64 = 0;
+	double d = 0.0, rd = 0.0;
+	float f = 0.0f, rf = 0.0f;
+	long i = 0;
+	int rval = 0;
+
+	for(i=0;i<ROUNDS;i++){
+		/* shifting by a random amount covers short and long numbers alike */
+		i32 = (int32_t)nextRandom() >> (nextRandom()%32);
+		length = format_int32(i32, buffer);
+		rval = parse_int32(buffer, buffer+length, &r32, &end);
+		if(rval!=0 || r32!=i32 || end!=buffer+length){
+			fail("int32 round trip", buffer, rval);
+		}
+
+		i64 = (int64_t)nextRandom() >> (nextRandom()%64);
+		length = format_int64(i64, buffer);
+		rval = parse_int64(buffer, buffer+length, &r64, &end);
+		if(rval!=0 || r64!=i64 || end!=buffer+length){
+			fail("int64 round trip", buffer, rval);
+		}
+
+		bits = nextRandom();
+		memcpy(&d, &bits, sizeof(d));
+		if(!isnan(d)){
+			length = format_double(d, buffer);
+			rval = parse_double(buffer, buffer+length, &rd, &end);
+			if(rval!=0 || memcmp(&rd, &d, sizeof(d))!=0 || end!=buffer+length){
+				fail("double round trip", buffer, rval);
+			}
+		}
+
+		fbits = (uint32_t)nextRandom();
+		memcpy(&f, &fbits, sizeof(f));
+		if(!isnan(f)){
+			length = format_float(f, buffer);
+			rval = parse_float(buffer, buffer+length, &rf, &end);
+			if(rval!=0 || memcmp(&rf, &f, sizeof(f))!=0 || end!=buffer+length){
+				fail("float round trip", buffer, rval);
+			}
+		}
+	}
+}
+
+/* text not written by format_* is read like strtod and strtof read it */
+static void testAgainstLibc(void){
+	static const char *formats[] = {"%.17g", "%.15g", "%.6g", "%.3e"};
+	char buffer[64];
+	uint64_t bits = 0;
+	double d = 0.0, rd = 0.0, expected = 0.0;
+	float rf = 0.0f, fexpected = 0.0f;
+	long i = 0;
+	int length = 0, rval = 0;
+
+	for(i=0;i<ROUNDS;i++){
+		bits = nextRandom();
+		memcpy(&d, &bits, sizeof(d));
+		if(isfinite(d)){
+			length = snprintf(buffer, sizeof(buffer), formats[i%4], d);
+			expected = strtod(buffer, NULL);
+			rval = parse_double(buffer, buffer+length, &rd, NULL);
+			if(rval!=0 || memcmp(&rd, &expected, sizeof(rd))!=0){
+				fail("double against strtod", buffer, rval);
+			}
+		}
+
+		/* short mantissas with exponents beyond the range of doubles */
+		length = snprintf(buffer, sizeof(buffer), "%" PRIu64 "e%d", nextRandom() >> (nextRandom()%64), (int)(nextRandom()%700)-350);
+		expected = strtod(buffer, NULL);
+		rval = parse_double(buffer, buffer+length, &rd, NULL);
+		if(rval==ERANGE ? expected!=HUGE_VAL : (rval!=0 || memcmp(&rd, &expected, sizeof(rd))!=0)){
+			fail("double against strtod", buffer, rval);
+		}
+		fexpected = strtof(buffer, NULL);
+		rval = parse_float(buffer, buffer+length, &rf, NULL);
+		if(rval==ERANGE ? fexpected!=HUGE_VALF : (rval!=0 || memcmp(&rf, &fexpected, sizeof(rf))!=0)){
+			fail("float against strtof", buffer, rval);
+		}
+	}
+}
+
+struct integercase{
+	const char *text;
+	int rval32;
+	int32_t value32;
+	int rval64;
+	int64_t value64;
+	size_t end; /* of a successful parse */
+};
+
+static void testIntegerEdges(void){
+	static const struct integercase cases[] = {
+		{"0", 0, 0, 0, 0, 1},
+		{"-0", 0, 0, 0, 0, 2},
+		{"+7", 0, 7, 0, 7, 2},
+		{"2147483647", 0, INT32_MAX, 0, INT32_MAX, 10},
+		{"-2147483648", 0, INT32_MIN, 0, INT32_MIN, 11},
+		{"2147483648", ERANGE, 0, 0, 2147483648LL, 10},
+		{"-2147483649", ERANGE, 0, 0, -2147483649LL, 11},
+		{"9223372036854775807", ERANGE, 0, 0, INT64_MAX, 19},
+		{"-9223372036854775808", ERANGE, 0, 0, INT64_MIN, 20},
+		{"9223372036854775808", ERANGE, 0, ERANGE, 0, 0},
+		{"-9223372036854775809", ERANGE, 0, ERANGE, 0, 0},
+		{"99999999999999999999999", ERANGE, 0, ERANGE, 0, 0},
+		{"00000000000000000000000000042", 0, 42, 0, 42, 29},
+		{"12abc", 0, 12, 0, 12, 2},
+		{"", EINVAL, 0, EINVAL, 0, 0},
+		{"-", EINVAL, 0, EINVAL, 0, 0},
+		{"+", EINVAL, 0, EINVAL, 0, 0},
+		{"abc", EINVAL, 0, EINVAL, 0, 0},
+		{" 1", EINVAL, 0, EINVAL, 0, 0},
+		{"--1", EINVAL, 0, EINVAL, 0, 0}
+	};
+	const char *end = NULL;
+	size_t i = 0, length = 0;
+	int32_t value32 = 0;
+	int64_t value64 = 0;
+	int rval = 0;
+
+	for(i=0;i<sizeof(cases)/sizeof(cases[0]);i++){
+		length = strlen(cases[i].text);
+
+		rval = parse_int32(cases[i].text, cases[i].text+length, &value32, &end);
+		if(rval!=cases[i].rval32 || (rval==0 && (value32!=cases[i].value32 || end!=cases[i].text+cases[i].end))){
+			fail("int32 edge case", cases[i].text, rval);
+		}
+
+		rval = parse_int64(cases[i].text, cases[i].text+length, &value64, &end);
+		if(rval!=cases[i].rval64 || (rval==0 && (value64!=cases[i].value64 || end!=cases[i].text+cases[i].end))){
+			fail("int64 edge case", cases[i].text, rval);
+		}
+	}
+}
+
+struct floatcase{
+	const char *text;
+	int rval;
+	size_t end; /* of a successful parse */
+};
+
+/* successful parses must give what strtod gives */
+static void testFloatEdges(void){
+	static const struct floatcase cases[] = {
+		{"0", 0, 1},
+		{"-0", 0, 2},
+		{".5", 0, 2},
+		{"1.", 0, 2},
+		{"1e", 0, 1},
+		{"1e+", 0, 1},
+		{"inf", 0, 3},
+		{"-Infinity", 0, 9},
+		{"nan", 0, 3},
+		{"1e400", ERANGE, 0},
+		{"-1e400", ERANGE, 0},
+		{"1.7976931348623159e308", ERANGE, 0},
+		{"1e-400", 0, 6},
+		{"1.7976931348623157e308", 0, 22},
+		{"2.2250738585072011e-308", 0, 23},
+		{"4.9406564584124654e-324", 0, 23},
+		{"123456789012345678901234567890e-5", 0, 33},
+		{"0.000000000000000000000000000001234567890123456789012345", 0, 56},
+		{"", EINVAL, 0},
+		{"-", EINVAL, 0},
+		{"+.", EINVAL, 0},
+		{".e1", EINVAL, 0},
+		{"abc", EINVAL, 0},
+		{" 1", EINVAL, 0}
+	};
+	const char *end = NULL;
+	size_t i = 0, length = 0;
+	double value = 0.0, expected = 0.0;
+	int rval = 0;
+
+	for(i=0;i<sizeof(cases)/sizeof(cases[0]);i++){
+		length = strlen(cases[i].text);
+
+		rval = parse_double(cases[i].text, cases[i].text+length, &value, &end);
+		if(rval!=cases[i].rval){
+			fail("double edge case", cases[i].text, rval);
+		}
+		else if(rval==0){
+			expected = strtod(cases[i].text, NULL);
+			if(end!=cases[i].text+cases[i].end ||
+			   (isnan(expected) ? !isnan(value) : memcmp(&value, &expected, sizeof(value))!=0)){
+				fail("double edge case", cases[i].text, rval);
+			}
+		}
+	}
+}
+
+int main(void){
+	testRoundTrip();
+	testAgainstLibc();
+	testIntegerEdges();
+	testFloatEdges();
+
+	printf("%ld failures\n", failures);
+
+	return (failures==0) ? 0 : 1;
+}
@@ -0,0 +1,614 @@
+/*
+ * test-procfuse.c
+ *
+ * behaviour of the file tree without mounting it, procfuse.c is included to reach the functions behind the fuse callbacks
+ * exits with 1 if any check fails
+ */
+
+#include "procfuse.c"
+
+#include <stdio.h>
+
+static long failures = 0;
+
+static void fail(const char *what, const char *path, int rval){
+	if(failures<20){
+		printf("FAIL %s \"%s\" returned %d\n", what, path, rval);
+	}
+	failures++;
+}
+
+/* opens path like the open callback of the high-level backend does */
+static int openPath(struct procfuse *pf, const char *path, int flags, struct fuse_file_info *fi){
+	memset(fi, 0, sizeof(struct fuse_file_info));
+	fi->flags = flags;
+	return procfuse_openFileHandle(pf, procfuse_acquireAccessToNode(pf, path), fi);
+}
+
+/* reads the whole content of path into buf as a string, returns the length or -errno */
+static int readPath(struct procfuse *pf, const char *path, char *buf, size_t size){
+	struct fuse_file_info fi;
+	int rval = 0;
+
+	rval = openPath(pf, path, O_RDONLY, &fi);
+	if(rval<0){
+		return rval;
+	}
+	rval = procfuse_readFileHandle(pf, &fi, buf, size-1, 0);
+	procfuse_closeFileHandle(pf, &fi);
+	buf[(rval>0) ? rval : 0] = '\0';
+	return rval;
+}
+
+static struct procfuse *closerpf = NULL;
+static struct fuse_file_info closerfi;
+
+static void* closePath(void *arg){
+	(void)arg;
+	procfuse_closeFileHandle(closerpf, &closerfi);
+	return NULL;
+}
+
+/* a file created where an unlinked one is still open is a new file, the last close of the old one leaves it alone */
+static void testCreateOverUnlinked(struct procfuse *pf){
+	struct fuse_file_info fi;
+	struct procfuse_hashnode *old = NULL;
+	pthread_t closer;
+	char buf[64];
+	int rval = 0, i = 0;
+
+	procfuse_createPOD_i(pf, "/unlinked/file", O_RDWR, NULL);
+	procfuse_writePOD_i(pf, "/unlinked/file", 1);
+	openPath(pf, "/unlinked/file", O_RDONLY, &fi);
+	procfuse_unlink(pf, "/unlinked/file");
+	old = procfuse_pathToNode(pf, "/unlinked/file", PROCFUSE_NO);
+	if(old==NULL || !procfuse_isPendingForUnlink(old)){
+		fail("unlink of an open file", "/unlinked/file", 0);
+	}
+
+	rval = procfuse_createPOD_i(pf, "/unlinked/file", O_RDWR, NULL);
+	if(rval!=1){
+		fail("create over an open unlinked file", "/unlinked/file", rval);
+	}
+	procfuse_writePOD_i(pf, "/unlinked/file", 2);
+	if(procfuse_pathToNode(pf, "/unlinked/file", PROCFUSE_NO)==old){
+		fail("create reused the unlinked node", "/unlinked/file", 0);
+	}
+	/* the open handle still reads the old file */
+	rval = procfuse_readFileHandle(pf, &fi, buf, sizeof(buf)-1, 0);
+	buf[(rval>0) ? rval : 0] = '\0';
+	if(atoi(buf)!=1){
+		fail("read of the unlinked file", "/unlinked/file", rval);
+	}
+	procfuse_closeFileHandle(pf, &fi);
+
+	rval = readPath(pf, "/unlinked/file", buf, sizeof(buf));
+	if(rval<=0 || atoi(buf)!=2){
+		fail("read after the last close", "/unlinked/file", rval);
+	}
+
+	/* the last close claims the old node and waits for pf->lock, a creator gets the lock first */
+	closerpf = pf;
+	for(i=0;i<20;i++){
+		procfuse_createPOD_i(pf, "/claimed", O_RDWR, NULL);
+		openPath(pf, "/claimed", O_RDONLY, &closerfi);
+		procfuse_unlink(pf, "/claimed");
+		old = procfuse_pathToNode(pf, "/claimed", PROCFUSE_NO);
+
+		pthread_rwlock_rdlock(&pf->lock);
+		pthread_create(&closer, NULL, closePath, NULL);
+		while((__atomic_load_n(&old->pinstate, __ATOMIC_ACQUIRE) & PROCFUSE_PIN_CLAIMED)==0){
+			sched_yield();
+		}
+		pthread_rwlock_unlock(&pf->lock);
+		rval = procfuse_createPOD_i(pf, "/claimed", O_RDWR, NULL);
+		pthread_join(closer, NULL);
+
+		procfuse_writePOD_i(pf, "/claimed", i);
+		if(rval!=1 || readPath(pf, "/claimed", buf, sizeof(buf))<=0 || atoi(buf)!=i){
+			fail("create over a claimed file", "/claimed", rval);
+		}
+		procfuse_unlink(pf, "/claimed");
+	}
+}
+
+/* stores through a handle are read and polled right away, procfuse_notifyPODHandle() only passes them on */
+static void testPODHandle(struct procfuse *pf){
+	struct procfuse_podhandle *handle = NULL;
+	struct fuse_file_info fi;
+	char buf[64];
+	int rval = 0, i = 0, value = 0;
+
+	procfuse_createPOD_i(pf, "/handle", O_RDWR, NULL);
+	handle = procfuse_openPODHandle(pf, "/handle");
+	if(handle==NULL){
+		fail("open handle", "/handle", 0);
+		return;
+	}
+
+	openPath(pf, "/handle", O_RDONLY, &fi);
+	procfuse_readFileHandle(pf, &fi, buf, sizeof(buf)-1, 0);
+	rval = procfuse_pollFileHandle(pf, &fi, NULL);
+	if(rval & POLLIN){
+		fail("poll before a store", "/handle", rval);
+	}
+
+	for(i=0;i<1000;i++){
+		procfuse_addPODHandle_i(handle, 1, &value);
+	}
+	rval = procfuse_pollFileHandle(pf, &fi, NULL);
+	if(!(rval & POLLIN)){
+		fail("poll after stores", "/handle", rval);
+	}
+	rval = procfuse_readFileHandle(pf, &fi, buf, sizeof(buf)-1, 0);
+	buf[(rval>0) ? rval : 0] = '\0';
+	if(value!=1000 || atoi(buf)!=1000){
+		fail("read after stores", "/handle", rval);
+	}
+	procfuse_closeFileHandle(pf, &fi);
+
+	rval = procfuse_notifyPODHandle(handle);
+	if(rval!=1){
+		fail("notify handle", "/handle", rval);
+	}
+	procfuse_closePODHandle(handle);
+	procfuse_unlink(pf, "/handle");
+}
+
+/* the value written through a file is committed when it's closed, even after writes through other files */
+static void testWriteTransaction(struct procfuse *pf){
+	struct fuse_file_info first, second;
+	int rval = 0, value = 0;
+
+	procfuse_createPOD_i(pf, "/transaction", O_RDWR, NULL);
+	openPath(pf, "/transaction", O_WRONLY, &first);
+	openPath(pf, "/transaction", O_WRONLY, &second);
+
+	procfuse_writeFileHandle(pf, &first, "7\n", 2, 0);
+	procfuse_writeFileHandle(pf, &second, "8\n", 2, 0);
+	rval = procfuse_writeFileHandle(pf, &second, "abc", 3, 0);
+	if(rval!=-EINVAL){
+		fail("write of a bad value", "/transaction", rval);
+	}
+	procfuse_readPOD_i(pf, "/transaction", &value);
+	if(value!=8){
+		fail("read before the release", "/transaction", value);
+	}
+
+	procfuse_closeFileHandle(pf, &second);
+	procfuse_readPOD_i(pf, "/transaction", &value);
+	if(value!=8){
+		fail("release of the last writer", "/transaction", value);
+	}
+	procfuse_closeFileHandle(pf, &first);
+	procfuse_readPOD_i(pf, "/transaction", &value);
+	if(value!=7){
+		fail("release of the first writer", "/transaction", value);
+	}
+	procfuse_unlink(pf, "/transaction");
+}
+
+/* a listing continued after the inode number of its last entry, while files are unlinked and the index is compacted,
+ * shows every remaining file once and no unlinked one
+ */
+static void testDirIndex(struct procfuse *pf){
+	struct procfuse_dirindex *index = NULL;
+	struct procfuse_hashnode *node = NULL;
+	char path[64];
+	int listed[100];
+	fuse_ino_t last = 0;
+	size_t i = 0;
+	int f = 0;
+
+	memset(listed, 0, sizeof(listed));
+	for(f=0;f<100;f++){
+		snprintf(path, sizeof(path), "/index/file%d", f);
+		procfuse_createPOD_i(pf, path, O_RDWR, NULL);
+	}
+
+	/* the first 25 entries, then every file from 20 on is unlinked, the listing continues after an unlinked one */
+	pthread_rwlock_rdlock(&pf->lock);
+	index = &procfuse_pathToNode(pf, "/index", PROCFUSE_NO)->index;
+	for(i=procfuse_dirIndexSeek(index, 0);i<index->count && i<25;i++){
+		node = index->entries[i].node;
+		listed[atoi(node->key->name+4)]++;
+		last = index->entries[i].ino;
+	}
+	pthread_rwlock_unlock(&pf->lock);
+
+	for(f=20;f<100;f++){
+		snprintf(path, sizeof(path), "/index/file%d", f);
+		procfuse_unlink(pf, path);
+	}
+
+	pthread_rwlock_rdlock(&pf->lock);
+	if(index->count-index->removed!=20){
+		fail("entries left", "/index", (int)(index->count-index->removed));
+	}
+	for(i=procfuse_dirIndexSeek(index, last);i<index->count;i++){
+		if(index->entries[i].ino<=last){
+			fail("seek after compaction", "/index", (int)i);
+		}
+		node = index->entries[i].node;
+		if(node!=NULL){
+			listed[atoi(node->key->name+4)]++;
+		}
+	}
+	pthread_rwlock_unlock(&pf->lock);
+
+	for(f=0;f<100;f++){
+		if(listed[f]!=((f<25) ? 1 : 0)){
+			snprintf(path, sizeof(path), "/index/file%d", f);
+			fail("listed", path, listed[f]);
+		}
+	}
+
+	for(f=0;f<20;f++){
+		snprintf(path, sizeof(path), "/index/file%d", f);
+		procfuse_unlink(pf, path);
+	}
+	/* the empty directory is removed with its index */
+	if(procfuse_exists(pf, "/index")){
+		fail("exists after unlinking its files", "/index", 1);
+	}
+}
+
+static int readNothing(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	(void)pf; (void)path; (void)buffer; (void)size; (void)offset; (void)tid; (void)appdata;
+	return 0;
+}
+/* creates a file, which needs pf->lock exclusively */
+static off_t sizeCreatingFile(const struct procfuse *pf, const char *path, const void* appdata){
+	(void)path; (void)appdata;
+	return procfuse_createPOD_i((struct procfuse *)pf, "/sized/created", O_RDWR, NULL) ? 42 : -1;
+}
+
+/* the size reported by the application is asked for after pf->lock is released, like getattr and lookup do */
+static void testAppSize(struct procfuse *pf){
+	struct procfuse_accessor access;
+	struct procfuse_hashnode *sized = NULL;
+	struct stat st;
+
+	access = procfuse_accessor(NULL, NULL, readNothing, NULL, NULL);
+	access.onFuseSize = sizeCreatingFile;
+	procfuse_create(pf, "/sized/file", access);
+
+	pthread_rwlock_rdlock(&pf->lock);
+	procfuse_fillStat(procfuse_pathToNode(pf, "/sized/file", PROCFUSE_NO), &st);
+	sized = procfuse_pinAppSize(procfuse_pathToNode(pf, "/sized/file", PROCFUSE_NO));
+	pthread_rwlock_unlock(&pf->lock);
+	procfuse_fillAppSize(pf, sized, &st);
+
+	if(sized==NULL || st.st_size!=42 || !procfuse_exists(pf, "/sized/created")){
+		fail("size reported by the application", "/sized/file", (int)st.st_size);
+	}
+	procfuse_unlink(pf, "/sized/created");
+	procfuse_unlink(pf, "/sized/file");
+}
+
+/* the binary view starts with the magic in native byte order and holds one entry per POD */
+static void testBinaryView(struct procfuse *pf){
+	struct procfuse_binaryheader header;
+	struct procfuse_binaryentry entry;
+	char buf[4096];
+	int rval = 0;
+	int32_t value = 0;
+
+	procfuse_createPOD_i(pf, "/view/pod", O_RDWR, NULL);
+	procfuse_writePOD_i(pf, "/view/pod", -17);
+	procfuse_setBinaryView(pf, "/view", PROCFUSE_YES);
+
+	rval = readPath(pf, "/view/" PROCFUSE_BINARY_FILE, buf, sizeof(buf));
+	if(rval<(int)sizeof(header)){
+		fail("read of the binary view", "/view/" PROCFUSE_BINARY_FILE, rval);
+		return;
+	}
+	memcpy(&header, buf, sizeof(header));
+	if(header.magic!=PROCFUSE_BINARY_MAGIC || header.count!=1 || header.values+sizeof(value)>(size_t)rval){
+		fail("header of the binary view", "/view/" PROCFUSE_BINARY_FILE, (int)header.magic);
+		return;
+	}
+	memcpy(&entry, buf+sizeof(header), sizeof(entry));
+	memcpy(&value, buf+header.values+entry.offset, sizeof(value));
+	if(strcmp(buf+header.names+entry.name, "pod")!=0 || entry.type!=PROCFUSE_FIELD_INT || value!=-17){
+		fail("entry of the binary view", "/view/pod", value);
+	}
+
+	procfuse_setBinaryView(pf, "/view", PROCFUSE_NO);
+	procfuse_unlink(pf, "/view/pod");
+}
+
+/* writes to a path, returns what the write returned */
+static int writePath(struct procfuse *pf, const char *path, const char *text, off_t offset){
+	struct fuse_file_info fi;
+	int rval = 0;
+
+	rval = openPath(pf, path, O_WRONLY, &fi);
+	if(rval<0){
+		return rval;
+	}
+	rval = procfuse_writeFileHandle(pf, &fi, text, strlen(text), offset);
+	procfuse_closeFileHandle(pf, &fi);
+	return rval;
+}
+
+/* one element per line, writes start at a line and stop at the first bad one */
+static void testArrayWrites(struct procfuse *pf){
+	char buf[256];
+	int values[4];
+	int rval = 0, i = 0;
+
+	if(procfuse_createPODArray_i(pf, "/array", O_RDWR, (size_t)-1)){
+		fail("create with a length which can't be addressed", "/array", 1);
+	}
+	procfuse_createPODArray_i(pf, "/array", O_RDWR, 4);
+
+	rval = writePath(pf, "/array", "1\n2\n3\n4\n", 0);
+	readPath(pf, "/array", buf, sizeof(buf));
+	if(rval!=8 || strcmp(buf, "1\n2\n3\n4\n")!=0){
+		fail("write of all lines", "/array", rval);
+	}
+
+	/* the third line starts at offset 4 */
+	rval = writePath(pf, "/array", "-30\n", 4);
+	if(rval!=4){
+		fail("write at the start of a line", "/array", rval);
+	}
+	rval = writePath(pf, "/array", "5", 5);
+	if(rval!=-EINVAL){
+		fail("write within a line", "/array", rval);
+	}
+	rval = writePath(pf, "/array", "7\n", 100);
+	if(rval!=-EFBIG){
+		fail("write after the end", "/array", rval);
+	}
+
+	/* the line before the bad one is stored, the others aren't */
+	rval = writePath(pf, "/array", "10\nabc\n12\n", 0);
+	if(rval!=3){
+		fail("write with a bad line", "/array", rval);
+	}
+	/* lines past the last element aren't written, the last line starts at offset 9 now */
+	rval = writePath(pf, "/array", "40\n50\n", 9);
+	if(rval!=3){
+		fail("write past the last element", "/array", rval);
+	}
+
+	for(i=0;i<4;i++){
+		procfuse_readPODArray_i(pf, "/array", i, &values[i]);
+	}
+	readPath(pf, "/array", buf, sizeof(buf));
+	if(values[0]!=10 || values[1]!=2 || values[2]!=-30 || values[3]!=40 || strcmp(buf, "10\n2\n-30\n40\n")!=0){
+		fail("elements after the writes", "/array", values[0]);
+	}
+
+	/* an array isn't replaced by a scalar, only after unlinking it the path takes one */
+	errno = 0;
+	if(procfuse_createPOD_i(pf, "/array", O_RDWR, NULL) || errno!=EEXIST){
+		fail("create of a scalar over the array", "/array", errno);
+	}
+	readPath(pf, "/array", buf, sizeof(buf));
+	if(strcmp(buf, "10\n2\n-30\n40\n")!=0){
+		fail("read of the array after the failed create", "/array", atoi(buf));
+	}
+	procfuse_unlink(pf, "/array");
+	if(!procfuse_createPOD_i(pf, "/array", O_RDWR, NULL) || !procfuse_writePOD_i(pf, "/array", 5)){
+		fail("create of a scalar after unlinking the array", "/array", errno);
+	}
+	readPath(pf, "/array", buf, sizeof(buf));
+	if(strcmp(buf, "5")!=0 && strcmp(buf, "5\n")!=0){
+		fail("read of the new scalar", "/array", atoi(buf));
+	}
+	procfuse_unlink(pf, "/array");
+}
+
+struct settings{
+	int count;
+	double ratio;
+	char mode;
+};
+
+/* "name=value" lines change the fields, a write with any bad line changes none of them */
+static void testRecordWrites(struct procfuse *pf){
+	static const struct procfuse_field fields[] = {
+		{"count", PROCFUSE_FIELD_INT, offsetof(struct settings, count)},
+		{"ratio", PROCFUSE_FIELD_DOUBLE, offsetof(struct settings, ratio)},
+		{"mode", PROCFUSE_FIELD_CHAR, offsetof(struct settings, mode)}
+	};
+	static const char *bad[] = {
+		"count=7\nspeed=3\n",
+		"count=7\nratio=fast\n",
+		"count=7 8\n",
+		"count=7\nmode=\n",
+		"count 7\n"
+	};
+	struct settings settings = {1, 0.5, 'a'};
+	struct procfuse_podhandle *handle = NULL;
+	char buf[256];
+	size_t i = 0;
+	int rval = 0;
+
+	procfuse_createRecord(pf, "/record", O_RDWR, fields, 3, &settings);
+	readPath(pf, "/record", buf, sizeof(buf));
+	if(strcmp(buf, "count 1\nratio 0.5\nmode a\n")!=0){
+		fail("read of the fields", "/record", 0);
+	}
+
+	/* fields may come in any order, blank lines and trailing blanks are fine */
+	rval = writePath(pf, "/record", "mode=b\n\ncount=-12  \nratio=2.25", 0);
+	readPath(pf, "/record", buf, sizeof(buf));
+	if(rval!=30 || settings.count!=-12 || settings.ratio!=2.25 || settings.mode!='b' ||
+	   strcmp(buf, "count -12\nratio 2.25\nmode b\n")!=0){
+		fail("write of name=value lines", "/record", rval);
+	}
+
+	for(i=0;i<sizeof(bad)/sizeof(bad[0]);i++){
+		rval = writePath(pf, "/record", bad[i], 0);
+		if(rval!=-EINVAL || settings.count!=-12){
+			fail("write with a bad line", bad[i], rval);
+		}
+	}
+	/* the rest of a record can't be checked together with its start */
+	rval = writePath(pf, "/record", "count=3\n", 10);
+	if(rval!=-EINVAL || settings.count!=-12){
+		fail("write at a nonzero offset", "/record", rval);
+	}
+
+	/* readers see the changes of the application once it unlocks the record */
+	handle = procfuse_openPODHandle(pf, "/record");
+	procfuse_lockRecord(handle);
+	settings.count = 99;
+	procfuse_unlockRecord(handle);
+	procfuse_closePODHandle(handle);
+	readPath(pf, "/record", buf, sizeof(buf));
+	if(strcmp(buf, "count 99\nratio 2.25\nmode b\n")!=0){
+		fail("read after a change of the application", "/record", 0);
+	}
+
+	procfuse_unlink(pf, "/record");
+}
+
+/* counts a lookup of path by the kernel like the lookup callback of the low-level backend does, returns its inode */
+static fuse_ino_t lookupPath(struct procfuse *pf, const char *path){
+	struct procfuse_hashnode *node = NULL;
+	fuse_ino_t ino = 0;
+
+	pthread_rwlock_rdlock(&pf->lock);
+	node = procfuse_pathToNode(pf, path, PROCFUSE_NO);
+	if(node!=NULL){
+		ino = node->ino;
+		__sync_fetch_and_add(&node->nlookup, 1);
+	}
+	pthread_rwlock_unlock(&pf->lock);
+	return ino;
+}
+
+static int inodeExists(struct procfuse *pf, fuse_ino_t ino){
+	int rval = 0;
+
+	pthread_rwlock_rdlock(&pf->lock);
+	rval = (procfuse_inoToNode(pf, ino)!=NULL);
+	pthread_rwlock_unlock(&pf->lock);
+	return rval;
+}
+
+/* an inode stays valid while the kernel references it, even after its file is unlinked, and is gone after the last
+ * forget or the last close, whichever comes later
+ */
+static void testInodes(struct procfuse *pf){
+	struct procfuse_hashnode *node = NULL;
+	struct fuse_file_info fi;
+	fuse_ino_t ino = 0, other = 0, more = 0, again = 0;
+	char buf[64];
+	int rval = 0;
+
+	procfuse_createPOD_i(pf, "/inodes/kept", O_RDWR, NULL);
+	procfuse_createPOD_i(pf, "/inodes/gone", O_RDWR, NULL);
+	ino = lookupPath(pf, "/inodes/kept");
+	other = lookupPath(pf, "/inodes/gone");
+	if(ino==0 || ino==FUSE_ROOT_ID || other==ino){
+		fail("inode numbers", "/inodes/kept", (int)ino);
+	}
+
+	/* a file keeps its inode while others come and go, a file created again gets a new one */
+	procfuse_createPOD_i(pf, "/inodes/more", O_RDWR, NULL);
+	more = lookupPath(pf, "/inodes/more");
+	procfuse_unlink(pf, "/inodes/more");
+	procfuse_forgetInode(pf, more, 1);
+	procfuse_createPOD_i(pf, "/inodes/more", O_RDWR, NULL);
+	again = lookupPath(pf, "/inodes/more");
+	if(again==more){
+		fail("inode of a file created again", "/inodes/more", (int)again);
+	}
+	procfuse_unlink(pf, "/inodes/more");
+	procfuse_forgetInode(pf, again, 1);
+	pthread_rwlock_rdlock(&pf->lock);
+	node = procfuse_inoToNode(pf, ino);
+	pthread_rwlock_unlock(&pf->lock);
+	if(node==NULL || lookupPath(pf, "/inodes/kept")!=ino || strcmp(node->absolutepath, "/inodes/kept")!=0){
+		fail("inode of a file after other changes", "/inodes/kept", 0);
+	}
+	/* forgetting a file which is still in the tree doesn't remove its inode */
+	procfuse_forgetInode(pf, ino, 2);
+	if(!inodeExists(pf, ino) || node->nlookup!=0){
+		fail("forget of a file in the tree", "/inodes/kept", 0);
+	}
+
+	/* an unlinked file is found by its inode until the kernel forgets it, but it can't be opened anymore */
+	lookupPath(pf, "/inodes/gone");
+	procfuse_unlink(pf, "/inodes/gone");
+	if(procfuse_pathToNode(pf, "/inodes/gone", PROCFUSE_NO)!=NULL){
+		fail("path of an unlinked file", "/inodes/gone", 0);
+	}
+	node = procfuse_acquireAccessToInode(pf, other);
+	if(node==NULL){
+		fail("access to an unlinked inode", "/inodes/gone", 0);
+	}
+	else{
+		procfuse_releaseAccessToNode(pf, node);
+	}
+	memset(&fi, 0, sizeof(fi));
+	fi.flags = O_RDONLY;
+	rval = procfuse_openFileHandle(pf, procfuse_acquireAccessToInode(pf, other), &fi);
+	if(rval!=-ENOENT){
+		fail("open of an unlinked inode", "/inodes/gone", rval);
+	}
+	procfuse_forgetInode(pf, other, 1);
+	if(!inodeExists(pf, other)){
+		fail("inode after the first of two forgets", "/inodes/gone", 0);
+	}
+	procfuse_forgetInode(pf, other, 1);
+	if(inodeExists(pf, other) || procfuse_acquireAccessToInode(pf, other)!=NULL){
+		fail("inode after the last forget", "/inodes/gone", 0);
+	}
+
+	/* a file open while it's unlinked and forgotten keeps its inode until the close */
+	procfuse_createPOD_i(pf, "/inodes/open", O_RDWR, NULL);
+	procfuse_writePOD_i(pf, "/inodes/open", 3);
+	other = lookupPath(pf, "/inodes/open");
+	openPath(pf, "/inodes/open", O_RDONLY, &fi);
+	procfuse_unlink(pf, "/inodes/open");
+	procfuse_forgetInode(pf, other, 1);
+	if(!inodeExists(pf, other)){
+		fail("inode of an open file after the forget", "/inodes/open", 0);
+	}
+	rval = procfuse_readFileHandle(pf, &fi, buf, sizeof(buf)-1, 0);
+	buf[(rval>0) ? rval : 0] = '\0';
+	if(atoi(buf)!=3){
+		fail("read of a forgotten open file", "/inodes/open", rval);
+	}
+	procfuse_closeFileHandle(pf, &fi);
+	if(inodeExists(pf, other)){
+		fail("inode after the last close", "/inodes/open", 0);
+	}
+
+	/* without a lookup the inode goes with the unlink */
+	procfuse_unlink(pf, "/inodes/kept");
+	if(inodeExists(pf, ino)){
+		fail("inode of an unlinked file the kernel forgot", "/inodes/kept", 0);
+	}
+}
+
+int main(void){
+	struct procfuse *pf = NULL;
+
+	pf = procfuse_ctor("test-procfuse", "/tmp", NULL, NULL);
+	if(pf==NULL){
+		printf("procfuse_ctor failed: %s\n", strerror(errno));
+		return 1;
+	}
+
+	testCreateOverUnlinked(pf);
+	testPODHandle(pf);
+	testWriteTransaction(pf);
+	testDirIndex(pf);
+	testAppSize(pf);
+	testBinaryView(pf);
+	testArrayWrites(pf);
+	testRecordWrites(pf);
+	testInodes(pf);
+
+	printf("%ld failures\n", failures);
+
+	return (failures==0) ? 0 : 1;
+}
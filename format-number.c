@@ -0,0 +1,573 @@
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Decimal conversion of numbers */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "format-number.h"
+
+/* the pairs 00 to 99, integers are written two digits per division */
+static const char format_digit_pairs[201] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const uint64_t format_powers10[20] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+	100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+	10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/* number of decimal digits of value, 1 for 0 */
+static unsigned int format_decimal_length(uint64_t value)
+{
+	unsigned int t;
+
+	/* powers of ten above 1 are even, so setting the lowest bit doesn't change the length */
+	value |= 1;
+
+	/* 1233/4096 is a little more than log10(2) */
+	t = ((64 - __builtin_clzll(value)) * 1233) >> 12;
+
+	return t + 1 - (value < format_powers10[t]);
+}
+
+/* writes the digits of value so that the last one is right before end */
+static void format_write_digits(uint64_t value, char *end)
+{
+	unsigned int pair;
+
+	while (value >= 100) {
+		pair = (unsigned int) (value % 100) * 2;
+		value /= 100;
+		end -= 2;
+		end[0] = format_digit_pairs[pair];
+		end[1] = format_digit_pairs[pair + 1];
+	}
+	if (value >= 10) {
+		pair = (unsigned int) value * 2;
+		end -= 2;
+		end[0] = format_digit_pairs[pair];
+		end[1] = format_digit_pairs[pair + 1];
+	} else {
+		end[-1] = (char) ('0' + value);
+	}
+}
+
+size_t format_uint64(uint64_t value, char *buffer)
+{
+	unsigned int length;
+
+	length = format_decimal_length(value);
+	format_write_digits(value, buffer + length);
+	buffer[length] = '\0';
+
+	return length;
+}
+
+size_t format_int64(int64_t value, char *buffer)
+{
+	if (value < 0) {
+		buffer[0] = '-';
+		/* negated unsigned, INT64_MIN has no positive counterpart */
+		return format_uint64(0 - (uint64_t) value, buffer + 1) + 1;
+	}
+
+	return format_uint64((uint64_t) value, buffer);
+}
+
+size_t format_int32(int32_t value, char *buffer)
+{
+	return format_int64(value, buffer);
+}
+
+/* Shortest round trip floating point output, following "Ryu: fast
+ * float-to-string conversion" by Ulf Adams, PLDI 2018.
+ *
+ * The rounding interval of a binary value is scaled by a power of five
+ * with 125 significant bits, which is exact enough to decide every digit
+ * without multiple precision arithmetic. Instead of shipping the tables of
+ * these powers as constants they are computed once at first use.
+ */
+
+#define FORMAT_POW5_INV_BITCOUNT 125
+#define FORMAT_POW5_BITCOUNT 125
+#define FORMAT_POW5_INV_TABLE_SIZE 342
+#define FORMAT_POW5_TABLE_SIZE 326
+
+/* enough 32 bit words for 2*5^341 */
+#define FORMAT_BIGNUM_WORDS 28
+
+/* 2^k/5^i and 5^i/2^k with 125 significant bits, the low half first */
+static uint64_t format_pow5_inv_split[FORMAT_POW5_INV_TABLE_SIZE][2];
+static uint64_t format_pow5_split[FORMAT_POW5_TABLE_SIZE][2];
+static pthread_once_t format_tables_once = PTHREAD_ONCE_INIT;
+
+static unsigned int format_bignum_length(const uint32_t *words, unsigned int count)
+{
+	while (count > 0 && words[count - 1] == 0) {
+		--count;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	return (count - 1) * 32 + (32 - __builtin_clz(words[count - 1]));
+}
+
+/* the 128 bits of words starting at bit shift, bits below bit 0 are zero */
+static void format_bignum_bits(const uint32_t *words, unsigned int count, int shift, uint64_t result[2])
+{
+	unsigned int i;
+	int bit;
+
+	result[0] = 0;
+	result[1] = 0;
+	for (i = 0; i < 128; ++i) {
+		bit = shift + (int) i;
+		if (bit >= 0 && (unsigned int) bit < count * 32 && ((words[bit >> 5] >> (bit & 31)) & 1) != 0) {
+			result[i >> 6] |= (uint64_t) 1 << (i & 63);
+		}
+	}
+}
+
+static int format_bignum_less(const uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	while (count-- > 0) {
+		if (a[count] != b[count]) {
+			return a[count] < b[count];
+		}
+	}
+
+	return 0;
+}
+
+static void format_bignum_sub(uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	unsigned int i;
+	uint64_t borrow = 0, difference;
+
+	for (i = 0; i < count; ++i) {
+		difference = (uint64_t) a[i] - b[i] - borrow;
+		a[i] = (uint32_t) difference;
+		borrow = (difference >> 32) & 1;
+	}
+}
+
+static void format_bignum_shl1(uint32_t *a, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = count - 1; i > 0; --i) {
+		a[i] = (a[i] << 1) | (a[i - 1] >> 31);
+	}
+	a[0] <<= 1;
+}
+
+static void format_init_tables(void)
+{
+	uint32_t pow5[FORMAT_BIGNUM_WORDS];
+	uint32_t remainder[FORMAT_BIGNUM_WORDS];
+	uint64_t carry, quotient[2];
+	unsigned int i, s, w, length, count;
+
+	memset(pow5, 0, sizeof(pow5));
+	pow5[0] = 1;
+
+	for (i = 0; i < FORMAT_POW5_INV_TABLE_SIZE; ++i) {
+		length = format_bignum_length(pow5, FORMAT_BIGNUM_WORDS);
+		count = (length >> 5) + 2;
+
+		if (i < FORMAT_POW5_TABLE_SIZE) {
+			/* 5^i >> (length - 125) */
+			format_bignum_bits(pow5, count, (int) length - FORMAT_POW5_BITCOUNT, format_pow5_split[i]);
+		}
+
+		/* floor(2^(length - 1 + 125) / 5^i) + 1 by long division, starting at 2^(length - 1) */
+		memset(remainder, 0, sizeof(remainder));
+		remainder[(length - 1) >> 5] = (uint32_t) 1 << ((length - 1) & 31);
+		quotient[0] = 0;
+		quotient[1] = 0;
+		for (s = 0; s <= FORMAT_POW5_INV_BITCOUNT; ++s) {
+			if (s > 0) {
+				format_bignum_shl1(remainder, count);
+				quotient[1] = (quotient[1] << 1) | (quotient[0] >> 63);
+				quotient[0] <<= 1;
+			}
+			if (!format_bignum_less(remainder, pow5, count)) {
+				format_bignum_sub(remainder, pow5, count);
+				quotient[0] |= 1;
+			}
+		}
+		quotient[0] += 1;
+		quotient[1] += (quotient[0] == 0);
+		format_pow5_inv_split[i][0] = quotient[0];
+		format_pow5_inv_split[i][1] = quotient[1];
+
+		carry = 0;
+		for (w = 0; w < FORMAT_BIGNUM_WORDS; ++w) {
+			carry += (uint64_t) pow5[w] * 5;
+			pow5[w] = (uint32_t) carry;
+			carry >>= 32;
+		}
+	}
+}
+
+/* ceil(log2(5^e)), 1 for e == 0 */
+static int32_t format_pow5_bits(int32_t e)
+{
+	return (int32_t) (((uint32_t) e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) */
+static uint32_t format_log10_pow2(int32_t e)
+{
+	return ((uint32_t) e * 78913) >> 18;
+}
+
+/* floor(log10(5^e)) */
+static uint32_t format_log10_pow5(int32_t e)
+{
+	return ((uint32_t) e * 732923) >> 20;
+}
+
+static int format_multiple_of_pow5(uint64_t value, uint32_t p)
+{
+	uint32_t count = 0;
+
+	while (value % 5 == 0) {
+		value /= 5;
+		++count;
+	}
+
+	return count >= p;
+}
+
+static int format_multiple_of_pow2(uint64_t value, uint32_t p)
+{
+	return (value & (((uint64_t) 1 << p) - 1)) == 0;
+}
+
+#if defined(__SIZEOF_INT128__)
+
+__extension__ typedef unsigned __int128 format_uint128;
+
+/* (m * mul) >> j with j >= 64 */
+static uint64_t format_mul_shift(uint64_t m, const uint64_t *mul, int32_t j)
+{
+	const format_uint128 b0 = (format_uint128) m * mul[0];
+	const format_uint128 b2 = (format_uint128) m * mul[1];
+
+	return (uint64_t) (((b0 >> 64) + b2) >> (j - 64));
+}
+
+#else
+
+static uint64_t format_umul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+	const uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+	const uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+	const uint64_t b00 = a_lo * b_lo, b01 = a_lo * b_hi;
+	const uint64_t b10 = a_hi * b_lo, b11 = a_hi * b_hi;
+	const uint64_t mid1 = b10 + (b00 >> 32);
+	const uint64_t mid2 = b01 + (uint32_t) mid1;
+
+	*high = b11 + (mid1 >> 32) + (mid2 >> 32);
+
+	return (mid2 << 32) | (uint32_t) b00;
+}
+
+/* (m * mul) >> j with 64 < j < 128 */
+static uint64_t format_mul_shift(uint64_t m, const uint64_t *mul, int32_t j)
+{
+	uint64_t high0, high1, low1, sum;
+	const uint32_t dist = (uint32_t) (j - 64);
+
+	low1 = format_umul128(m, mul[1], &high1);
+	format_umul128(m, mul[0], &high0);
+	sum = high0 + low1;
+	if (sum < high0) {
+		++high1;
+	}
+
+	return (high1 << (64 - dist)) | (sum >> dist);
+}
+
+#endif
+
+/* the shortest decimal digits, times 10^exponent, inside the rounding interval of 4*m2 * 2^e2
+ * mm_shift is 0 if the lower neighbour of the value is closer than the upper one
+ */
+static uint64_t format_shortest(uint64_t m2, int32_t e2, int mm_shift, int accept_bounds, int32_t *exponent)
+{
+	const uint64_t mv = 4 * m2;
+	uint64_t vr, vp, vm, output;
+	uint64_t vp_div10, vm_div10, vr_div10, vr_mod10;
+	int32_t e10, i, j, k, removed = 0;
+	uint32_t q;
+	int vm_trailing_zeros = 0, vr_trailing_zeros = 0, round_up = 0;
+	unsigned int last_removed = 0;
+
+	if (e2 >= 0) {
+		q = format_log10_pow2(e2) - (e2 > 3);
+		e10 = (int32_t) q;
+		k = FORMAT_POW5_INV_BITCOUNT + format_pow5_bits((int32_t) q) - 1;
+		i = -e2 + (int32_t) q + k;
+		vr = format_mul_shift(mv, format_pow5_inv_split[q], i);
+		vp = format_mul_shift(mv + 2, format_pow5_inv_split[q], i);
+		vm = format_mul_shift(mv - 1 - mm_shift, format_pow5_inv_split[q], i);
+		if (q <= 21) {
+			/* only one of mp, mv and mm can be a multiple of 5 */
+			if (mv % 5 == 0) {
+				vr_trailing_zeros = format_multiple_of_pow5(mv, q);
+			} else if (accept_bounds) {
+				vm_trailing_zeros = format_multiple_of_pow5(mv - 1 - mm_shift, q);
+			} else {
+				vp -= format_multiple_of_pow5(mv + 2, q);
+			}
+		}
+	} else {
+		q = format_log10_pow5(-e2) - (-e2 > 1);
+		e10 = (int32_t) q + e2;
+		i = -e2 - (int32_t) q;
+		k = format_pow5_bits(i) - FORMAT_POW5_BITCOUNT;
+		j = (int32_t) q - k;
+		vr = format_mul_shift(mv, format_pow5_split[i], j);
+		vp = format_mul_shift(mv + 2, format_pow5_split[i], j);
+		vm = format_mul_shift(mv - 1 - mm_shift, format_pow5_split[i], j);
+		if (q <= 1) {
+			/* mv has at least q trailing zero bits, and so does mp or mm */
+			vr_trailing_zeros = 1;
+			if (accept_bounds) {
+				vm_trailing_zeros = (mm_shift == 1);
+			} else {
+				--vp;
+			}
+		} else if (q < 63) {
+			vr_trailing_zeros = format_multiple_of_pow2(mv, q);
+		}
+	}
+
+	if (vm_trailing_zeros || vr_trailing_zeros) {
+		/* rare, the exact bounds and round half to even matter */
+		for (;;) {
+			vp_div10 = vp / 10;
+			vm_div10 = vm / 10;
+			if (vp_div10 <= vm_div10) {
+				break;
+			}
+			vr_div10 = vr / 10;
+			vr_mod10 = vr % 10;
+			vm_trailing_zeros &= (vm % 10 == 0);
+			vr_trailing_zeros &= (last_removed == 0);
+			last_removed = (unsigned int) vr_mod10;
+			vr = vr_div10;
+			vp = vp_div10;
+			vm = vm_div10;
+			++removed;
+		}
+		if (vm_trailing_zeros) {
+			while (vm % 10 == 0) {
+				vr_div10 = vr / 10;
+				vr_mod10 = vr % 10;
+				vr_trailing_zeros &= (last_removed == 0);
+				last_removed = (unsigned int) vr_mod10;
+				vr = vr_div10;
+				vp /= 10;
+				vm /= 10;
+				++removed;
+			}
+		}
+		if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+			last_removed = 4;
+		}
+		output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+	} else {
+		if (vp / 100 > vm / 100) {
+			round_up = (vr % 100) >= 50;
+			vr /= 100;
+			vp /= 100;
+			vm /= 100;
+			removed += 2;
+		}
+		for (;;) {
+			vp_div10 = vp / 10;
+			vm_div10 = vm / 10;
+			if (vp_div10 <= vm_div10) {
+				break;
+			}
+			round_up = (vr % 10) >= 5;
+			vr /= 10;
+			vp = vp_div10;
+			vm = vm_div10;
+			++removed;
+		}
+		output = vr + (vr == vm || round_up);
+	}
+
+	*exponent = e10 + removed;
+
+	return output;
+}
+
+/* lays digits * 10^exponent out like "%g" does */
+static size_t format_layout(int sign, uint64_t digits, int32_t exponent, int32_t precision, char *buffer)
+{
+	char *p = buffer;
+	unsigned int length, e;
+	int32_t scientific;
+
+	length = format_decimal_length(digits);
+	/* the exponent of the first digit */
+	scientific = exponent + (int32_t) length - 1;
+
+	if (sign) {
+		*p++ = '-';
+	}
+
+	if (scientific < -4 || scientific >= precision) {
+		format_write_digits(digits, p + length + 1);
+		p[0] = p[1];
+		if (length > 1) {
+			p[1] = '.';
+			p += length + 1;
+		} else {
+			p += 1;
+		}
+		*p++ = 'e';
+		*p++ = (scientific < 0) ? '-' : '+';
+		e = (unsigned int) ((scientific < 0) ? -scientific : scientific);
+		if (e >= 100) {
+			*p++ = (char) ('0' + e / 100);
+			e %= 100;
+		}
+		*p++ = format_digit_pairs[e * 2];
+		*p++ = format_digit_pairs[e * 2 + 1];
+	} else if (scientific < 0) {
+		*p++ = '0';
+		*p++ = '.';
+		while (++scientific < 0) {
+			*p++ = '0';
+		}
+		format_write_digits(digits, p + length);
+		p += length;
+	} else if ((int32_t) length <= scientific + 1) {
+		format_write_digits(digits, p + length);
+		p += length;
+		while ((int32_t) length++ <= scientific) {
+			*p++ = '0';
+		}
+	} else {
+		/* the integral digits are moved in front of the decimal point */
+		format_write_digits(digits, p + length + 1);
+		memmove(p, p + 1, (size_t) scientific + 1);
+		p[scientific + 1] = '.';
+		p += length + 1;
+	}
+	*p = '\0';
+
+	return (size_t) (p - buffer);
+}
+
+static size_t format_special(int sign, int nan, char *buffer)
+{
+	char *p = buffer;
+
+	if (sign) {
+		*p++ = '-';
+	}
+	memcpy(p, nan ? "nan" : "inf", 4);
+
+	return (size_t) (p - buffer) + 3;
+}
+
+size_t format_double(double value, char *buffer)
+{
+	uint64_t bits, mantissa, m2, digits;
+	uint32_t biased;
+	int32_t e2, exponent;
+	int sign;
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (int) (bits >> 63);
+	mantissa = bits & (((uint64_t) 1 << 52) - 1);
+	biased = (uint32_t) ((bits >> 52) & 0x7ff);
+
+	if (biased == 0x7ff) {
+		return format_special(sign, mantissa != 0, buffer);
+	}
+	if (biased == 0 && mantissa == 0) {
+		return format_layout(sign, 0, 0, FORMAT_DOUBLE_PRECISION, buffer);
+	}
+
+	pthread_once(&format_tables_once, format_init_tables);
+
+	if (biased == 0) {
+		e2 = 1 - 1023 - 52 - 2;
+		m2 = mantissa;
+	} else {
+		e2 = (int32_t) biased - 1023 - 52 - 2;
+		m2 = ((uint64_t) 1 << 52) | mantissa;
+	}
+
+	digits = format_shortest(m2, e2, mantissa != 0 || biased <= 1, (m2 & 1) == 0, &exponent);
+
+	return format_layout(sign, digits, exponent, FORMAT_DOUBLE_PRECISION, buffer);
+}
+
+size_t format_float(float value, char *buffer)
+{
+	uint32_t bits, mantissa, biased;
+	uint64_t m2, digits;
+	int32_t e2, exponent;
+	int sign;
+
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (int) (bits >> 31);
+	mantissa = bits & (((uint32_t) 1 << 23) - 1);
+	biased = (bits >> 23) & 0xff;
+
+	if (biased == 0xff) {
+		return format_special(sign, mantissa != 0, buffer);
+	}
+	if (biased == 0 && mantissa == 0) {
+		return format_layout(sign, 0, 0, FORMAT_FLOAT_PRECISION, buffer);
+	}
+
+	pthread_once(&format_tables_once, format_init_tables);
+
+	/* the double tables cover the exponents of floats, their precision is more than enough */
+	if (biased == 0) {
+		e2 = 1 - 127 - 23 - 2;
+		m2 = mantissa;
+	} else {
+		e2 = (int32_t) biased - 127 - 23 - 2;
+		m2 = ((uint64_t) 1 << 23) | mantissa;
+	}
+
+	digits = format_shortest(m2, e2, mantissa != 0 || biased <= 1, (m2 & 1) == 0, &exponent);
+
+	return format_layout(sign, digits, exponent, FORMAT_FLOAT_PRECISION, buffer);
+}
@@ -0,0 +1,135 @@
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file format-number.h
+ *
+ * @brief Conversion of numbers to decimal text.
+ *
+ * Integers are written exactly like printf's "%d" and "%" PRId64 write
+ * them, two digits at a time.
+ *
+ * Floating point numbers are written with the fewest significant digits
+ * which read back to the same value, the way printf's "%g" lays them out:
+ * in scientific notation if the decimal exponent is below -4 or at least
+ * @ref FORMAT_DOUBLE_PRECISION (@ref FORMAT_FLOAT_PRECISION for floats),
+ * in fixed notation otherwise. The digits are found with the Ryu
+ * algorithm, without multiple precision arithmetic.
+ *
+ * None of the functions allocate memory or depend on the locale. They
+ * may be called from several threads at once.
+ */
+
+#ifndef FORMAT_NUMBER_H_
+#define FORMAT_NUMBER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Size of a buffer which holds the text of any number written by the
+ * functions below, the terminating null byte included.
+ */
+
+#define FORMAT_NUMBER_MAX 32
+
+/**
+ * Decimal exponent from which doubles are written in scientific notation.
+ */
+
+#define FORMAT_DOUBLE_PRECISION 17
+
+/**
+ * Decimal exponent from which floats are written in scientific notation.
+ */
+
+#define FORMAT_FLOAT_PRECISION 9
+
+/**
+ * Write a 32 bit integer.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_int32(int32_t value, char *buffer);
+
+/**
+ * Write a 64 bit integer.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_int64(int64_t value, char *buffer);
+
+/**
+ * Write an unsigned 64 bit integer.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_uint64(uint64_t value, char *buffer);
+
+/**
+ * Write a double with the fewest digits which read back to it.
+ *
+ * Infinities and NaNs are written as "inf", "-inf", "nan" and "-nan".
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_double(double value, char *buffer);
+
+/**
+ * Write a float with the fewest digits which read back to it as a float.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_float(float value, char *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef FORMAT_NUMBER_H_ */
@@ -18,10 +18,29 @@ CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
  */
 
-/* Hash table implementation */
+/* Hash table implementation
+ *
+ * Open addressing: keys and values are stored in one array of slots and
+ * a parallel array holds one control byte per slot.  A control byte is
+ * either empty, deleted, or holds 7 bits of the hash of the key in its
+ * slot.  The slots are probed in groups of 16: the control bytes of a
+ * group are compared against the 7 hash bits at once (with SSE2 where
+ * available), so the keys of only a few candidate slots are compared at
+ * all, and a lookup usually touches one cache line of control bytes and
+ * the one of its slot.  The number of slots is a power of two.
+ *
+ * Most tables (directories of procfuse) only ever hold a handful of
+ * entries.  These are kept in a small array inside the table structure
+ * together with their hashes and are searched linearly, the slot arrays
+ * are only allocated once the small array is full. */
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "hash-table.h"
 
@@ -31,86 +50,266 @@ CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "alloc-testing.h"
 #endif
 
+#define HASH_TABLE_GROUP_SIZE 16
+
+/* Control byte values for slots which do not hold an entry.  Both have
+ * the high bit set, while the control byte of a full slot is the 7 bit
+ * fragment of the hash of its key. */
+
+#define HASH_TABLE_CTRL_EMPTY ((signed char) -128)
+#define HASH_TABLE_CTRL_DELETED ((signed char) -2)
+
 struct _HashTableEntry {
 	HashTableKey key;
 	HashTableValue value;
-	HashTableEntry *next;
 };
 
+/* Number of entries stored in the table structure itself */
+
+#define HASH_TABLE_SMALL_SIZE 6
+
 struct _HashTable {
-	HashTableEntry **table;
-	int table_size;
+	signed char *ctrl;
+	HashTableEntry *slots;
+	unsigned int capacity; /* zero as long as the small array is used */
+	unsigned int growth_left;
 	HashTableHashFunc hash_func;
 	HashTableEqualFunc equal_func;
 	HashTableKeyFreeFunc key_free_func;
 	HashTableValueFreeFunc value_free_func;
 	int entries;
-	int prime_index;
+	HashTableEntry small[HASH_TABLE_SMALL_SIZE];
+	uint64_t small_hash[HASH_TABLE_SMALL_SIZE];
 };
 
-/* This is a set of good hash table prime numbers, from:
- *   http://planetmath.org/encyclopedia/GoodHashTablePrimes.html
- * Each prime is roughly double the previous value, and as far as
- * possible from the nearest powers of two. */
+/* Smallest number of slots, one group */
 
-static const unsigned int hash_table_primes[] = {
-	193, 389, 769, 1543, 3079, 6151, 12289, 24593, 49157, 98317,
-	196613, 393241, 786433, 1572869, 3145739, 6291469,
-	12582917, 25165843, 50331653, 100663319, 201326611,
-	402653189, 805306457, 1610612741,
-};
+#define HASH_TABLE_MIN_CAPACITY HASH_TABLE_GROUP_SIZE
+
+/* The hash functions used with this table are weak in their low bits
+ * (int_hash returns the key itself), so the hash is mixed before it is
+ * split into the group index and the 7 bit fragment. */
 
-static const int hash_table_num_primes 
-	= sizeof(hash_table_primes) / sizeof(int);
+static uint64_t hash_table_hash(HashTable *hash_table, HashTableKey key)
+{
+	uint64_t hash;
+
+	hash = (uint64_t) hash_table->hash_func(key) * 0x9E3779B97F4A7C15ULL;
 
-/* Internal function used to allocate the table on hash table creation
- * and when enlarging the table */
+	return hash ^ (hash >> 32);
+}
 
-static int hash_table_allocate_table(HashTable *hash_table)
+static signed char hash_table_h2(uint64_t hash)
 {
-	int new_table_size;
+	return (signed char) (hash & 0x7f);
+}
 
-	/* Determine the table size based on the current prime index.  
-	 * An attempt is made here to ensure sensible behavior if the
-	 * maximum prime is exceeded, but in practice other things are
-	 * likely to break long before that happens. */
+/* Bit mask of the slots in the group starting at ctrl whose control byte
+ * equals value */
 
-	if (hash_table->prime_index < hash_table_num_primes) {
-		new_table_size = hash_table_primes[hash_table->prime_index];
-	} else {
-		new_table_size = hash_table->entries * 10;
+static unsigned int hash_table_group_match(const signed char *ctrl,
+                                           signed char value)
+{
+#ifdef __SSE2__
+	__m128i group;
+
+	group = _mm_loadu_si128((const __m128i *) ctrl);
+
+	return (unsigned int) _mm_movemask_epi8(
+	           _mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+	unsigned int mask = 0;
+	int i;
+
+	for (i=0; i<HASH_TABLE_GROUP_SIZE; ++i) {
+		if (ctrl[i] == value) {
+			mask |= 1u << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+/* Bit mask of the slots in a group which are empty or deleted */
+
+static unsigned int hash_table_group_match_free(const signed char *ctrl)
+{
+#ifdef __SSE2__
+	/* The high bit is only set for empty and deleted slots */
+
+	return (unsigned int) _mm_movemask_epi8(
+	           _mm_loadu_si128((const __m128i *) ctrl));
+#else
+	unsigned int mask = 0;
+	int i;
+
+	for (i=0; i<HASH_TABLE_GROUP_SIZE; ++i) {
+		if (ctrl[i] < 0) {
+			mask |= 1u << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+static int hash_table_lowest_bit(unsigned int mask)
+{
+	return __builtin_ctz(mask);
+}
+
+/* Maximum number of full and deleted slots, 7/8 of the capacity */
+
+static unsigned int hash_table_max_load(unsigned int capacity)
+{
+	return capacity - capacity / 8;
+}
+
+/* Internal function used to allocate the arrays on hash table creation
+ * and when resizing the table */
+
+static int hash_table_allocate_table(HashTable *hash_table,
+                                     unsigned int capacity)
+{
+	signed char *ctrl;
+
+	/* The control bytes and the slots share one allocation, the slots
+	 * follow the control bytes which are a multiple of 16 */
+
+	ctrl = (signed char *) malloc(capacity
+	                              + capacity * sizeof(HashTableEntry));
+
+	if (ctrl == NULL) {
+		return 0;
+	}
+
+	memset(ctrl, HASH_TABLE_CTRL_EMPTY, capacity);
+
+	hash_table->ctrl = ctrl;
+	hash_table->slots = (HashTableEntry *) (ctrl + capacity);
+	hash_table->capacity = capacity;
+	hash_table->growth_left = hash_table_max_load(capacity);
+
+	return 1;
+}
+
+/* The entry stored at a position returned by hash_table_find */
+
+static HashTableEntry *hash_table_entry(HashTable *hash_table, long found)
+{
+	if (hash_table->capacity == 0) {
+		return &hash_table->small[found];
+	}
+
+	return &hash_table->slots[found];
+}
+
+/* Find the slot of key, or -1 if it is not in the table, for small
+ * tables the index into the small array */
+
+static long hash_table_find(HashTable *hash_table, HashTableKey key,
+                            uint64_t hash)
+{
+	unsigned int group_mask;
+	unsigned int group;
+	unsigned int probe;
+	unsigned int match;
+	unsigned int slot;
+	signed char h2;
+
+	if (hash_table->capacity == 0) {
+		for (slot=0; slot<(unsigned int) hash_table->entries; ++slot) {
+			if (hash_table->small_hash[slot] == hash
+			 && hash_table->equal_func(key,
+			        hash_table->small[slot].key) != 0) {
+				return (long) slot;
+			}
+		}
+
+		return -1;
+	}
+
+	group_mask = hash_table->capacity / HASH_TABLE_GROUP_SIZE - 1;
+	group = (unsigned int) (hash >> 7) & group_mask;
+	h2 = hash_table_h2(hash);
+
+	/* Triangular probing over the groups visits every group once, as
+	 * the number of groups is a power of two */
+
+	for (probe=1; probe<=group_mask+1; ++probe) {
+		slot = group * HASH_TABLE_GROUP_SIZE;
+
+		match = hash_table_group_match(hash_table->ctrl + slot, h2);
+
+		while (match != 0) {
+			int i = hash_table_lowest_bit(match);
+
+			if (hash_table->equal_func(key,
+			        hash_table->slots[slot + i].key) != 0) {
+				return (long) (slot + i);
+			}
+
+			match &= match - 1;
+		}
+
+		/* An empty slot ends the probe sequence, the key would have
+		 * been stored here */
+
+		if (hash_table_group_match(hash_table->ctrl + slot,
+		                           HASH_TABLE_CTRL_EMPTY) != 0) {
+			break;
+		}
+
+		group = (group + probe) & group_mask;
 	}
 
-	hash_table->table_size = new_table_size;
+	return -1;
+}
+
+/* Find a free slot for a key which is not in the table */
 
-	/* Allocate the table and initialise to NULL for all entries */
+static unsigned int hash_table_find_free(HashTable *hash_table,
+                                         uint64_t hash)
+{
+	unsigned int group_mask;
+	unsigned int group;
+	unsigned int probe;
+	unsigned int match;
+
+	group_mask = hash_table->capacity / HASH_TABLE_GROUP_SIZE - 1;
+	group = (unsigned int) (hash >> 7) & group_mask;
 
-	hash_table->table = (HashTableEntry**)calloc(hash_table->table_size,
-	                           sizeof(HashTableEntry *));
+	for (probe=1; ; ++probe) {
+		match = hash_table_group_match_free(hash_table->ctrl
+		                             + group * HASH_TABLE_GROUP_SIZE);
 
-	return hash_table->table != NULL;
+		if (match != 0) {
+			return group * HASH_TABLE_GROUP_SIZE
+			     + hash_table_lowest_bit(match);
+		}
+
+		group = (group + probe) & group_mask;
+	}
 }
 
 /* Free an entry, calling the free functions if there are any registered */
 
-static void hash_table_free_entry(HashTable *hash_table, HashTableEntry *entry)
+static void hash_table_free_entry(HashTable *hash_table, HashTableKey key,
+                                  HashTableValue value)
 {
 	/* If there is a function registered for freeing keys, use it to free
 	 * the key */
 	
 	if (hash_table->key_free_func != NULL) {
-		hash_table->key_free_func(entry->key);
+		hash_table->key_free_func(key);
 	}
 
 	/* Likewise with the value */
 
 	if (hash_table->value_free_func != NULL) {
-		hash_table->value_free_func(entry->value);
+		hash_table->value_free_func(value);
 	}
-
-	/* Free the data structure */
-	
-	free(entry);
 }
 
 HashTable *hash_table_new(HashTableHashFunc hash_func, 
@@ -131,39 +330,40 @@ HashTable *hash_table_new(HashTableHashFunc hash_func,
 	hash_table->key_free_func = NULL;
 	hash_table->value_free_func = NULL;
 	hash_table->entries = 0;
-	hash_table->prime_index = 0;
-
-	/* Allocate the table */
 
-	if (!hash_table_allocate_table(hash_table)) {
-		free(hash_table);
+	/* Start out with the small array */
 
-		return NULL;
-	}
+	hash_table->ctrl = NULL;
+	hash_table->slots = NULL;
+	hash_table->capacity = 0;
+	hash_table->growth_left = 0;
 
 	return hash_table;
 }
 
 void hash_table_free(HashTable *hash_table)
 {
-	HashTableEntry *rover;
-	HashTableEntry *next;
-	int i;
+	unsigned int i;
 	
-	/* Free all entries in all chains */
-
-	for (i=0; i<hash_table->table_size; ++i) {
-		rover = hash_table->table[i];
-		while (rover != NULL) {
-			next = rover->next;
-			hash_table_free_entry(hash_table, rover);
-			rover = next;
+	/* Free all entries */
+
+	for (i=0; i<(unsigned int) hash_table->entries
+	            && hash_table->capacity == 0; ++i) {
+		hash_table_free_entry(hash_table, hash_table->small[i].key,
+		                      hash_table->small[i].value);
+	}
+
+	for (i=0; i<hash_table->capacity; ++i) {
+		if (hash_table->ctrl[i] >= 0) {
+			hash_table_free_entry(hash_table,
+			                      hash_table->slots[i].key,
+			                      hash_table->slots[i].value);
 		}
 	}
 	
 	/* Free the table */
 
-	free(hash_table->table);
+	free(hash_table->ctrl);
 	
 	/* Free the hash table structure */
 
@@ -178,143 +378,165 @@ void hash_table_register_free_functions(HashTable *hash_table,
 	hash_table->value_free_func = value_free_func;
 }
 
+/* Move all entries into new arrays of the given capacity, this also
+ * drops all deleted slots */
 
-static int hash_table_enlarge(HashTable *hash_table)
+static int hash_table_resize(HashTable *hash_table, unsigned int capacity)
 {
-	HashTableEntry **old_table;
-	int old_table_size;
-	int old_prime_index;
-	HashTableEntry *rover;
-	HashTableEntry *next;
-	int index;
-	int i;
+	signed char *old_ctrl;
+	HashTableEntry *old_slots;
+	unsigned int old_capacity;
+	unsigned int slot;
+	unsigned int i;
+	uint64_t hash;
 	
 	/* Store a copy of the old table */
 	
-	old_table = hash_table->table;
-	old_table_size = hash_table->table_size;
-	old_prime_index = hash_table->prime_index;
-
-	/* Allocate a new, larger table */
+	old_ctrl = hash_table->ctrl;
+	old_slots = hash_table->slots;
+	old_capacity = hash_table->capacity;
 
-	++hash_table->prime_index;
-	
-	if (!hash_table_allocate_table(hash_table)) {
+	if (!hash_table_allocate_table(hash_table, capacity)) {
 
 		/* Failed to allocate the new table */
 
-		hash_table->table = old_table;
-		hash_table->table_size = old_table_size;
-		hash_table->prime_index = old_prime_index;
+		hash_table->ctrl = old_ctrl;
+		hash_table->slots = old_slots;
+		hash_table->capacity = old_capacity;
 
 		return 0;
 	}
 
-	/* Link all entries from all chains into the new table */
+	/* Insert all entries into the new table */
 
-	for (i=0; i<old_table_size; ++i) {
-		rover = old_table[i];
+	for (i=0; old_capacity == 0 && i<(unsigned int) hash_table->entries; ++i) {
+		hash = hash_table->small_hash[i];
+		slot = hash_table_find_free(hash_table, hash);
 
-		while (rover != NULL) {
-			next = rover->next;
+		hash_table->ctrl[slot] = hash_table_h2(hash);
+		hash_table->slots[slot] = hash_table->small[i];
+		--hash_table->growth_left;
+	}
 
-			/* Find the index into the new table */
-			
-			index = hash_table->hash_func(rover->key) % hash_table->table_size;
-			
-			/* Link this entry into the chain */
+	for (i=0; i<old_capacity; ++i) {
+		if (old_ctrl[i] < 0) {
+			continue;
+		}
 
-			rover->next = hash_table->table[index];
-			hash_table->table[index] = rover;
-			
-			/* Advance to next in the chain */
+		hash = hash_table_hash(hash_table, old_slots[i].key);
+		slot = hash_table_find_free(hash_table, hash);
 
-			rover = next;
-		}
+		hash_table->ctrl[slot] = hash_table_h2(hash);
+		hash_table->slots[slot] = old_slots[i];
+		--hash_table->growth_left;
 	}
 
 	/* Free the old table */
 
-	free(old_table);
+	free(old_ctrl);
        
 	return 1;
 }
 
 int hash_table_insert(HashTable *hash_table, HashTableKey key, HashTableValue value) 
 {
-	HashTableEntry *rover;
-	HashTableEntry *newentry;
-	int index;
-	
-	/* If there are too many items in the table with respect to the table
-	 * size, the number of hash collisions increases and performance
-	 * decreases. Enlarge the table size to prevent this happening */
+	HashTableEntry *entry;
+	HashTableKey old_key;
+	HashTableValue old_value;
+	unsigned int capacity;
+	unsigned int slot;
+	long found;
+	uint64_t hash;
 
-	if ((hash_table->entries * 3) / hash_table->table_size > 0) {
-		
-		/* Table is more than 1/3 full */
+	hash = hash_table_hash(hash_table, key);
 
-		if (!hash_table_enlarge(hash_table)) {
+	/* Look for an existing entry with the same key */
 
-			/* Failed to enlarge the table */
+	found = hash_table_find(hash_table, key, hash);
 
-			return 0;
-		}
-	}
+	if (found >= 0) {
 
-	/* Generate the hash of the key and hence the index into the table */
+		/* Same key: overwrite this entry with new data, the old key
+		 * and value are freed after the table is consistent again, in
+		 * case the free functions use the table */
 
-	index = hash_table->hash_func(key) % hash_table->table_size;
+		entry = hash_table_entry(hash_table, found);
+		old_key = entry->key;
+		old_value = entry->value;
 
-	/* Traverse the chain at this location and look for an existing
-	 * entry with the same key */
+		entry->key = key;
+		entry->value = value;
 
-	rover = hash_table->table[index];
+		/* If there is a value free function, free the old data */
 
-	while (rover != NULL) {
-		if (hash_table->equal_func(rover->key, key) != 0) {
-
-			/* Same key: overwrite this entry with new data */
+		if (hash_table->value_free_func != NULL) {
+			hash_table->value_free_func(old_value);
+		}
 
-			/* If there is a value free function, free the old data
-			 * before adding in the new data */
+		/* Same with the key */
 
-			if (hash_table->value_free_func != NULL) {
-				hash_table->value_free_func(rover->value);
-			}
+		if (hash_table->key_free_func != NULL) {
+			hash_table->key_free_func(old_key);
+		}
 
-			/* Same with the key: use the new key value and free 
-			 * the old one */
+		/* Finished */
+			
+		return 1;
+	}
 
-			if (hash_table->key_free_func != NULL) {
-				hash_table->key_free_func(rover->key);
-			}
+	/* Not in the hash table yet.  Append it to the small array while
+	 * there is room, or move all entries into slot arrays */
 
-			rover->key = key;
-			rover->value = value;
+	if (hash_table->capacity == 0) {
+		if (hash_table->entries < HASH_TABLE_SMALL_SIZE) {
+			hash_table->small[hash_table->entries].key = key;
+			hash_table->small[hash_table->entries].value = value;
+			hash_table->small_hash[hash_table->entries] = hash;
+			++hash_table->entries;
 
-			/* Finished */
-			
 			return 1;
 		}
-		rover = rover->next;
+
+		if (!hash_table_resize(hash_table, HASH_TABLE_MIN_CAPACITY)) {
+			return 0;
+		}
 	}
-	
-	/* Not in the hash table yet.  Create a new entry */
 
-	newentry = (HashTableEntry *) malloc(sizeof(HashTableEntry));
+	/* If there are no more slots left which may be used without
+	 * overloading the table, clean out the deleted slots or enlarge
+	 * the table */
 
-	if (newentry == NULL) {
-		return 0;
+	slot = hash_table_find_free(hash_table, hash);
+
+	if (hash_table->growth_left == 0
+	 && hash_table->ctrl[slot] == HASH_TABLE_CTRL_EMPTY) {
+
+		capacity = hash_table->capacity;
+
+		if ((unsigned int) hash_table->entries * 2
+		      >= hash_table_max_load(capacity)) {
+			capacity *= 2;
+		}
+
+		if (!hash_table_resize(hash_table, capacity)) {
+
+			/* Failed to enlarge the table */
+
+			return 0;
+		}
+
+		slot = hash_table_find_free(hash_table, hash);
 	}
 
-	newentry->key = key;
-	newentry->value = value;
+	/* Taking an empty slot uses up room, reusing a deleted one not */
 
-	/* Link into the list */
+	if (hash_table->ctrl[slot] == HASH_TABLE_CTRL_EMPTY) {
+		--hash_table->growth_left;
+	}
 
-	newentry->next = hash_table->table[index];
-	hash_table->table[index] = newentry;
+	hash_table->ctrl[slot] = hash_table_h2(hash);
+	hash_table->slots[slot].key = key;
+	hash_table->slots[slot].value = value;
 
 	/* Maintain the count of the number of entries */
 
@@ -327,83 +549,78 @@ int hash_table_insert(HashTable *hash_table, HashTableKey key, HashTableValue va
 
 HashTableValue hash_table_lookup(HashTable *hash_table, HashTableKey key)
 {
-	HashTableEntry *rover;
-	int index;
+	long found;
 
-	/* Generate the hash of the key and hence the index into the table */
-	
-	index = hash_table->hash_func(key) % hash_table->table_size;
-
-	/* Walk the chain at this index until the corresponding entry is
-	 * found */
-
-	rover = hash_table->table[index];
+	found = hash_table_find(hash_table, key,
+	                        hash_table_hash(hash_table, key));
 
-	while (rover != NULL) {
-		if (hash_table->equal_func(key, rover->key) != 0) {
+	if (found < 0) {
 
-			/* Found the entry.  Return the data. */
+		/* Not found */
 
-			return rover->value;
-		}
-		rover = rover->next;
+		return HASH_TABLE_NULL;
 	}
 
-	/* Not found */
-
-	return HASH_TABLE_NULL;
+	return hash_table_entry(hash_table, found)->value;
 }
 
 int hash_table_remove(HashTable *hash_table, HashTableKey key)
 {
-	HashTableEntry **rover;
-	HashTableEntry *entry;
-	int index;
-	int result;
+	HashTableKey old_key;
+	HashTableValue old_value;
+	unsigned int group;
+	long found;
+	int last;
 
-	/* Generate the hash of the key and hence the index into the table */
-	
-	index = hash_table->hash_func(key) % hash_table->table_size;
+	found = hash_table_find(hash_table, key,
+	                        hash_table_hash(hash_table, key));
 
-	/* Rover points at the pointer which points at the current entry
-	 * in the chain being inspected.  ie. the entry in the table, or
-	 * the "next" pointer of the previous entry in the chain.  This
-	 * allows us to unlink the entry when we find it. */
+	if (found < 0) {
+		return 0;
+	}
 
-	result = 0;
-	rover = &hash_table->table[index];
+	old_key = hash_table_entry(hash_table, found)->key;
+	old_value = hash_table_entry(hash_table, found)->value;
 
-	while (*rover != NULL) {
+	if (hash_table->capacity == 0) {
 
-		if (hash_table->equal_func(key, (*rover)->key) != 0) {
+		/* Keep the small array without gaps */
 
-			/* This is the entry to remove */
+		last = hash_table->entries - 1;
+		hash_table->small[found] = hash_table->small[last];
+		hash_table->small_hash[found] = hash_table->small_hash[last];
 
-			entry = *rover;
+		--hash_table->entries;
 
-			/* Unlink from the list */
+		hash_table_free_entry(hash_table, old_key, old_value);
 
-			*rover = entry->next;
+		return 1;
+	}
 
-			/* Destroy the entry structure */
+	/* If the group of the slot has an empty slot, no probe sequence
+	 * went past this group and the slot can become empty again.
+	 * Otherwise it has to be marked deleted to keep later keys of
+	 * probe sequences running through this group reachable. */
 
-			hash_table_free_entry(hash_table, entry);
+	group = (unsigned int) found & ~(HASH_TABLE_GROUP_SIZE - 1u);
 
-			/* Track count of entries */
+	if (hash_table_group_match(hash_table->ctrl + group,
+	                           HASH_TABLE_CTRL_EMPTY) != 0) {
+		hash_table->ctrl[found] = HASH_TABLE_CTRL_EMPTY;
+		++hash_table->growth_left;
+	} else {
+		hash_table->ctrl[found] = HASH_TABLE_CTRL_DELETED;
+	}
 
-			--hash_table->entries;
+	/* Track count of entries */
 
-			result = 1;
+	--hash_table->entries;
 
-			break;
-		}
-		
-		/* Advance to the next entry */
+	/* Destroy the entry */
 
-		rover = &((*rover)->next);
-	}
+	hash_table_free_entry(hash_table, old_key, old_value);
 
-	return result;
+	return 1;
 }
 
 int hash_table_num_entries(HashTable *hash_table)
@@ -413,86 +630,63 @@ int hash_table_num_entries(HashTable *hash_table)
 
 void hash_table_iterate(HashTable *hash_table, HashTableIterator *iterator)
 {
-	int chain;
-	
 	iterator->hash_table = hash_table;
+	iterator->next_slot = 0;
 
-	/* Default value of next if no entries are found. */
-	
-	iterator->next_entry = NULL;
-	
 	/* Find the first entry */
-	
-	for (chain=0; chain<hash_table->table_size; ++chain) {
-		
-		if (hash_table->table[chain] != NULL) {
-			iterator->next_entry = hash_table->table[chain];
-			iterator->next_chain = chain;
-			break;
-		}
+
+	while (iterator->next_slot < hash_table->capacity
+	    && hash_table->ctrl[iterator->next_slot] < 0) {
+		++iterator->next_slot;
 	}
 }
 
 int hash_table_iter_has_more(HashTableIterator *iterator)
 {
-	return iterator->next_entry != NULL;
+	HashTable *hash_table = iterator->hash_table;
+
+	if (hash_table->capacity == 0) {
+		return iterator->next_slot < (unsigned int) hash_table->entries;
+	}
+
+	return iterator->next_slot < hash_table->capacity;
 }
 
 HashTableValue hash_table_iter_next(HashTableIterator *iterator)
 {
-	HashTableEntry *current_entry;
 	HashTable *hash_table;
 	HashTableValue result;
-	int chain;
 
 	hash_table = iterator->hash_table;
 
+	/* Small array: entries are stored without gaps */
+
+	if (hash_table->capacity == 0) {
+		if (iterator->next_slot >= (unsigned int) hash_table->entries) {
+			return HASH_TABLE_NULL;
+		}
+
+		return hash_table->small[iterator->next_slot++].value;
+	}
+
 	/* No more entries? */
 	
-	if (iterator->next_entry == NULL) {
+	if (iterator->next_slot >= hash_table->capacity) {
 		return HASH_TABLE_NULL;
 	}
 	
 	/* Result is immediately available */
 
-	current_entry = iterator->next_entry;
-	result = current_entry->value;
+	result = hash_table->slots[iterator->next_slot].value;
 
 	/* Find the next entry */
 
-	if (current_entry->next != NULL) {
-		
-		/* Next entry in current chain */
+	++iterator->next_slot;
 
-		iterator->next_entry = current_entry->next;
-		
-	} else {
-	
-		/* None left in this chain, so advance to the next chain */
-
-		chain = iterator->next_chain + 1;
-
-		/* Default value if no next chain found */
-		
-		iterator->next_entry = NULL;
-
-		while (chain < hash_table->table_size) {
-
-			/* Is there anything in this chain? */
-
-			if (hash_table->table[chain] != NULL) {
-				iterator->next_entry = hash_table->table[chain];
-				break;
-			}
-
-			/* Try the next chain */
-
-			++chain;
-		}
-
-		iterator->next_chain = chain;
+	while (iterator->next_slot < hash_table->capacity
+	    && hash_table->ctrl[iterator->next_slot] < 0) {
+		++iterator->next_slot;
 	}
 
 	return result;
 }
-
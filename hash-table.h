@@ -85,8 +85,7 @@ typedef void *HashTableValue;
 
 struct _HashTableIterator {
 	HashTable *hash_table;
-	HashTableEntry *next_entry;
-	int next_chain;
+	unsigned int next_slot;
 };
 
 /**
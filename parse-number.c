@@ -0,0 +1,702 @@
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Decimal parsing of numbers */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <pthread.h>
+
+#include "parse-number.h"
+
+/* eight digits are checked and converted at once where a uint64_t holds them in reading order */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PARSE_SWAR 1
+#endif
+
+/* floating point operations are rounded to their type, so exact operands give a correctly rounded result */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define PARSE_EXACT_ARITHMETIC 1
+#endif
+
+static int parse_is_digit(char c)
+{
+	return (unsigned char) (c - '0') < 10;
+}
+
+#ifdef PARSE_SWAR
+
+static uint64_t parse_load8(const char *p)
+{
+	uint64_t value;
+
+	memcpy(&value, p, sizeof(value));
+
+	return value;
+}
+
+static int parse_is_eight_digits(uint64_t value)
+{
+	return ((value & 0xF0F0F0F0F0F0F0F0ULL) |
+	        (((value + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+/* the value of eight digits, combined pairwise into 2, 4 and 8 digit numbers */
+static uint32_t parse_eight_digits(uint64_t value)
+{
+	const uint64_t mask = 0x000000FF000000FFULL;
+	const uint64_t mul1 = 100 + (1000000ULL << 32);
+	const uint64_t mul2 = 1 + (10000ULL << 32);
+
+	value -= 0x3030303030303030ULL;
+	value = (value * 10) + (value >> 8);
+
+	return (uint32_t) ((((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32);
+}
+
+#endif
+
+/* the digits at first as an unsigned number, ERANGE if it's above limit */
+static int parse_magnitude(const char *first, const char *last, uint64_t limit, uint64_t *value, const char **end)
+{
+	const char *p = first, *significant;
+	uint64_t result = 0;
+	unsigned int digit;
+	int overflow = 0;
+
+	while (p != last && *p == '0') {
+		++p;
+	}
+	significant = p;
+
+#ifdef PARSE_SWAR
+	/* up to 19 digits fit into a uint64_t */
+	while (last - p >= 8 && p - significant <= 11 && parse_is_eight_digits(parse_load8(p))) {
+		result = result * 100000000 + parse_eight_digits(parse_load8(p));
+		p += 8;
+	}
+#endif
+	while (p != last && parse_is_digit(*p) && p - significant < 19) {
+		result = result * 10 + (uint64_t) (*p - '0');
+		++p;
+	}
+	while (p != last && parse_is_digit(*p)) {
+		digit = (unsigned int) (*p - '0');
+		if (result > (UINT64_MAX - digit) / 10) {
+			overflow = 1;
+		} else {
+			result = result * 10 + digit;
+		}
+		++p;
+	}
+
+	if (p == first) {
+		return EINVAL;
+	}
+
+	*end = p;
+	if (overflow || result > limit) {
+		return ERANGE;
+	}
+	*value = result;
+
+	return 0;
+}
+
+int parse_int64(const char *first, const char *last, int64_t *value, const char **end)
+{
+	const char *p = first, *digits_end = first;
+	uint64_t magnitude = 0;
+	int negative = 0, rval;
+
+	if (p != last && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
+	}
+
+	rval = parse_magnitude(p, last, negative ? (uint64_t) INT64_MAX + 1 : (uint64_t) INT64_MAX, &magnitude, &digits_end);
+	if (rval == 0) {
+		*value = negative ? -(int64_t) (magnitude - 1) - 1 : (int64_t) magnitude;
+	} else if (rval == EINVAL) {
+		digits_end = first;
+	}
+	if (end != NULL) {
+		*end = digits_end;
+	}
+
+	return rval;
+}
+
+int parse_int32(const char *first, const char *last, int32_t *value, const char **end)
+{
+	const char *p = first, *digits_end = first;
+	uint64_t magnitude = 0;
+	int negative = 0, rval;
+
+	if (p != last && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
+	}
+
+	rval = parse_magnitude(p, last, negative ? (uint64_t) INT32_MAX + 1 : (uint64_t) INT32_MAX, &magnitude, &digits_end);
+	if (rval == 0) {
+		*value = negative ? (int32_t) -(int64_t) magnitude : (int32_t) magnitude;
+	} else if (rval == EINVAL) {
+		digits_end = first;
+	}
+	if (end != NULL) {
+		*end = digits_end;
+	}
+
+	return rval;
+}
+
+/*
+ * The Eisel-Lemire algorithm multiplies the decimal significand by a 128
+ * bit approximation of the power of ten. The bits of the product decide
+ * the rounding for every significand of up to 19 digits, which is proven
+ * by exhausting the possible cases. The approximations of 5^q, the power
+ * of two being a shift, are computed once at first use like the tables of
+ * format-number.c.
+ */
+
+#define PARSE_POW5_SMALLEST (-342)
+#define PARSE_POW5_LARGEST 308
+#define PARSE_POW5_TABLE_SIZE (PARSE_POW5_LARGEST - PARSE_POW5_SMALLEST + 1)
+
+/* enough 32 bit words for 2*5^342 */
+#define PARSE_BIGNUM_WORDS 28
+
+/* 5^q with the highest bit set, truncated to 128 bits, the high half first */
+static uint64_t parse_pow5_128[PARSE_POW5_TABLE_SIZE][2];
+static pthread_once_t parse_tables_once = PTHREAD_ONCE_INIT;
+
+static unsigned int parse_bignum_length(const uint32_t *words, unsigned int count)
+{
+	while (count > 0 && words[count - 1] == 0) {
+		--count;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	return (count - 1) * 32 + (32 - __builtin_clz(words[count - 1]));
+}
+
+/* the 128 bits of words starting at bit shift, bits below bit 0 are zero */
+static void parse_bignum_bits(const uint32_t *words, unsigned int count, int shift, uint64_t result[2])
+{
+	unsigned int i;
+	int bit;
+
+	result[0] = 0;
+	result[1] = 0;
+	for (i = 0; i < 128; ++i) {
+		bit = shift + (int) i;
+		if (bit >= 0 && (unsigned int) bit < count * 32 && ((words[bit >> 5] >> (bit & 31)) & 1) != 0) {
+			result[1 - (i >> 6)] |= (uint64_t) 1 << (i & 63);
+		}
+	}
+}
+
+static int parse_bignum_less(const uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	while (count-- > 0) {
+		if (a[count] != b[count]) {
+			return a[count] < b[count];
+		}
+	}
+
+	return 0;
+}
+
+static void parse_bignum_sub(uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	unsigned int i;
+	uint64_t borrow = 0, difference;
+
+	for (i = 0; i < count; ++i) {
+		difference = (uint64_t) a[i] - b[i] - borrow;
+		a[i] = (uint32_t) difference;
+		borrow = (difference >> 32) & 1;
+	}
+}
+
+static void parse_bignum_shl1(uint32_t *a, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = count - 1; i > 0; --i) {
+		a[i] = (a[i] << 1) | (a[i - 1] >> 31);
+	}
+	a[0] <<= 1;
+}
+
+static void parse_init_tables(void)
+{
+	uint32_t pow5[PARSE_BIGNUM_WORDS];
+	uint32_t remainder[PARSE_BIGNUM_WORDS];
+	uint64_t carry, *quotient;
+	unsigned int i, s, w, length, count;
+	int round_up;
+
+	memset(pow5, 0, sizeof(pow5));
+	pow5[0] = 1;
+
+	for (i = 0; i <= (unsigned int) -PARSE_POW5_SMALLEST; ++i) {
+		length = parse_bignum_length(pow5, PARSE_BIGNUM_WORDS);
+		count = (length >> 5) + 2;
+
+		if (i <= PARSE_POW5_LARGEST) {
+			parse_bignum_bits(pow5, count, (int) length - 128, parse_pow5_128[i - PARSE_POW5_SMALLEST]);
+		}
+
+		if (i > 0) {
+			/* floor(2^(length + 127) / 5^i) by long division, starting at 2^length */
+			quotient = parse_pow5_128[-(int) i - PARSE_POW5_SMALLEST];
+			memset(remainder, 0, sizeof(remainder));
+			remainder[length >> 5] = (uint32_t) 1 << (length & 31);
+			quotient[0] = 0;
+			quotient[1] = 0;
+			for (s = 0; s < 128; ++s) {
+				if (s > 0) {
+					parse_bignum_shl1(remainder, count);
+					quotient[0] = (quotient[0] << 1) | (quotient[1] >> 63);
+					quotient[1] <<= 1;
+				}
+				if (!parse_bignum_less(remainder, pow5, count)) {
+					parse_bignum_sub(remainder, pow5, count);
+					quotient[1] |= 1;
+				}
+			}
+
+			/* the approximation is rounded up: for 5^27 and below by one, beyond that by one in the
+			 * length + 1 bits following the truncated ones, which only carries if all of them are set */
+			round_up = 1;
+			for (s = 0; i > 27 && s <= length && round_up; ++s) {
+				parse_bignum_shl1(remainder, count);
+				if (!parse_bignum_less(remainder, pow5, count)) {
+					parse_bignum_sub(remainder, pow5, count);
+				} else {
+					round_up = 0;
+				}
+			}
+			if (round_up) {
+				quotient[1] += 1;
+				quotient[0] += (quotient[1] == 0);
+			}
+		}
+
+		carry = 0;
+		for (w = 0; w < PARSE_BIGNUM_WORDS; ++w) {
+			carry += (uint64_t) pow5[w] * 5;
+			pow5[w] = (uint32_t) carry;
+			carry >>= 32;
+		}
+	}
+}
+
+/* the low half of a * b, the high half is stored in high */
+#if defined(__SIZEOF_INT128__)
+
+__extension__ typedef unsigned __int128 parse_uint128;
+
+static uint64_t parse_umul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+	const parse_uint128 product = (parse_uint128) a * b;
+
+	*high = (uint64_t) (product >> 64);
+
+	return (uint64_t) product;
+}
+
+#else
+
+static uint64_t parse_umul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+	const uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+	const uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+	const uint64_t b00 = a_lo * b_lo, b01 = a_lo * b_hi;
+	const uint64_t b10 = a_hi * b_lo, b11 = a_hi * b_hi;
+	const uint64_t mid1 = b10 + (b00 >> 32);
+	const uint64_t mid2 = b01 + (uint32_t) mid1;
+
+	*high = b11 + (mid1 >> 32) + (mid2 >> 32);
+
+	return (mid2 << 32) | (uint32_t) b00;
+}
+
+#endif
+
+/* the properties of a binary floating point format the algorithm depends on */
+struct parse_binary_format {
+	int mantissa_bits;
+	int minimum_exponent;
+	int infinite_power;
+	int64_t smallest_power10;
+	int64_t largest_power10;
+	int64_t min_round_to_even;
+	int64_t max_round_to_even;
+};
+
+static const struct parse_binary_format parse_binary64 = { 52, -1023, 0x7ff, -342, 308, -4, 23 };
+static const struct parse_binary_format parse_binary32 = { 23, -127, 0xff, -65, 38, -17, 10 };
+
+/* the bits without the sign of w * 10^q rounded to nearest, w has at most 19 digits */
+static uint64_t parse_eisel_lemire(uint64_t w, int64_t q, const struct parse_binary_format *binary)
+{
+	const uint64_t *pow5;
+	const uint64_t precision_mask = UINT64_MAX >> (binary->mantissa_bits + 3);
+	uint64_t high, low, second_high, mantissa;
+	int64_t power2;
+	int lz, upperbit, shift;
+
+	if (w == 0 || q < binary->smallest_power10) {
+		return 0;
+	}
+	if (q > binary->largest_power10) {
+		return (uint64_t) binary->infinite_power << binary->mantissa_bits;
+	}
+
+	lz = __builtin_clzll(w);
+	w <<= lz;
+
+	pow5 = parse_pow5_128[q - PARSE_POW5_SMALLEST];
+	low = parse_umul128(w, pow5[0], &high);
+	if ((high & precision_mask) == precision_mask) {
+		/* the bits below the mantissa might carry, the low half of the power decides */
+		parse_umul128(w, pow5[1], &second_high);
+		low += second_high;
+		if (second_high > low) {
+			++high;
+		}
+	}
+
+	upperbit = (int) (high >> 63);
+	shift = upperbit + 64 - binary->mantissa_bits - 3;
+	mantissa = high >> shift;
+	/* floor(log2(10^q)) + 63 */
+	power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz - binary->minimum_exponent;
+
+	if (power2 <= 0) {
+		/* subnormal, rounding up to the smallest normal number carries into the exponent */
+		if (-power2 + 1 >= 64) {
+			return 0;
+		}
+		mantissa >>= -power2 + 1;
+		mantissa += (mantissa & 1);
+		mantissa >>= 1;
+		return mantissa;
+	}
+
+	/* exactly halfway between two values, which is only possible if 5^q fits into 64 bits */
+	if (low <= 1 && q >= binary->min_round_to_even && q <= binary->max_round_to_even &&
+	    (mantissa & 3) == 1 && (mantissa << shift) == high) {
+		mantissa &= ~(uint64_t) 1;
+	}
+
+	mantissa += (mantissa & 1);
+	mantissa >>= 1;
+	if (mantissa >= ((uint64_t) 2 << binary->mantissa_bits)) {
+		mantissa = (uint64_t) 1 << binary->mantissa_bits;
+		++power2;
+	}
+	mantissa &= ~((uint64_t) 1 << binary->mantissa_bits);
+
+	if (power2 >= binary->infinite_power) {
+		return (uint64_t) binary->infinite_power << binary->mantissa_bits;
+	}
+
+	return ((uint64_t) power2 << binary->mantissa_bits) | mantissa;
+}
+
+/* a number split into significand and decimal exponent */
+struct parse_decimal {
+	uint64_t mantissa;
+	int64_t exponent;
+	int negative;
+	int many_digits; /* more than 19 significant digits, mantissa is useless */
+	int special; /* 1 for an infinity, 2 for a NaN */
+	const char *end;
+};
+
+/* the length of word at p ignoring case, 0 if p doesn't start with it */
+static size_t parse_match(const char *p, const char *last, const char *word)
+{
+	size_t length = strlen(word), i;
+
+	if ((size_t) (last - p) < length) {
+		return 0;
+	}
+	for (i = 0; i < length; ++i) {
+		if ((p[i] | 0x20) != word[i]) {
+			return 0;
+		}
+	}
+
+	return length;
+}
+
+/* the digits at p accumulated into mantissa, returns their end */
+static const char *parse_digits(const char *p, const char *last, uint64_t *mantissa)
+{
+	uint64_t result = *mantissa;
+
+#ifdef PARSE_SWAR
+	while (last - p >= 8 && parse_is_eight_digits(parse_load8(p))) {
+		result = result * 100000000 + parse_eight_digits(parse_load8(p));
+		p += 8;
+	}
+#endif
+	while (p != last && parse_is_digit(*p)) {
+		result = result * 10 + (uint64_t) (*p - '0');
+		++p;
+	}
+	*mantissa = result;
+
+	return p;
+}
+
+static int parse_decimal(const char *first, const char *last, struct parse_decimal *decimal)
+{
+	const char *p = first, *digits, *fraction, *e;
+	int64_t digit_count, exponent_number;
+	size_t length;
+	int negative_exponent;
+
+	memset(decimal, 0, sizeof(*decimal));
+
+	if (p != last && (*p == '-' || *p == '+')) {
+		decimal->negative = (*p == '-');
+		++p;
+	}
+
+	if ((length = parse_match(p, last, "inf")) != 0) {
+		decimal->special = 1;
+		p += length;
+		p += parse_match(p, last, "inity");
+		decimal->end = p;
+		return 0;
+	}
+	if ((length = parse_match(p, last, "nan")) != 0) {
+		decimal->special = 2;
+		decimal->end = p + length;
+		return 0;
+	}
+
+	digits = p;
+	p = parse_digits(p, last, &decimal->mantissa);
+	digit_count = p - digits;
+
+	if (p != last && *p == '.') {
+		fraction = ++p;
+		p = parse_digits(p, last, &decimal->mantissa);
+		decimal->exponent = fraction - p;
+		digit_count += p - fraction;
+	}
+	if (digit_count == 0) {
+		return EINVAL;
+	}
+
+	/* an exponent without digits isn't part of the number */
+	if (p != last && (*p == 'e' || *p == 'E')) {
+		e = p + 1;
+		negative_exponent = 0;
+		if (e != last && (*e == '-' || *e == '+')) {
+			negative_exponent = (*e == '-');
+			++e;
+		}
+		if (e != last && parse_is_digit(*e)) {
+			exponent_number = 0;
+			while (e != last && parse_is_digit(*e)) {
+				if (exponent_number < 0x10000000) {
+					exponent_number = exponent_number * 10 + (*e - '0');
+				}
+				++e;
+			}
+			decimal->exponent += negative_exponent ? -exponent_number : exponent_number;
+			p = e;
+		}
+	}
+	decimal->end = p;
+
+	if (digit_count > 19) {
+		/* leading zeros aren't significant */
+		while (digits != p && (*digits == '0' || *digits == '.')) {
+			digit_count -= (*digits == '0');
+			++digits;
+		}
+		decimal->many_digits = (digit_count > 19);
+	}
+
+	return 0;
+}
+
+/* a null terminated copy of the text for strtod, in buffer if it fits */
+static char *parse_copy(const char *first, const char *last, char *buffer, size_t size)
+{
+	const size_t length = (size_t) (last - first);
+	char *text = buffer;
+
+	if (length >= size) {
+		text = (char *) malloc(length + 1);
+		if (text == NULL) {
+			return NULL;
+		}
+	}
+	memcpy(text, first, length);
+	text[length] = '\0';
+
+	return text;
+}
+
+#ifdef PARSE_EXACT_ARITHMETIC
+static const double parse_double_powers10[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const float parse_float_powers10[11] = {
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+#endif
+
+int parse_double(const char *first, const char *last, double *value, const char **end)
+{
+	struct parse_decimal decimal;
+	char buffer[64], *text;
+	uint64_t bits;
+	double result;
+
+	if (parse_decimal(first, last, &decimal) != 0) {
+		if (end != NULL) {
+			*end = first;
+		}
+		return EINVAL;
+	}
+	if (end != NULL) {
+		*end = decimal.end;
+	}
+
+	if (decimal.special) {
+		bits = (decimal.special == 1) ? 0x7FF0000000000000ULL : 0x7FF8000000000000ULL;
+	} else if (decimal.many_digits) {
+		text = parse_copy(first, decimal.end, buffer, sizeof(buffer));
+		if (text == NULL) {
+			return ENOMEM;
+		}
+		result = strtod(text, NULL);
+		if (text != buffer) {
+			free(text);
+		}
+		memcpy(&bits, &result, sizeof(bits));
+		if ((bits & 0x7FF0000000000000ULL) == 0x7FF0000000000000ULL) {
+			return ERANGE;
+		}
+		*value = result;
+		return 0;
+	}
+#ifdef PARSE_EXACT_ARITHMETIC
+	else if (decimal.exponent >= -22 && decimal.exponent <= 22 && decimal.mantissa <= ((uint64_t) 1 << 53)) {
+		result = (double) decimal.mantissa;
+		if (decimal.exponent < 0) {
+			result /= parse_double_powers10[-decimal.exponent];
+		} else {
+			result *= parse_double_powers10[decimal.exponent];
+		}
+		*value = decimal.negative ? -result : result;
+		return 0;
+	}
+#endif
+	else {
+		pthread_once(&parse_tables_once, parse_init_tables);
+		bits = parse_eisel_lemire(decimal.mantissa, decimal.exponent, &parse_binary64);
+		if ((bits >> 52) == 0x7FF) {
+			return ERANGE;
+		}
+	}
+
+	bits |= (uint64_t) decimal.negative << 63;
+	memcpy(value, &bits, sizeof(bits));
+
+	return 0;
+}
+
+int parse_float(const char *first, const char *last, float *value, const char **end)
+{
+	struct parse_decimal decimal;
+	char buffer[64], *text;
+	uint32_t bits;
+	float result;
+
+	if (parse_decimal(first, last, &decimal) != 0) {
+		if (end != NULL) {
+			*end = first;
+		}
+		return EINVAL;
+	}
+	if (end != NULL) {
+		*end = decimal.end;
+	}
+
+	if (decimal.special) {
+		bits = (decimal.special == 1) ? 0x7F800000U : 0x7FC00000U;
+	} else if (decimal.many_digits) {
+		text = parse_copy(first, decimal.end, buffer, sizeof(buffer));
+		if (text == NULL) {
+			return ENOMEM;
+		}
+		result = strtof(text, NULL);
+		if (text != buffer) {
+			free(text);
+		}
+		memcpy(&bits, &result, sizeof(bits));
+		if ((bits & 0x7F800000U) == 0x7F800000U) {
+			return ERANGE;
+		}
+		*value = result;
+		return 0;
+	}
+#ifdef PARSE_EXACT_ARITHMETIC
+	else if (decimal.exponent >= -10 && decimal.exponent <= 10 && decimal.mantissa <= ((uint64_t) 1 << 24)) {
+		result = (float) decimal.mantissa;
+		if (decimal.exponent < 0) {
+			result /= parse_float_powers10[-decimal.exponent];
+		} else {
+			result *= parse_float_powers10[decimal.exponent];
+		}
+		*value = decimal.negative ? -result : result;
+		return 0;
+	}
+#endif
+	else {
+		pthread_once(&parse_tables_once, parse_init_tables);
+		bits = (uint32_t) parse_eisel_lemire(decimal.mantissa, decimal.exponent, &parse_binary32);
+		if ((bits >> 23) == 0xFF) {
+			return ERANGE;
+		}
+	}
+
+	bits |= (uint32_t) decimal.negative << 31;
+	memcpy(value, &bits, sizeof(bits));
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file parse-number.h
+ *
+ * @brief Conversion of decimal text to numbers.
+ *
+ * The functions read a number from the beginning of the characters
+ * between first and last, which don't need to be null terminated. Unlike
+ * strtol and strtod they don't skip leading blanks and report what went
+ * wrong instead of returning 0:
+ *
+ * @li 0 if a number was read, *end points behind it.
+ * @li EINVAL if first doesn't start with a number, *end is first and the
+ *     value is left alone.
+ * @li ERANGE if the number doesn't fit into the type, *end points behind
+ *     it and the value is left alone.
+ *
+ * Integers are a '+' or '-' followed by decimal digits, eight of them are
+ * checked and converted at once. Floating point numbers are decimal
+ * digits with an optional decimal point and exponent, or "inf",
+ * "infinity" and "nan" in any case, each with an optional sign. They are
+ * rounded correctly: exactly representable cases are computed in floating
+ * point, the others with the Eisel-Lemire algorithm, and numbers with
+ * more than 19 significant digits are handed to strtod.
+ *
+ * The functions may be called from several threads at once.
+ */
+
+#ifndef PARSE_NUMBER_H_
+#define PARSE_NUMBER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Read a 32 bit integer.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL or ERANGE.
+ */
+
+int parse_int32(const char *first, const char *last, int32_t *value, const char **end);
+
+/**
+ * Read a 64 bit integer.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL or ERANGE.
+ */
+
+int parse_int64(const char *first, const char *last, int64_t *value, const char **end);
+
+/**
+ * Read a double, rounded to nearest.
+ *
+ * Numbers too large for a double are ERANGE, too small ones are read as
+ * zero.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL, ERANGE or ENOMEM if a number
+ *                             with many digits couldn't be copied for
+ *                             strtod.
+ */
+
+int parse_double(const char *first, const char *last, double *value, const char **end);
+
+/**
+ * Read a float, rounded to nearest from the decimal text and not from
+ * the nearest double.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL, ERANGE or ENOMEM.
+ */
+
+int parse_float(const char *first, const char *last, float *value, const char **end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef PARSE_NUMBER_H_ */
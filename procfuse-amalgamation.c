@@ -269,10 +269,29 @@ CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
  */
 
-/* Hash table implementation */
+/* Hash table implementation
+ *
+ * Open addressing: keys and values are stored in one array of slots and
+ * a parallel array holds one control byte per slot.  A control byte is
+ * either empty, deleted, or holds 7 bits of the hash of the key in its
+ * slot.  The slots are probed in groups of 16: the control bytes of a
+ * group are compared against the 7 hash bits at once (with SSE2 where
+ * available), so the keys of only a few candidate slots are compared at
+ * all, and a lookup usually touches one cache line of control bytes and
+ * the one of its slot.  The number of slots is a power of two.
+ *
+ * Most tables (directories of procfuse) only ever hold a handful of
+ * entries.  These are kept in a small array inside the table structure
+ * together with their hashes and are searched linearly, the slot arrays
+ * are only allocated once the small array is full. */
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 /* malloc() / free() testing */
@@ -280,86 +299,266 @@ CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #ifdef ALLOC_TESTING
 #endif
 
+#define HASH_TABLE_GROUP_SIZE 16
+
+/* Control byte values for slots which do not hold an entry.  Both have
+ * the high bit set, while the control byte of a full slot is the 7 bit
+ * fragment of the hash of its key. */
+
+#define HASH_TABLE_CTRL_EMPTY ((signed char) -128)
+#define HASH_TABLE_CTRL_DELETED ((signed char) -2)
+
 struct _HashTableEntry {
 	HashTableKey key;
 	HashTableValue value;
-	HashTableEntry *next;
 };
 
+/* Number of entries stored in the table structure itself */
+
+#define HASH_TABLE_SMALL_SIZE 6
+
 struct _HashTable {
-	HashTableEntry **table;
-	int table_size;
+	signed char *ctrl;
+	HashTableEntry *slots;
+	unsigned int capacity; /* zero as long as the small array is used */
+	unsigned int growth_left;
 	HashTableHashFunc hash_func;
 	HashTableEqualFunc equal_func;
 	HashTableKeyFreeFunc key_free_func;
 	HashTableValueFreeFunc value_free_func;
 	int entries;
-	int prime_index;
+	HashTableEntry small[HASH_TABLE_SMALL_SIZE];
+	uint64_t small_hash[HASH_TABLE_SMALL_SIZE];
 };
 
-/* This is a set of good hash table prime numbers, from:
- *   http://planetmath.org/encyclopedia/GoodHashTablePrimes.html
- * Each prime is roughly double the previous value, and as far as
- * possible from the nearest powers of two. */
+/* Smallest number of slots, one group */
 
-static const unsigned int hash_table_primes[] = {
-	193, 389, 769, 1543, 3079, 6151, 12289, 24593, 49157, 98317,
-	196613, 393241, 786433, 1572869, 3145739, 6291469,
-	12582917, 25165843, 50331653, 100663319, 201326611,
-	402653189, 805306457, 1610612741,
-};
+#define HASH_TABLE_MIN_CAPACITY HASH_TABLE_GROUP_SIZE
+
+/* The hash functions used with this table are weak in their low bits
+ * (int_hash returns the key itself), so the hash is mixed before it is
+ * split into the group index and the 7 bit fragment. */
+
+static uint64_t hash_table_hash(HashTable *hash_table, HashTableKey key)
+{
+	uint64_t hash;
 
-static const int hash_table_num_primes 
-	= sizeof(hash_table_primes) / sizeof(int);
+	hash = (uint64_t) hash_table->hash_func(key) * 0x9E3779B97F4A7C15ULL;
 
-/* Internal function used to allocate the table on hash table creation
- * and when enlarging the table */
+	return hash ^ (hash >> 32);
+}
 
-static int hash_table_allocate_table(HashTable *hash_table)
+static signed char hash_table_h2(uint64_t hash)
 {
-	int new_table_size;
+	return (signed char) (hash & 0x7f);
+}
 
-	/* Determine the table size based on the current prime index.  
-	 * An attempt is made here to ensure sensible behavior if the
-	 * maximum prime is exceeded, but in practice other things are
-	 * likely to break long before that happens. */
+/* Bit mask of the slots in the group starting at ctrl whose control byte
+ * equals value */
 
-	if (hash_table->prime_index < hash_table_num_primes) {
-		new_table_size = hash_table_primes[hash_table->prime_index];
-	} else {
-		new_table_size = hash_table->entries * 10;
+static unsigned int hash_table_group_match(const signed char *ctrl,
+                                           signed char value)
+{
+#ifdef __SSE2__
+	__m128i group;
+
+	group = _mm_loadu_si128((const __m128i *) ctrl);
+
+	return (unsigned int) _mm_movemask_epi8(
+	           _mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+	unsigned int mask = 0;
+	int i;
+
+	for (i=0; i<HASH_TABLE_GROUP_SIZE; ++i) {
+		if (ctrl[i] == value) {
+			mask |= 1u << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+/* Bit mask of the slots in a group which are empty or deleted */
+
+static unsigned int hash_table_group_match_free(const signed char *ctrl)
+{
+#ifdef __SSE2__
+	/* The high bit is only set for empty and deleted slots */
+
+	return (unsigned int) _mm_movemask_epi8(
+	           _mm_loadu_si128((const __m128i *) ctrl));
+#else
+	unsigned int mask = 0;
+	int i;
+
+	for (i=0; i<HASH_TABLE_GROUP_SIZE; ++i) {
+		if (ctrl[i] < 0) {
+			mask |= 1u << i;
+		}
+	}
+
+	return mask;
+#endif
+}
+
+static int hash_table_lowest_bit(unsigned int mask)
+{
+	return __builtin_ctz(mask);
+}
+
+/* Maximum number of full and deleted slots, 7/8 of the capacity */
+
+static unsigned int hash_table_max_load(unsigned int capacity)
+{
+	return capacity - capacity / 8;
+}
+
+/* Internal function used to allocate the arrays on hash table creation
+ * and when resizing the table */
+
+static int hash_table_allocate_table(HashTable *hash_table,
+                                     unsigned int capacity)
+{
+	signed char *ctrl;
+
+	/* The control bytes and the slots share one allocation, the slots
+	 * follow the control bytes which are a multiple of 16 */
+
+	ctrl = (signed char *) malloc(capacity
+	                              + capacity * sizeof(HashTableEntry));
+
+	if (ctrl == NULL) {
+		return 0;
+	}
+
+	memset(ctrl, HASH_TABLE_CTRL_EMPTY, capacity);
+
+	hash_table->ctrl = ctrl;
+	hash_table->slots = (HashTableEntry *) (ctrl + capacity);
+	hash_table->capacity = capacity;
+	hash_table->growth_left = hash_table_max_load(capacity);
+
+	return 1;
+}
+
+/* The entry stored at a position returned by hash_table_find */
+
+static HashTableEntry *hash_table_entry(HashTable *hash_table, long found)
+{
+	if (hash_table->capacity == 0) {
+		return &hash_table->small[found];
+	}
+
+	return &hash_table->slots[found];
+}
+
+/* Find the slot of key, or -1 if it is not in the table, for small
+ * tables the index into the small array */
+
+static long hash_table_find(HashTable *hash_table, HashTableKey key,
+                            uint64_t hash)
+{
+	unsigned int group_mask;
+	unsigned int group;
+	unsigned int probe;
+	unsigned int match;
+	unsigned int slot;
+	signed char h2;
+
+	if (hash_table->capacity == 0) {
+		for (slot=0; slot<(unsigned int) hash_table->entries; ++slot) {
+			if (hash_table->small_hash[slot] == hash
+			 && hash_table->equal_func(key,
+			        hash_table->small[slot].key) != 0) {
+				return (long) slot;
+			}
+		}
+
+		return -1;
+	}
+
+	group_mask = hash_table->capacity / HASH_TABLE_GROUP_SIZE - 1;
+	group = (unsigned int) (hash >> 7) & group_mask;
+	h2 = hash_table_h2(hash);
+
+	/* Triangular probing over the groups visits every group once, as
+	 * the number of groups is a power of two */
+
+	for (probe=1; probe<=group_mask+1; ++probe) {
+		slot = group * HASH_TABLE_GROUP_SIZE;
+
+		match = hash_table_group_match(hash_table->ctrl + slot, h2);
+
+		while (match != 0) {
+			int i = hash_table_lowest_bit(match);
+
+			if (hash_table->equal_func(key,
+			        hash_table->slots[slot + i].key) != 0) {
+				return (long) (slot + i);
+			}
+
+			match &= match - 1;
+		}
+
+		/* An empty slot ends the probe sequence, the key would have
+		 * been stored here */
+
+		if (hash_table_group_match(hash_table->ctrl + slot,
+		                           HASH_TABLE_CTRL_EMPTY) != 0) {
+			break;
+		}
+
+		group = (group + probe) & group_mask;
 	}
 
-	hash_table->table_size = new_table_size;
+	return -1;
+}
+
+/* Find a free slot for a key which is not in the table */
+
+static unsigned int hash_table_find_free(HashTable *hash_table,
+                                         uint64_t hash)
+{
+	unsigned int group_mask;
+	unsigned int group;
+	unsigned int probe;
+	unsigned int match;
+
+	group_mask = hash_table->capacity / HASH_TABLE_GROUP_SIZE - 1;
+	group = (unsigned int) (hash >> 7) & group_mask;
 
-	/* Allocate the table and initialise to NULL for all entries */
+	for (probe=1; ; ++probe) {
+		match = hash_table_group_match_free(hash_table->ctrl
+		                             + group * HASH_TABLE_GROUP_SIZE);
 
-	hash_table->table = (HashTableEntry**)calloc(hash_table->table_size,
-	                           sizeof(HashTableEntry *));
+		if (match != 0) {
+			return group * HASH_TABLE_GROUP_SIZE
+			     + hash_table_lowest_bit(match);
+		}
 
-	return hash_table->table != NULL;
+		group = (group + probe) & group_mask;
+	}
 }
 
 /* Free an entry, calling the free functions if there are any registered */
 
-static void hash_table_free_entry(HashTable *hash_table, HashTableEntry *entry)
+static void hash_table_free_entry(HashTable *hash_table, HashTableKey key,
+                                  HashTableValue value)
 {
 	/* If there is a function registered for freeing keys, use it to free
 	 * the key */
 	
 	if (hash_table->key_free_func != NULL) {
-		hash_table->key_free_func(entry->key);
+		hash_table->key_free_func(key);
 	}
 
 	/* Likewise with the value */
 
 	if (hash_table->value_free_func != NULL) {
-		hash_table->value_free_func(entry->value);
+		hash_table->value_free_func(value);
 	}
-
-	/* Free the data structure */
-	
-	free(entry);
 }
 
 HashTable *hash_table_new(HashTableHashFunc hash_func, 
@@ -380,39 +579,40 @@ HashTable *hash_table_new(HashTableHashFunc hash_func,
 	hash_table->key_free_func = NULL;
 	hash_table->value_free_func = NULL;
 	hash_table->entries = 0;
-	hash_table->prime_index = 0;
-
-	/* Allocate the table */
 
-	if (!hash_table_allocate_table(hash_table)) {
-		free(hash_table);
+	/* Start out with the small array */
 
-		return NULL;
-	}
+	hash_table->ctrl = NULL;
+	hash_table->slots = NULL;
+	hash_table->capacity = 0;
+	hash_table->growth_left = 0;
 
 	return hash_table;
 }
 
 void hash_table_free(HashTable *hash_table)
 {
-	HashTableEntry *rover;
-	HashTableEntry *next;
-	int i;
+	unsigned int i;
 	
-	/* Free all entries in all chains */
+	/* Free all entries */
+
+	for (i=0; i<(unsigned int) hash_table->entries
+	            && hash_table->capacity == 0; ++i) {
+		hash_table_free_entry(hash_table, hash_table->small[i].key,
+		                      hash_table->small[i].value);
+	}
 
-	for (i=0; i<hash_table->table_size; ++i) {
-		rover = hash_table->table[i];
-		while (rover != NULL) {
-			next = rover->next;
-			hash_table_free_entry(hash_table, rover);
-			rover = next;
+	for (i=0; i<hash_table->capacity; ++i) {
+		if (hash_table->ctrl[i] >= 0) {
+			hash_table_free_entry(hash_table,
+			                      hash_table->slots[i].key,
+			                      hash_table->slots[i].value);
 		}
 	}
 	
 	/* Free the table */
 
-	free(hash_table->table);
+	free(hash_table->ctrl);
 	
 	/* Free the hash table structure */
 
@@ -427,143 +627,165 @@ void hash_table_register_free_functions(HashTable *hash_table,
 	hash_table->value_free_func = value_free_func;
 }
 
+/* Move all entries into new arrays of the given capacity, this also
+ * drops all deleted slots */
 
-static int hash_table_enlarge(HashTable *hash_table)
+static int hash_table_resize(HashTable *hash_table, unsigned int capacity)
 {
-	HashTableEntry **old_table;
-	int old_table_size;
-	int old_prime_index;
-	HashTableEntry *rover;
-	HashTableEntry *next;
-	int index;
-	int i;
+	signed char *old_ctrl;
+	HashTableEntry *old_slots;
+	unsigned int old_capacity;
+	unsigned int slot;
+	unsigned int i;
+	uint64_t hash;
 	
 	/* Store a copy of the old table */
 	
-	old_table = hash_table->table;
-	old_table_size = hash_table->table_size;
-	old_prime_index = hash_table->prime_index;
+	old_ctrl = hash_table->ctrl;
+	old_slots = hash_table->slots;
+	old_capacity = hash_table->capacity;
 
-	/* Allocate a new, larger table */
-
-	++hash_table->prime_index;
-	
-	if (!hash_table_allocate_table(hash_table)) {
+	if (!hash_table_allocate_table(hash_table, capacity)) {
 
 		/* Failed to allocate the new table */
 
-		hash_table->table = old_table;
-		hash_table->table_size = old_table_size;
-		hash_table->prime_index = old_prime_index;
+		hash_table->ctrl = old_ctrl;
+		hash_table->slots = old_slots;
+		hash_table->capacity = old_capacity;
 
 		return 0;
 	}
 
-	/* Link all entries from all chains into the new table */
+	/* Insert all entries into the new table */
 
-	for (i=0; i<old_table_size; ++i) {
-		rover = old_table[i];
+	for (i=0; old_capacity == 0 && i<(unsigned int) hash_table->entries; ++i) {
+		hash = hash_table->small_hash[i];
+		slot = hash_table_find_free(hash_table, hash);
 
-		while (rover != NULL) {
-			next = rover->next;
+		hash_table->ctrl[slot] = hash_table_h2(hash);
+		hash_table->slots[slot] = hash_table->small[i];
+		--hash_table->growth_left;
+	}
 
-			/* Find the index into the new table */
-			
-			index = hash_table->hash_func(rover->key) % hash_table->table_size;
-			
-			/* Link this entry into the chain */
+	for (i=0; i<old_capacity; ++i) {
+		if (old_ctrl[i] < 0) {
+			continue;
+		}
 
-			rover->next = hash_table->table[index];
-			hash_table->table[index] = rover;
-			
-			/* Advance to next in the chain */
+		hash = hash_table_hash(hash_table, old_slots[i].key);
+		slot = hash_table_find_free(hash_table, hash);
 
-			rover = next;
-		}
+		hash_table->ctrl[slot] = hash_table_h2(hash);
+		hash_table->slots[slot] = old_slots[i];
+		--hash_table->growth_left;
 	}
 
 	/* Free the old table */
 
-	free(old_table);
+	free(old_ctrl);
        
 	return 1;
 }
 
 int hash_table_insert(HashTable *hash_table, HashTableKey key, HashTableValue value) 
 {
-	HashTableEntry *rover;
-	HashTableEntry *newentry;
-	int index;
-	
-	/* If there are too many items in the table with respect to the table
-	 * size, the number of hash collisions increases and performance
-	 * decreases. Enlarge the table size to prevent this happening */
-
-	if ((hash_table->entries * 3) / hash_table->table_size > 0) {
-		
-		/* Table is more than 1/3 full */
+	HashTableEntry *entry;
+	HashTableKey old_key;
+	HashTableValue old_value;
+	unsigned int capacity;
+	unsigned int slot;
+	long found;
+	uint64_t hash;
 
-		if (!hash_table_enlarge(hash_table)) {
+	hash = hash_table_hash(hash_table, key);
 
-			/* Failed to enlarge the table */
+	/* Look for an existing entry with the same key */
 
-			return 0;
-		}
-	}
+	found = hash_table_find(hash_table, key, hash);
 
-	/* Generate the hash of the key and hence the index into the table */
+	if (found >= 0) {
 
-	index = hash_table->hash_func(key) % hash_table->table_size;
+		/* Same key: overwrite this entry with new data, the old key
+		 * and value are freed after the table is consistent again, in
+		 * case the free functions use the table */
 
-	/* Traverse the chain at this location and look for an existing
-	 * entry with the same key */
+		entry = hash_table_entry(hash_table, found);
+		old_key = entry->key;
+		old_value = entry->value;
 
-	rover = hash_table->table[index];
+		entry->key = key;
+		entry->value = value;
 
-	while (rover != NULL) {
-		if (hash_table->equal_func(rover->key, key) != 0) {
+		/* If there is a value free function, free the old data */
 
-			/* Same key: overwrite this entry with new data */
+		if (hash_table->value_free_func != NULL) {
+			hash_table->value_free_func(old_value);
+		}
 
-			/* If there is a value free function, free the old data
-			 * before adding in the new data */
+		/* Same with the key */
 
-			if (hash_table->value_free_func != NULL) {
-				hash_table->value_free_func(rover->value);
-			}
+		if (hash_table->key_free_func != NULL) {
+			hash_table->key_free_func(old_key);
+		}
 
-			/* Same with the key: use the new key value and free 
-			 * the old one */
+		/* Finished */
+			
+		return 1;
+	}
 
-			if (hash_table->key_free_func != NULL) {
-				hash_table->key_free_func(rover->key);
-			}
+	/* Not in the hash table yet.  Append it to the small array while
+	 * there is room, or move all entries into slot arrays */
 
-			rover->key = key;
-			rover->value = value;
+	if (hash_table->capacity == 0) {
+		if (hash_table->entries < HASH_TABLE_SMALL_SIZE) {
+			hash_table->small[hash_table->entries].key = key;
+			hash_table->small[hash_table->entries].value = value;
+			hash_table->small_hash[hash_table->entries] = hash;
+			++hash_table->entries;
 
-			/* Finished */
-			
 			return 1;
 		}
-		rover = rover->next;
+
+		if (!hash_table_resize(hash_table, HASH_TABLE_MIN_CAPACITY)) {
+			return 0;
+		}
 	}
-	
-	/* Not in the hash table yet.  Create a new entry */
 
-	newentry = (HashTableEntry *) malloc(sizeof(HashTableEntry));
+	/* If there are no more slots left which may be used without
+	 * overloading the table, clean out the deleted slots or enlarge
+	 * the table */
 
-	if (newentry == NULL) {
-		return 0;
+	slot = hash_table_find_free(hash_table, hash);
+
+	if (hash_table->growth_left == 0
+	 && hash_table->ctrl[slot] == HASH_TABLE_CTRL_EMPTY) {
+
+		capacity = hash_table->capacity;
+
+		if ((unsigned int) hash_table->entries * 2
+		      >= hash_table_max_load(capacity)) {
+			capacity *= 2;
+		}
+
+		if (!hash_table_resize(hash_table, capacity)) {
+
+			/* Failed to enlarge the table */
+
+			return 0;
+		}
+
+		slot = hash_table_find_free(hash_table, hash);
 	}
 
-	newentry->key = key;
-	newentry->value = value;
+	/* Taking an empty slot uses up room, reusing a deleted one not */
 
-	/* Link into the list */
+	if (hash_table->ctrl[slot] == HASH_TABLE_CTRL_EMPTY) {
+		--hash_table->growth_left;
+	}
 
-	newentry->next = hash_table->table[index];
-	hash_table->table[index] = newentry;
+	hash_table->ctrl[slot] = hash_table_h2(hash);
+	hash_table->slots[slot].key = key;
+	hash_table->slots[slot].value = value;
 
 	/* Maintain the count of the number of entries */
 
@@ -576,83 +798,78 @@ int hash_table_insert(HashTable *hash_table, HashTableKey key, HashTableValue va
 
 HashTableValue hash_table_lookup(HashTable *hash_table, HashTableKey key)
 {
-	HashTableEntry *rover;
-	int index;
+	long found;
 
-	/* Generate the hash of the key and hence the index into the table */
-	
-	index = hash_table->hash_func(key) % hash_table->table_size;
-
-	/* Walk the chain at this index until the corresponding entry is
-	 * found */
+	found = hash_table_find(hash_table, key,
+	                        hash_table_hash(hash_table, key));
 
-	rover = hash_table->table[index];
+	if (found < 0) {
 
-	while (rover != NULL) {
-		if (hash_table->equal_func(key, rover->key) != 0) {
+		/* Not found */
 
-			/* Found the entry.  Return the data. */
-
-			return rover->value;
-		}
-		rover = rover->next;
+		return HASH_TABLE_NULL;
 	}
 
-	/* Not found */
-
-	return HASH_TABLE_NULL;
+	return hash_table_entry(hash_table, found)->value;
 }
 
 int hash_table_remove(HashTable *hash_table, HashTableKey key)
 {
-	HashTableEntry **rover;
-	HashTableEntry *entry;
-	int index;
-	int result;
+	HashTableKey old_key;
+	HashTableValue old_value;
+	unsigned int group;
+	long found;
+	int last;
 
-	/* Generate the hash of the key and hence the index into the table */
-	
-	index = hash_table->hash_func(key) % hash_table->table_size;
+	found = hash_table_find(hash_table, key,
+	                        hash_table_hash(hash_table, key));
 
-	/* Rover points at the pointer which points at the current entry
-	 * in the chain being inspected.  ie. the entry in the table, or
-	 * the "next" pointer of the previous entry in the chain.  This
-	 * allows us to unlink the entry when we find it. */
+	if (found < 0) {
+		return 0;
+	}
 
-	result = 0;
-	rover = &hash_table->table[index];
+	old_key = hash_table_entry(hash_table, found)->key;
+	old_value = hash_table_entry(hash_table, found)->value;
 
-	while (*rover != NULL) {
+	if (hash_table->capacity == 0) {
 
-		if (hash_table->equal_func(key, (*rover)->key) != 0) {
+		/* Keep the small array without gaps */
 
-			/* This is the entry to remove */
+		last = hash_table->entries - 1;
+		hash_table->small[found] = hash_table->small[last];
+		hash_table->small_hash[found] = hash_table->small_hash[last];
 
-			entry = *rover;
+		--hash_table->entries;
 
-			/* Unlink from the list */
+		hash_table_free_entry(hash_table, old_key, old_value);
 
-			*rover = entry->next;
+		return 1;
+	}
 
-			/* Destroy the entry structure */
+	/* If the group of the slot has an empty slot, no probe sequence
+	 * went past this group and the slot can become empty again.
+	 * Otherwise it has to be marked deleted to keep later keys of
+	 * probe sequences running through this group reachable. */
 
-			hash_table_free_entry(hash_table, entry);
+	group = (unsigned int) found & ~(HASH_TABLE_GROUP_SIZE - 1u);
 
-			/* Track count of entries */
+	if (hash_table_group_match(hash_table->ctrl + group,
+	                           HASH_TABLE_CTRL_EMPTY) != 0) {
+		hash_table->ctrl[found] = HASH_TABLE_CTRL_EMPTY;
+		++hash_table->growth_left;
+	} else {
+		hash_table->ctrl[found] = HASH_TABLE_CTRL_DELETED;
+	}
 
-			--hash_table->entries;
+	/* Track count of entries */
 
-			result = 1;
+	--hash_table->entries;
 
-			break;
-		}
-		
-		/* Advance to the next entry */
+	/* Destroy the entry */
 
-		rover = &((*rover)->next);
-	}
+	hash_table_free_entry(hash_table, old_key, old_value);
 
-	return result;
+	return 1;
 }
 
 int hash_table_num_entries(HashTable *hash_table)
@@ -662,90 +879,67 @@ int hash_table_num_entries(HashTable *hash_table)
 
 void hash_table_iterate(HashTable *hash_table, HashTableIterator *iterator)
 {
-	int chain;
-	
 	iterator->hash_table = hash_table;
+	iterator->next_slot = 0;
 
-	/* Default value of next if no entries are found. */
-	
-	iterator->next_entry = NULL;
-	
 	/* Find the first entry */
-	
-	for (chain=0; chain<hash_table->table_size; ++chain) {
-		
-		if (hash_table->table[chain] != NULL) {
-			iterator->next_entry = hash_table->table[chain];
-			iterator->next_chain = chain;
-			break;
-		}
+
+	while (iterator->next_slot < hash_table->capacity
+	    && hash_table->ctrl[iterator->next_slot] < 0) {
+		++iterator->next_slot;
 	}
 }
 
 int hash_table_iter_has_more(HashTableIterator *iterator)
 {
-	return iterator->next_entry != NULL;
+	HashTable *hash_table = iterator->hash_table;
+
+	if (hash_table->capacity == 0) {
+		return iterator->next_slot < (unsigned int) hash_table->entries;
+	}
+
+	return iterator->next_slot < hash_table->capacity;
 }
 
 HashTableValue hash_table_iter_next(HashTableIterator *iterator)
 {
-	HashTableEntry *current_entry;
 	HashTable *hash_table;
 	HashTableValue result;
-	int chain;
 
 	hash_table = iterator->hash_table;
 
+	/* Small array: entries are stored without gaps */
+
+	if (hash_table->capacity == 0) {
+		if (iterator->next_slot >= (unsigned int) hash_table->entries) {
+			return HASH_TABLE_NULL;
+		}
+
+		return hash_table->small[iterator->next_slot++].value;
+	}
+
 	/* No more entries? */
 	
-	if (iterator->next_entry == NULL) {
+	if (iterator->next_slot >= hash_table->capacity) {
 		return HASH_TABLE_NULL;
 	}
 	
 	/* Result is immediately available */
 
-	current_entry = iterator->next_entry;
-	result = current_entry->value;
+	result = hash_table->slots[iterator->next_slot].value;
 
 	/* Find the next entry */
 
-	if (current_entry->next != NULL) {
-		
-		/* Next entry in current chain */
-
-		iterator->next_entry = current_entry->next;
-		
-	} else {
-	
-		/* None left in this chain, so advance to the next chain */
-
-		chain = iterator->next_chain + 1;
-
-		/* Default value if no next chain found */
-		
-		iterator->next_entry = NULL;
-
-		while (chain < hash_table->table_size) {
-
-			/* Is there anything in this chain? */
-
-			if (hash_table->table[chain] != NULL) {
-				iterator->next_entry = hash_table->table[chain];
-				break;
-			}
-
-			/* Try the next chain */
-
-			++chain;
-		}
+	++iterator->next_slot;
 
-		iterator->next_chain = chain;
+	while (iterator->next_slot < hash_table->capacity
+	    && hash_table->ctrl[iterator->next_slot] < 0) {
+		++iterator->next_slot;
 	}
 
 	return result;
 }
 
-
 /*
     ProcFuse is a C library which can be used to register string paths
     representing a file of your own filesystem like /proc used by *nix
@@ -764,2078 +958,7664 @@ HashTableValue hash_table_iter_next(HashTableIterator *iterator)
     You should have received a copy of the GNU Lesser General Public
     License along with this library; if not, write to the Free Software
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
- */
-
+*/
 
-#ifndef _LARGEFILE64_SOURCE
-#define _LARGEFILE64_SOURCE
-#endif
+/* Fixed size object allocator */
 
-#ifndef _GNU_SOURCE
-#define _GNU_SOURCE
-#endif
+#include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 
 
-#ifndef FUSE_USE_VERSION
-#define FUSE_USE_VERSION 26
-#endif
-
-#include <fuse.h>
+/* objects are aligned for any type procfuse stores in them, long double included */
+#define SLAB_ALIGN 16
 
+typedef struct _SlabChunk SlabChunk;
 
-#include <string.h>
-#include <errno.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <signal.h>
-#include <sys/mount.h>
-#include <sys/types.h>
-#include <dirent.h>
-#include <stdlib.h>
-#include <stdint.h>
-#define __STDC_FORMAT_MACROS
-#include <inttypes.h>
-#include <sys/time.h>
-#include <stdarg.h>
-#include <sys/sysinfo.h>
-#include <sys/mman.h>
-#include <unistd.h>
+/* a chunk header, the objects follow it */
+struct _SlabChunk {
+	SlabChunk *next;
+	char padding[SLAB_ALIGN - sizeof(SlabChunk *)];
+};
 
+/* released objects are linked through their first bytes */
+typedef struct _SlabFreeObject SlabFreeObject;
 
+struct _SlabFreeObject {
+	SlabFreeObject *next;
+};
 
-#define PROCFUSE_DELIMC '/'
-#define PROCFUSE_DELIMS "/"
+struct _Slab {
+	pthread_mutex_t lock;
+	size_t object_size;
+	unsigned int chunk_objects;
+	SlabChunk *chunks;
+	SlabFreeObject *free_list;
+	char *unused;         /* objects of the newest chunk which haven't been handed out yet */
+	char *unused_end;
+	unsigned int objects;
+};
 
-#define PROCFUSE_FNAMELEN 512
+Slab *slab_new(size_t object_size, unsigned int chunk_objects)
+{
+	Slab *slab;
 
-typedef enum { T_PROC_POD_NO=0, T_PROC_POD_CHAR, T_PROC_POD_INT, T_PROC_POD_INT64,
-	                  T_PROC_POD_FLOAT, T_PROC_POD_DOUBLE, T_PROC_POD_LONGDOUBLE,
-	                  T_PROC_POD_STRING, T_PROC_POD_MAX} procfuse_pod_t;
+	if (object_size == 0 || chunk_objects == 0) {
+		return NULL;
+	}
 
-struct procfuse{
-	HashTable *root;
-	pthread_mutex_t lock;
+	slab = (Slab *) calloc(1, sizeof(Slab));
 
-	int64_t tidcounter;
+	if (slab == NULL) {
+		return NULL;
+	}
 
-	int running;
-	pthread_t procfuseth;
-	struct fuse *fuse;
-	pthread_mutex_t fuselock;
+	if (object_size < sizeof(SlabFreeObject)) {
+		object_size = sizeof(SlabFreeObject);
+	}
+	slab->object_size = (object_size + SLAB_ALIGN - 1) & ~((size_t) SLAB_ALIGN - 1);
+	slab->chunk_objects = chunk_objects;
 
-	int fuseArgc;
-	const char *fuseArgv[9];
-	char *fuse_option;
-	int fuse_singlethreaded;
+	pthread_mutex_init(&slab->lock, NULL);
 
-	char *absolutemountpoint;
-	struct fuse_operations procFS_oper;
+	return slab;
+}
 
-	const void *appdata;
-	pthread_key_t key_thread_local_storage;
-};
+void slab_free(Slab *slab)
+{
+	SlabChunk *chunk;
+	SlabChunk *next;
 
-struct procfuse_threadlocalstorage{
-	struct procfuse_error error;
-};
+	if (slab == NULL) {
+		return;
+	}
 
-struct procfuse_pod_string{
-	int mmapedfd64_r;
-    char *mmapedbuffer_r;
-    int64_t length_r;
+	for (chunk = slab->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
 
-	int mmapedfd64_w;
-    char *mmapedbuffer_w;
-    int64_t length_w;
-};
+	pthread_mutex_destroy(&slab->lock);
+	free(slab);
+}
 
-union procfuse_pod{
-	char c;
-	int i;
-	int64_t l;
-	float f;
-	double d;
-	long double ld;
-	struct procfuse_pod_string str;
-};
+void *slab_alloc(Slab *slab)
+{
+	void *object = NULL;
+	SlabChunk *chunk;
 
-typedef int (*procfuse_onModify)(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata, ...);
+	pthread_mutex_lock(&slab->lock);
 
-struct procfuse_pod_accessor{
-	procfuse_onModify onModify; /* modify function corresponding to 'procfuse_pod_t type' */
+	if (slab->free_list != NULL) {
+		object = slab->free_list;
+		slab->free_list = slab->free_list->next;
+	} else {
+		if (slab->unused == slab->unused_end) {
 
-	union procfuse_pod value;
+			/* Take a new chunk from the system, its objects are handed
+			 * out in order */
 
-	procfuse_pod_t type;
+			chunk = (SlabChunk *) malloc(sizeof(SlabChunk)
+			            + slab->object_size * slab->chunk_objects);
 
-	pthread_rwlock_t rwlock;
-};
+			if (chunk == NULL) {
+				pthread_mutex_unlock(&slab->lock);
+				return NULL;
+			}
 
-struct procfuse_transactionnode{
-	char *writebuffer;
-	int length;
-	int haswritten;
+			chunk->next = slab->chunks;
+			slab->chunks = chunk;
+			slab->unused = (char *) (chunk + 1);
+			slab->unused_end = slab->unused
+			                 + slab->object_size * slab->chunk_objects;
+		}
 
-	int64_t tid; /* key */
-};
+		object = slab->unused;
+		slab->unused += slab->object_size;
+	}
 
-struct procfuse_hashnode{
-	pthread_rwlock_t lock;
+	++slab->objects;
 
-	char *absolutepath;
+	pthread_mutex_unlock(&slab->lock);
 
-	int pendingforunlink;
+	memset(object, 0, slab->object_size);
 
-    HashTable *subdirs;
+	return object;
+}
 
-    HashTable *transactions;
+void slab_release(Slab *slab, void *object)
+{
+	SlabFreeObject *free_object = (SlabFreeObject *) object;
 
-	struct procfuse_pod_accessor onpodevent;
-	struct procfuse_accessor onevent;
+	if (object == NULL) {
+		return;
+	}
 
-	mode_t mode;
-	uid_t uid;
-    gid_t gid;
-    struct timeval created;
-	struct timeval access;
-	struct timeval modify;
+	pthread_mutex_lock(&slab->lock);
 
-	int flags;  /* one of O_RDONLY,  O_WRONLY,  or  O_RDWR*/
+	free_object->next = slab->free_list;
+	slab->free_list = free_object;
+	--slab->objects;
+
+	pthread_mutex_unlock(&slab->lock);
+}
+
+unsigned int slab_num_objects(Slab *slab)
+{
+	unsigned int objects;
 
-	char *key;
+	pthread_mutex_lock(&slab->lock);
+	objects = slab->objects;
+	pthread_mutex_unlock(&slab->lock);
 
-	int concurrent_access_counter;
+	return objects;
+}
+
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Decimal conversion of numbers */
+
+#include <string.h>
+#include <pthread.h>
+
+
+/* the pairs 00 to 99, integers are written two digits per division */
+static const char format_digit_pairs[201] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const uint64_t format_powers10[20] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+	100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+	10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
 };
 
+/* number of decimal digits of value, 1 for 0 */
+static unsigned int format_decimal_length(uint64_t value)
+{
+	unsigned int t;
 
-int procfuse_onFuseOpenPOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata);
-int procfuse_onFuseReadPOD(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
-int procfuse_onFuseWritePOD(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
-int procfuse_onFuseTruncatePOD(const struct procfuse *pf, const char *path, const off_t off, const void* appdata);
-int procfuse_onFuseReleasePOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata);
+	/* powers of ten above 1 are even, so setting the lowest bit doesn't change the length */
+	value |= 1;
 
-void procfuse_freeHashNode(void *n){
-	struct procfuse_hashnode *node = NULL;
-	if(n!=NULL) return;
-	node = (struct procfuse_hashnode *)n;
-	if(node->subdirs!=NULL){
-		hash_table_free(node->subdirs);
-	}
-	if(node->transactions!=NULL){
-		hash_table_free(node->transactions);
+	/* 1233/4096 is a little more than log10(2) */
+	t = ((64 - __builtin_clzll(value)) * 1233) >> 12;
+
+	return t + 1 - (value < format_powers10[t]);
+}
+
+/* writes the digits of value so that the last one is right before end */
+static void format_write_digits(uint64_t value, char *end)
+{
+	unsigned int pair;
+
+	while (value >= 100) {
+		pair = (unsigned int) (value % 100) * 2;
+		value /= 100;
+		end -= 2;
+		end[0] = format_digit_pairs[pair];
+		end[1] = format_digit_pairs[pair + 1];
+	}
+	if (value >= 10) {
+		pair = (unsigned int) value * 2;
+		end -= 2;
+		end[0] = format_digit_pairs[pair];
+		end[1] = format_digit_pairs[pair + 1];
+	} else {
+		end[-1] = (char) ('0' + value);
 	}
+}
 
-	pthread_rwlock_destroy(&node->lock);
+size_t format_uint64(uint64_t value, char *buffer)
+{
+	unsigned int length;
 
-	switch(node->onpodevent.type){
-		case T_PROC_POD_STRING:
-			if(node->onpodevent.value.str.mmapedbuffer_r != NULL){
-			    munmap(node->onpodevent.value.str.mmapedbuffer_r, node->onpodevent.value.str.length_r);
-			}
-			if(node->onpodevent.value.str.mmapedfd64_r >= 0){
-			    close(node->onpodevent.value.str.mmapedfd64_r);
-			}
+	length = format_decimal_length(value);
+	format_write_digits(value, buffer + length);
+	buffer[length] = '\0';
 
-			if(node->onpodevent.value.str.mmapedbuffer_w != NULL){
-			    munmap(node->onpodevent.value.str.mmapedbuffer_w, node->onpodevent.value.str.length_w);
-			}
-			if(node->onpodevent.value.str.mmapedfd64_w >= 0){
-			    close(node->onpodevent.value.str.mmapedfd64_w);
-			}
-			break;
-		default:
-			break;
+	return length;
+}
+
+size_t format_int64(int64_t value, char *buffer)
+{
+	if (value < 0) {
+		buffer[0] = '-';
+		/* negated unsigned, INT64_MIN has no positive counterpart */
+		return format_uint64(0 - (uint64_t) value, buffer + 1) + 1;
 	}
 
-	free(node->key);
-	free(node->absolutepath);
+	return format_uint64((uint64_t) value, buffer);
+}
 
-	free(node);
+size_t format_int32(int32_t value, char *buffer)
+{
+	return format_int64(value, buffer);
 }
-void procfuse_freeTransactionNode(void *n){
-	struct procfuse_transactionnode *tnode = NULL;
 
-	if(n!=NULL) return;
-	tnode = (struct procfuse_transactionnode *)n;
+/* Shortest round trip floating point output, following "Ryu: fast
+ * float-to-string conversion" by Ulf Adams, PLDI 2018.
+ *
+ * The rounding interval of a binary value is scaled by a power of five
+ * with 125 significant bits, which is exact enough to decide every digit
+ * without multiple precision arithmetic. Instead of shipping the tables of
+ * these powers as constants they are computed once at first use.
+ */
 
-	if(tnode->writebuffer!=NULL)
-	    free(tnode->writebuffer);
+#define FORMAT_POW5_INV_BITCOUNT 125
+#define FORMAT_POW5_BITCOUNT 125
+#define FORMAT_POW5_INV_TABLE_SIZE 342
+#define FORMAT_POW5_TABLE_SIZE 326
 
-	free(tnode);
-}
-int procfuse_ctorht(HashTable **ht, int shall_str){
-	if(ht==NULL){
-		errno = EINVAL;
-		return 0;
-	}
-	if(shall_str){
-	    *ht = hash_table_new(string_hash, string_equal);
-	}
-	else{
-		*ht = hash_table_new(int_hash, int_equal);
+/* enough 32 bit words for 2*5^341 */
+#define FORMAT_BIGNUM_WORDS 28
+
+/* 2^k/5^i and 5^i/2^k with 125 significant bits, the low half first */
+static uint64_t format_pow5_inv_split[FORMAT_POW5_INV_TABLE_SIZE][2];
+static uint64_t format_pow5_split[FORMAT_POW5_TABLE_SIZE][2];
+static pthread_once_t format_tables_once = PTHREAD_ONCE_INIT;
+
+static unsigned int format_bignum_length(const uint32_t *words, unsigned int count)
+{
+	while (count > 0 && words[count - 1] == 0) {
+		--count;
 	}
-	if(*ht==NULL){
+	if (count == 0) {
 		return 0;
 	}
-	if(shall_str)
-        hash_table_register_free_functions(*ht, free, procfuse_freeHashNode);
-	else
-		hash_table_register_free_functions(*ht, NULL, procfuse_freeTransactionNode);
-	return 1;
+
+	return (count - 1) * 32 + (32 - __builtin_clz(words[count - 1]));
 }
-int procfuse_dtorht(HashTable **ht){
-	if(ht==NULL){
-		errno = EINVAL;
-		return 0;
+
+/* the 128 bits of words starting at bit shift, bits below bit 0 are zero */
+static void format_bignum_bits(const uint32_t *words, unsigned int count, int shift, uint64_t result[2])
+{
+	unsigned int i;
+	int bit;
+
+	result[0] = 0;
+	result[1] = 0;
+	for (i = 0; i < 128; ++i) {
+		bit = shift + (int) i;
+		if (bit >= 0 && (unsigned int) bit < count * 32 && ((words[bit >> 5] >> (bit & 31)) & 1) != 0) {
+			result[i >> 6] |= (uint64_t) 1 << (i & 63);
+		}
 	}
-	hash_table_free(*ht);
-	*ht=NULL;
-	return 1;
 }
 
-
-struct procfuse* procfuse_ctor(const char *filesystemname, const char *mountpoint, const char *fuse_option,const void *appdata){
-	struct procfuse *pf = NULL;
-	char *absolutemountpoint = NULL;
-	DIR *d = NULL;
-	int er = 0, len = 0;
-	const char *fusermountcmd = "fusermount -u ";
-	char *unmountcmd = NULL;
-
-	if(filesystemname==NULL || mountpoint==NULL){
-		errno = EINVAL;
-		return NULL;
+static int format_bignum_less(const uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	while (count-- > 0) {
+		if (a[count] != b[count]) {
+			return a[count] < b[count];
+		}
 	}
 
-	errno = 0;
-	pf = (struct procfuse *)calloc(1, sizeof(struct procfuse));
-	absolutemountpoint = realpath(mountpoint, NULL);
-	if(pf==NULL || absolutemountpoint==NULL){
-		if(pf!=NULL) free(pf);
-		if(absolutemountpoint!=NULL) free(absolutemountpoint);
+	return 0;
+}
 
-		errno = ENOMEM;
-		return NULL;
-	}
-	memset(pf, '\0', sizeof(struct procfuse));
-	pthread_mutex_init(&pf->lock, NULL);
-	pthread_mutex_init(&pf->fuselock, NULL);
+static void format_bignum_sub(uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	unsigned int i;
+	uint64_t borrow = 0, difference;
 
-	if(pthread_key_create(&pf->key_thread_local_storage, free)!=0){
-		free(pf);
-		free(absolutemountpoint);
-		return NULL;
+	for (i = 0; i < count; ++i) {
+		difference = (uint64_t) a[i] - b[i] - borrow;
+		a[i] = (uint32_t) difference;
+		borrow = (difference >> 32) & 1;
 	}
+}
 
-	if(procfuse_ctorht(&pf->root, PROCFUSE_YES)==0){
-		free(pf);
-		free(absolutemountpoint);
-		return NULL;
+static void format_bignum_shl1(uint32_t *a, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = count - 1; i > 0; --i) {
+		a[i] = (a[i] << 1) | (a[i - 1] >> 31);
 	}
+	a[0] <<= 1;
+}
 
-    pf->fuseArgv[0] = strdup(filesystemname);
-    pf->fuseArgv[1] = absolutemountpoint;
-    pf->absolutemountpoint = absolutemountpoint;
+static void format_init_tables(void)
+{
+	uint32_t pow5[FORMAT_BIGNUM_WORDS];
+	uint32_t remainder[FORMAT_BIGNUM_WORDS];
+	uint64_t carry, quotient[2];
+	unsigned int i, s, w, length, count;
 
-	if(fuse_option!=NULL && strlen(fuse_option)>0){
-	    pf->fuse_option = strdup(fuse_option);
-	}
+	memset(pow5, 0, sizeof(pow5));
+	pow5[0] = 1;
 
-	pf->fuse_singlethreaded = 0;
-	pf->running = 0;
+	for (i = 0; i < FORMAT_POW5_INV_TABLE_SIZE; ++i) {
+		length = format_bignum_length(pow5, FORMAT_BIGNUM_WORDS);
+		count = (length >> 5) + 2;
 
-	d = NULL;
-	if((d=opendir(pf->absolutemountpoint))==NULL){
-		if(errno==ENOTCONN){
+		if (i < FORMAT_POW5_TABLE_SIZE) {
+			/* 5^i >> (length - 125) */
+			format_bignum_bits(pow5, count, (int) length - FORMAT_POW5_BITCOUNT, format_pow5_split[i]);
+		}
 
-			er = umount2(pf->absolutemountpoint, MNT_DETACH);
-			if(er==-1){
-				len = strlen(pf->absolutemountpoint)+strlen(fusermountcmd)+1;
-				unmountcmd = (char*)calloc(sizeof(char), len);
-				if(unmountcmd!=NULL){
-				    snprintf(unmountcmd, len, "%s%s", fusermountcmd, pf->absolutemountpoint);
-				    system(unmountcmd);
-				    free(unmountcmd);
-				}
+		/* floor(2^(length - 1 + 125) / 5^i) + 1 by long division, starting at 2^(length - 1) */
+		memset(remainder, 0, sizeof(remainder));
+		remainder[(length - 1) >> 5] = (uint32_t) 1 << ((length - 1) & 31);
+		quotient[0] = 0;
+		quotient[1] = 0;
+		for (s = 0; s <= FORMAT_POW5_INV_BITCOUNT; ++s) {
+			if (s > 0) {
+				format_bignum_shl1(remainder, count);
+				quotient[1] = (quotient[1] << 1) | (quotient[0] >> 63);
+				quotient[0] <<= 1;
+			}
+			if (!format_bignum_less(remainder, pow5, count)) {
+				format_bignum_sub(remainder, pow5, count);
+				quotient[0] |= 1;
 			}
 		}
+		quotient[0] += 1;
+		quotient[1] += (quotient[0] == 0);
+		format_pow5_inv_split[i][0] = quotient[0];
+		format_pow5_inv_split[i][1] = quotient[1];
+
+		carry = 0;
+		for (w = 0; w < FORMAT_BIGNUM_WORDS; ++w) {
+			carry += (uint64_t) pow5[w] * 5;
+			pow5[w] = (uint32_t) carry;
+			carry >>= 32;
+		}
 	}
-	else{
-		closedir(d);
-	}
+}
 
-	pf->appdata = appdata;
+/* ceil(log2(5^e)), 1 for e == 0 */
+static int32_t format_pow5_bits(int32_t e)
+{
+	return (int32_t) (((uint32_t) e * 1217359) >> 19) + 1;
+}
 
-	return pf;
+/* floor(log10(2^e)) */
+static uint32_t format_log10_pow2(int32_t e)
+{
+	return ((uint32_t) e * 78913) >> 18;
 }
 
-void procfuse_dtor(struct procfuse *pf){
-	struct timespec ts;
-	if(pf==NULL || pf->root==NULL){
-		return;
-	}
+/* floor(log10(5^e)) */
+static uint32_t format_log10_pow5(int32_t e)
+{
+	return ((uint32_t) e * 732923) >> 20;
+}
 
-	/* waiting for the thread to exit */
-	do{
-		procfuse_teardown(pf);
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_nsec += 100000000; /* 100 milliseconds */
-	}while(pthread_timedjoin_np(pf->procfuseth, NULL, &ts)!=0);
-    pthread_join(pf->procfuseth, NULL);
+static int format_multiple_of_pow5(uint64_t value, uint32_t p)
+{
+	uint32_t count = 0;
 
-	free((void*)pf->fuseArgv[0]);
-	free((void*)pf->absolutemountpoint);
-	if(pf->fuse_option!=NULL){
-	    free((void*)pf->fuse_option);
+	while (value % 5 == 0) {
+		value /= 5;
+		++count;
 	}
 
-	procfuse_dtorht(&pf->root);
-	pf->appdata = NULL;
-
-	memset(pf, '\0', sizeof(struct procfuse));
-	free(pf);
+	return count >= p;
 }
 
-struct procfuse_threadlocalstorage* procfuse_getThreadLocalStorage(struct procfuse *pf){
-	struct procfuse_threadlocalstorage *tls = NULL;
+static int format_multiple_of_pow2(uint64_t value, uint32_t p)
+{
+	return (value & (((uint64_t) 1 << p) - 1)) == 0;
+}
 
-	if(pf==NULL){
-		errno = EINVAL;
-		return NULL;
-	}
+#if defined(__SIZEOF_INT128__)
 
-    if ((tls = (struct procfuse_threadlocalstorage *)pthread_getspecific(pf->key_thread_local_storage)) == NULL) {
-    	tls = (struct procfuse_threadlocalstorage *)calloc(1, sizeof(struct procfuse_threadlocalstorage));
-    	if(tls==NULL){
-    		errno = ENOMEM;
-    		return NULL;
-    	}
+__extension__ typedef unsigned __int128 format_uint128;
 
-        pthread_setspecific(pf->key_thread_local_storage, tls);
-    }
+/* (m * mul) >> j with j >= 64 */
+static uint64_t format_mul_shift(uint64_t m, const uint64_t *mul, int32_t j)
+{
+	const format_uint128 b0 = (format_uint128) m * mul[0];
+	const format_uint128 b2 = (format_uint128) m * mul[1];
 
-    return tls;
+	return (uint64_t) (((b0 >> 64) + b2) >> (j - 64));
 }
 
-struct procfuse_error* procfuse_error(struct procfuse *pf){
-	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
-	if(tls==NULL){
-		return NULL;
-	}
+#else
 
-	return &tls->error;
+static uint64_t format_umul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+	const uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+	const uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+	const uint64_t b00 = a_lo * b_lo, b01 = a_lo * b_hi;
+	const uint64_t b10 = a_hi * b_lo, b11 = a_hi * b_hi;
+	const uint64_t mid1 = b10 + (b00 >> 32);
+	const uint64_t mid2 = b01 + (uint32_t) mid1;
+
+	*high = b11 + (mid1 >> 32) + (mid2 >> 32);
+
+	return (mid2 << 32) | (uint32_t) b00;
 }
 
-void procfuse_setErrno(struct procfuse *pf, int errn){
-	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
-	if(tls==NULL){
-		return;
+/* (m * mul) >> j with 64 < j < 128 */
+static uint64_t format_mul_shift(uint64_t m, const uint64_t *mul, int32_t j)
+{
+	uint64_t high0, high1, low1, sum;
+	const uint32_t dist = (uint32_t) (j - 64);
+
+	low1 = format_umul128(m, mul[1], &high1);
+	format_umul128(m, mul[0], &high0);
+	sum = high0 + low1;
+	if (sum < high0) {
+		++high1;
 	}
 
-	tls->error.errn = errn;
+	return (high1 << (64 - dist)) | (sum >> dist);
 }
-void procfuse_setError(struct procfuse *pf, const char *fmt, ...){
-	int size = 0;
-	va_list ap;
-	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
-	if(tls==NULL){
-		return;
-	}
-	if(fmt==NULL){
-		errno = EINVAL;
-		return;
+
+#endif
+
+/* the shortest decimal digits, times 10^exponent, inside the rounding interval of 4*m2 * 2^e2
+ * mm_shift is 0 if the lower neighbour of the value is closer than the upper one
+ */
+static uint64_t format_shortest(uint64_t m2, int32_t e2, int mm_shift, int accept_bounds, int32_t *exponent)
+{
+	const uint64_t mv = 4 * m2;
+	uint64_t vr, vp, vm, output;
+	uint64_t vp_div10, vm_div10, vr_div10, vr_mod10;
+	int32_t e10, i, j, k, removed = 0;
+	uint32_t q;
+	int vm_trailing_zeros = 0, vr_trailing_zeros = 0, round_up = 0;
+	unsigned int last_removed = 0;
+
+	if (e2 >= 0) {
+		q = format_log10_pow2(e2) - (e2 > 3);
+		e10 = (int32_t) q;
+		k = FORMAT_POW5_INV_BITCOUNT + format_pow5_bits((int32_t) q) - 1;
+		i = -e2 + (int32_t) q + k;
+		vr = format_mul_shift(mv, format_pow5_inv_split[q], i);
+		vp = format_mul_shift(mv + 2, format_pow5_inv_split[q], i);
+		vm = format_mul_shift(mv - 1 - mm_shift, format_pow5_inv_split[q], i);
+		if (q <= 21) {
+			/* only one of mp, mv and mm can be a multiple of 5 */
+			if (mv % 5 == 0) {
+				vr_trailing_zeros = format_multiple_of_pow5(mv, q);
+			} else if (accept_bounds) {
+				vm_trailing_zeros = format_multiple_of_pow5(mv - 1 - mm_shift, q);
+			} else {
+				vp -= format_multiple_of_pow5(mv + 2, q);
+			}
+		}
+	} else {
+		q = format_log10_pow5(-e2) - (-e2 > 1);
+		e10 = (int32_t) q + e2;
+		i = -e2 - (int32_t) q;
+		k = format_pow5_bits(i) - FORMAT_POW5_BITCOUNT;
+		j = (int32_t) q - k;
+		vr = format_mul_shift(mv, format_pow5_split[i], j);
+		vp = format_mul_shift(mv + 2, format_pow5_split[i], j);
+		vm = format_mul_shift(mv - 1 - mm_shift, format_pow5_split[i], j);
+		if (q <= 1) {
+			/* mv has at least q trailing zero bits, and so does mp or mm */
+			vr_trailing_zeros = 1;
+			if (accept_bounds) {
+				vm_trailing_zeros = (mm_shift == 1);
+			} else {
+				--vp;
+			}
+		} else if (q < 63) {
+			vr_trailing_zeros = format_multiple_of_pow2(mv, q);
+		}
 	}
 
-	/* determine size of final string */
-	va_start(ap, fmt);
-	size = vsnprintf(NULL, 0, fmt, ap);
-    va_end(ap);
+	if (vm_trailing_zeros || vr_trailing_zeros) {
+		/* rare, the exact bounds and round half to even matter */
+		for (;;) {
+			vp_div10 = vp / 10;
+			vm_div10 = vm / 10;
+			if (vp_div10 <= vm_div10) {
+				break;
+			}
+			vr_div10 = vr / 10;
+			vr_mod10 = vr % 10;
+			vm_trailing_zeros &= (vm % 10 == 0);
+			vr_trailing_zeros &= (last_removed == 0);
+			last_removed = (unsigned int) vr_mod10;
+			vr = vr_div10;
+			vp = vp_div10;
+			vm = vm_div10;
+			++removed;
+		}
+		if (vm_trailing_zeros) {
+			while (vm % 10 == 0) {
+				vr_div10 = vr / 10;
+				vr_mod10 = vr % 10;
+				vr_trailing_zeros &= (last_removed == 0);
+				last_removed = (unsigned int) vr_mod10;
+				vr = vr_div10;
+				vp /= 10;
+				vm /= 10;
+				++removed;
+			}
+		}
+		if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+			last_removed = 4;
+		}
+		output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+	} else {
+		if (vp / 100 > vm / 100) {
+			round_up = (vr % 100) >= 50;
+			vr /= 100;
+			vp /= 100;
+			vm /= 100;
+			removed += 2;
+		}
+		for (;;) {
+			vp_div10 = vp / 10;
+			vm_div10 = vm / 10;
+			if (vp_div10 <= vm_div10) {
+				break;
+			}
+			round_up = (vr % 10) >= 5;
+			vr /= 10;
+			vp = vp_div10;
+			vm = vm_div10;
+			++removed;
+		}
+		output = vr + (vr == vm || round_up);
+	}
 
-    if(tls->error.error!=NULL){
-    	free(tls->error.error);
-    }
+	*exponent = e10 + removed;
 
-    /* finally allocate and snprintf final string */
-   	tls->error.error = (char*)calloc(size+1, sizeof(char));
-	va_start(ap, fmt);
-	size = vsnprintf(tls->error.error, size, fmt, ap);
-    va_end(ap);
+	return output;
 }
-void procfuse_setSolution(struct procfuse *pf, const char *fmt, ...){
-	int size = 0;
-	va_list ap;
-	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
-	if(tls==NULL){
-		return;
-	}
-	if(fmt==NULL){
-		errno = EINVAL;
-		return;
+
+/* lays digits * 10^exponent out like "%g" does */
+static size_t format_layout(int sign, uint64_t digits, int32_t exponent, int32_t precision, char *buffer)
+{
+	char *p = buffer;
+	unsigned int length, e;
+	int32_t scientific;
+
+	length = format_decimal_length(digits);
+	/* the exponent of the first digit */
+	scientific = exponent + (int32_t) length - 1;
+
+	if (sign) {
+		*p++ = '-';
+	}
+
+	if (scientific < -4 || scientific >= precision) {
+		format_write_digits(digits, p + length + 1);
+		p[0] = p[1];
+		if (length > 1) {
+			p[1] = '.';
+			p += length + 1;
+		} else {
+			p += 1;
+		}
+		*p++ = 'e';
+		*p++ = (scientific < 0) ? '-' : '+';
+		e = (unsigned int) ((scientific < 0) ? -scientific : scientific);
+		if (e >= 100) {
+			*p++ = (char) ('0' + e / 100);
+			e %= 100;
+		}
+		*p++ = format_digit_pairs[e * 2];
+		*p++ = format_digit_pairs[e * 2 + 1];
+	} else if (scientific < 0) {
+		*p++ = '0';
+		*p++ = '.';
+		while (++scientific < 0) {
+			*p++ = '0';
+		}
+		format_write_digits(digits, p + length);
+		p += length;
+	} else if ((int32_t) length <= scientific + 1) {
+		format_write_digits(digits, p + length);
+		p += length;
+		while ((int32_t) length++ <= scientific) {
+			*p++ = '0';
+		}
+	} else {
+		/* the integral digits are moved in front of the decimal point */
+		format_write_digits(digits, p + length + 1);
+		memmove(p, p + 1, (size_t) scientific + 1);
+		p[scientific + 1] = '.';
+		p += length + 1;
 	}
+	*p = '\0';
 
-	/* determine size of final string */
-	va_start(ap, fmt);
-	size = vsnprintf(NULL, 0, fmt, ap);
-    va_end(ap);
+	return (size_t) (p - buffer);
+}
 
-    if(tls->error.solution!=NULL){
-    	free(tls->error.solution);
-    }
+static size_t format_special(int sign, int nan, char *buffer)
+{
+	char *p = buffer;
 
-    /* finally allocate and snprintf final string */
-   	tls->error.solution = (char*)calloc(size+1, sizeof(char));
-	va_start(ap, fmt);
-	size = vsnprintf(tls->error.solution, size, fmt, ap);
-    va_end(ap);
-}
+	if (sign) {
+		*p++ = '-';
+	}
+	memcpy(p, nan ? "nan" : "inf", 4);
 
+	return (size_t) (p - buffer) + 3;
+}
 
-void procfuse_printTree(HashTable *htable){
-	struct procfuse_hashnode *value = NULL;
-	HashTableIterator iterator;
-	hash_table_iterate(htable, &iterator);
+size_t format_double(double value, char *buffer)
+{
+	uint64_t bits, mantissa, m2, digits;
+	uint32_t biased;
+	int32_t e2, exponent;
+	int sign;
 
-	while ((value = (struct procfuse_hashnode *)hash_table_iter_next(&iterator)) != HASH_TABLE_NULL) {
-		printf("%s:%d:%s key=%p\n",__FILE__,__LINE__,__FUNCTION__, value->key);
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (int) (bits >> 63);
+	mantissa = bits & (((uint64_t) 1 << 52) - 1);
+	biased = (uint32_t) ((bits >> 52) & 0x7ff);
 
-		if(value->subdirs==NULL){
-			printf("%s:%d:%s node = %s\n",__FILE__,__LINE__,__FUNCTION__, value->key);
-		}
-		else{
-			printf("%s:%d:%s subdir = %s\n",__FILE__,__LINE__,__FUNCTION__, value->key);
-			procfuse_printTree(value->subdirs);
-		}
+	if (biased == 0x7ff) {
+		return format_special(sign, mantissa != 0, buffer);
+	}
+	if (biased == 0 && mantissa == 0) {
+		return format_layout(sign, 0, 0, FORMAT_DOUBLE_PRECISION, buffer);
 	}
-}
 
-/* return position of first non delim character at the beginning of what */
-const char* procfuse_ltrim(const char *what, char delim){
-	if(what==NULL){ return NULL; }
-	while(*what==delim){
-		what++;
+	pthread_once(&format_tables_once, format_init_tables);
+
+	if (biased == 0) {
+		e2 = 1 - 1023 - 52 - 2;
+		m2 = mantissa;
+	} else {
+		e2 = (int32_t) biased - 1023 - 52 - 2;
+		m2 = ((uint64_t) 1 << 52) | mantissa;
 	}
-	return what;
-}
-/* return position of first non delim character at the end of what */
-const char* procfuse_rtrim(const char *what, char delim){
-	const char *eow = NULL;
-	if(what==NULL){ return NULL; }
 
-	eow = what+strlen(what);
-	do{
-		eow--;
-	}while(eow>what && *eow==delim);
+	digits = format_shortest(m2, e2, mantissa != 0 || biased <= 1, (m2 & 1) == 0, &exponent);
 
-	return eow;
+	return format_layout(sign, digits, exponent, FORMAT_DOUBLE_PRECISION, buffer);
 }
 
-int procfuse_getNextFileName(const char *trimedabsolutepath, char fname[PROCFUSE_FNAMELEN]){
-	size_t len = 0;
+size_t format_float(float value, char *buffer)
+{
+	uint32_t bits, mantissa, biased;
+	uint64_t m2, digits;
+	int32_t e2, exponent;
+	int sign;
 
-	const char *eop = strchr(trimedabsolutepath,PROCFUSE_DELIMC);
-	if(eop==NULL){
-		len = strlen(trimedabsolutepath);
-		eop = trimedabsolutepath+len;
+	memcpy(&bits, &value, sizeof(bits));
+	sign = (int) (bits >> 31);
+	mantissa = bits & (((uint32_t) 1 << 23) - 1);
+	biased = (bits >> 23) & 0xff;
+
+	if (biased == 0xff) {
+		return format_special(sign, mantissa != 0, buffer);
 	}
-	else{
-		len = (eop-trimedabsolutepath);
+	if (biased == 0 && mantissa == 0) {
+		return format_layout(sign, 0, 0, FORMAT_FLOAT_PRECISION, buffer);
 	}
 
-	if(len>sizeof(fname)-1){
-		errno = ENOMEM;
-		return 0;
+	pthread_once(&format_tables_once, format_init_tables);
+
+	/* the double tables cover the exponents of floats, their precision is more than enough */
+	if (biased == 0) {
+		e2 = 1 - 127 - 23 - 2;
+		m2 = mantissa;
+	} else {
+		e2 = (int32_t) biased - 127 - 23 - 2;
+		m2 = ((uint64_t) 1 << 23) | mantissa;
 	}
-	memcpy(fname, trimedabsolutepath, len);
 
-	return 1;
+	digits = format_shortest(m2, e2, mantissa != 0 || biased <= 1, (m2 & 1) == 0, &exponent);
+
+	return format_layout(sign, digits, exponent, FORMAT_FLOAT_PRECISION, buffer);
 }
 
-struct procfuse_hashnode* procfuse_getNextNode(HashTable *root, char *fname, int create){
-	struct procfuse_hashnode *node = (struct procfuse_hashnode *)hash_table_lookup(root, fname);
-	if(node==NULL && create==PROCFUSE_YES){
-		node = (struct procfuse_hashnode *)calloc(sizeof(struct procfuse_hashnode), 1);
-		if(node==NULL){
-			errno = ENOMEM;
-			return NULL;
-		}
-		node->key = strdup(fname);
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
 
-		if(hash_table_insert(root, node->key, node)==0){
-			free(node->key);
-			free(node);
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
 
-			node = NULL;
-		}
-	}
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
 
-	return node;
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Decimal parsing of numbers */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <pthread.h>
+
+
+/* eight digits are checked and converted at once where a uint64_t holds them in reading order */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PARSE_SWAR 1
+#endif
+
+/* floating point operations are rounded to their type, so exact operands give a correctly rounded result */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define PARSE_EXACT_ARITHMETIC 1
+#endif
+
+static int parse_is_digit(char c)
+{
+	return (unsigned char) (c - '0') < 10;
 }
 
-struct procfuse_hashnode* procfuse_pathToNode(HashTable *root, const char *absolutepath, int create){
-	int pathlen = 0, flen = 0, hassubpath = 0;
-	struct procfuse_hashnode *node = NULL;
-	const char *eoap = NULL;
-	char fname[PROCFUSE_FNAMELEN] = {'\0'};
+#ifdef PARSE_SWAR
 
-	if(root==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return NULL;
-	}
+static uint64_t parse_load8(const char *p)
+{
+	uint64_t value;
 
-	absolutepath = procfuse_ltrim(absolutepath, PROCFUSE_DELIMC);
-	eoap = procfuse_rtrim(absolutepath, PROCFUSE_DELIMC);
-	eoap++; /* reposition at delim character (or null byte) to have correct pointer arithmetic */
+	memcpy(&value, p, sizeof(value));
 
-	if(!procfuse_getNextFileName(absolutepath, fname)){
-		return NULL;
+	return value;
+}
+
+static int parse_is_eight_digits(uint64_t value)
+{
+	return ((value & 0xF0F0F0F0F0F0F0F0ULL) |
+	        (((value + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+/* the value of eight digits, combined pairwise into 2, 4 and 8 digit numbers */
+static uint32_t parse_eight_digits(uint64_t value)
+{
+	const uint64_t mask = 0x000000FF000000FFULL;
+	const uint64_t mul1 = 100 + (1000000ULL << 32);
+	const uint64_t mul2 = 1 + (10000ULL << 32);
+
+	value -= 0x3030303030303030ULL;
+	value = (value * 10) + (value >> 8);
+
+	return (uint32_t) ((((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32);
+}
+
+#endif
+
+/* the digits at first as an unsigned number, ERANGE if it's above limit */
+static int parse_magnitude(const char *first, const char *last, uint64_t limit, uint64_t *value, const char **end)
+{
+	const char *p = first, *significant;
+	uint64_t result = 0;
+	unsigned int digit;
+	int overflow = 0;
+
+	while (p != last && *p == '0') {
+		++p;
 	}
+	significant = p;
 
-	pathlen = eoap-absolutepath;
-	flen = strlen(fname);
-	hassubpath = (pathlen==flen) ? PROCFUSE_NO : PROCFUSE_YES ;
-
-	if(hassubpath){
-		node = procfuse_getNextNode(root, fname, create);
-		if(node->subdirs==NULL && create==PROCFUSE_YES &&
-		   procfuse_ctorht(&node->subdirs, PROCFUSE_YES)==0){
-			free(node->key);
-			free(node);
-			node = NULL;
+#ifdef PARSE_SWAR
+	/* up to 19 digits fit into a uint64_t */
+	while (last - p >= 8 && p - significant <= 11 && parse_is_eight_digits(parse_load8(p))) {
+		result = result * 100000000 + parse_eight_digits(parse_load8(p));
+		p += 8;
+	}
+#endif
+	while (p != last && parse_is_digit(*p) && p - significant < 19) {
+		result = result * 10 + (uint64_t) (*p - '0');
+		++p;
+	}
+	while (p != last && parse_is_digit(*p)) {
+		digit = (unsigned int) (*p - '0');
+		if (result > (UINT64_MAX - digit) / 10) {
+			overflow = 1;
+		} else {
+			result = result * 10 + digit;
 		}
+		++p;
 	}
-	else{
-		node = procfuse_getNextNode(root, fname, create);
+
+	if (p == first) {
+		return EINVAL;
 	}
 
-	if(node!=NULL){
-	    if(hassubpath && node->subdirs!=NULL){
-		    return procfuse_pathToNode(node->subdirs, absolutepath+flen+1, create);
-	    }
+	*end = p;
+	if (overflow || result > limit) {
+		return ERANGE;
 	}
-	/* in case of wrong node type is returned, it means an eexist error */
-	errno = EEXIST;
+	*value = result;
 
-	return node;
+	return 0;
 }
 
-int procfuse_unregisterNodeInternal(HashTable *root, const char *absolutepath){
-	int pathlen = 0, flen = 0, hassubpath = 0;
-	const char *eoap = NULL;
-	struct procfuse_hashnode *node = NULL;
-	char fname[PROCFUSE_FNAMELEN] = {'\0'};
+int parse_int64(const char *first, const char *last, int64_t *value, const char **end)
+{
+	const char *p = first, *digits_end = first;
+	uint64_t magnitude = 0;
+	int negative = 0, rval;
 
-	if(root==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
+	if (p != last && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
 	}
 
-	absolutepath = procfuse_ltrim(absolutepath, PROCFUSE_DELIMC);
-	eoap = procfuse_rtrim(absolutepath, PROCFUSE_DELIMC);
-	eoap++; /* reposition at delim character (or null byte) to have correct pointer arithmetic */
-
-
-	if(!procfuse_getNextFileName(absolutepath, fname)){
-		return 0;
+	rval = parse_magnitude(p, last, negative ? (uint64_t) INT64_MAX + 1 : (uint64_t) INT64_MAX, &magnitude, &digits_end);
+	if (rval == 0) {
+		*value = negative ? -(int64_t) (magnitude - 1) - 1 : (int64_t) magnitude;
+	} else if (rval == EINVAL) {
+		digits_end = first;
 	}
-
-	pathlen = eoap-absolutepath;
-	flen = strlen(fname);
-	hassubpath = (pathlen==flen) ? 0 : 1 ;
-
-	/* if
-	 *    node exists AND is end node AND absolutepath is filename => update access
-	 *    node exists AND is root node AND absolutepath is root => recursive unregisterNode
-	 *    node not exists => alloc node as neeeded
-	 */
-	node = procfuse_getNextNode(root, fname, PROCFUSE_NO);
-	if(node==NULL){
-		errno = EEXIST;
-		return 0;
+	if (end != NULL) {
+		*end = digits_end;
 	}
 
-	if(hassubpath && node->subdirs!=NULL){
-		int rval = procfuse_unregisterNodeInternal(node->subdirs, absolutepath+flen+1);
-		if(hash_table_num_entries(node->subdirs)<=0){
-			hash_table_remove(root, fname);
-			node = NULL;
-		}
-		return rval;
-	}
-	else {
-		hash_table_remove(root, fname);
-		return 1;
-	}
-	return 0;
+	return rval;
 }
 
-int procfuse_openTempFile(const char *pfx, int deleteOnOpen){
-	int descriptor = -1;
-    char tmpfiletemplate[8192];
-    int iteration=0, maxiteration = 64*1024; /* max 2^16 iterations */
-    static const char *tmpdir = NULL;
-
-	memset(tmpfiletemplate, '\0', sizeof(tmpfiletemplate));
+int parse_int32(const char *first, const char *last, int32_t *value, const char **end)
+{
+	const char *p = first, *digits_end = first;
+	uint64_t magnitude = 0;
+	int negative = 0, rval;
 
-	/* i'm not using a mutex here because the pointer values are very strict and since it's only written once here
-	 * even a race condition should result in the same tmpdir value
-	 */
-	if(tmpdir==NULL){
-	    tmpdir = getenv("TMPDIR");
-	}
-	if(tmpdir==NULL && P_tmpdir!=NULL){
-		tmpdir = P_tmpdir;
-	}
-	if(tmpdir==NULL){
-		tmpdir = "/tmp";
+	if (p != last && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
 	}
 
-	if(pfx==NULL){
-		pfx = "";
+	rval = parse_magnitude(p, last, negative ? (uint64_t) INT32_MAX + 1 : (uint64_t) INT32_MAX, &magnitude, &digits_end);
+	if (rval == 0) {
+		*value = negative ? (int32_t) -(int64_t) magnitude : (int32_t) magnitude;
+	} else if (rval == EINVAL) {
+		digits_end = first;
+	}
+	if (end != NULL) {
+		*end = digits_end;
 	}
 
-	do{
-		iteration++;
-
-	    snprintf(tmpfiletemplate, sizeof(tmpfiletemplate)-1, "%s/procfuse.%d.%s.tmp.%d%d", tmpdir, getpid(), pfx, rand(),rand());
-	    descriptor = open(tmpfiletemplate, O_RDWR | O_CREAT | O_EXCL | O_LARGEFILE, S_IRUSR|S_IWUSR);
+	return rval;
+}
 
-        if (descriptor >= 0){
-        	if(deleteOnOpen == PROCFUSE_YES){
-        		unlink(tmpfiletemplate);
-        	}
-	        break;
-	    }
-        else if(errno != EEXIST){
-        	break;
-        }
-	}while(iteration<maxiteration);
+/*
+ * The Eisel-Lemire algorithm multiplies the decimal significand by a 128
+ * bit approximation of the power of ten. The bits of the product decide
+ * the rounding for every significand of up to 19 digits, which is proven
+ * by exhausting the possible cases. The approximations of 5^q, the power
+ * of two being a shift, are computed once at first use like the tables of
+ * format-number.c.
+ */
 
-	return descriptor;
-}
+#define PARSE_POW5_SMALLEST (-342)
+#define PARSE_POW5_LARGEST 308
+#define PARSE_POW5_TABLE_SIZE (PARSE_POW5_LARGEST - PARSE_POW5_SMALLEST + 1)
 
+/* enough 32 bit words for 2*5^342 */
+#define PARSE_BIGNUM_WORDS 28
 
-int procfuse_create(struct procfuse *pf, const char *absolutepath, struct procfuse_accessor access){
-	int rval = 0, flags = 0;
-	struct procfuse_hashnode *node = NULL;
+/* 5^q with the highest bit set, truncated to 128 bits, the high half first */
+static uint64_t parse_pow5_128[PARSE_POW5_TABLE_SIZE][2];
+static pthread_once_t parse_tables_once = PTHREAD_ONCE_INIT;
 
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
+static unsigned int parse_bignum_length(const uint32_t *words, unsigned int count)
+{
+	while (count > 0 && words[count - 1] == 0) {
+		--count;
+	}
+	if (count == 0) {
 		return 0;
 	}
 
-	pthread_mutex_lock(&pf->lock);
+	return (count - 1) * 32 + (32 - __builtin_clz(words[count - 1]));
+}
 
-	node = procfuse_pathToNode(pf->root, absolutepath, PROCFUSE_YES);
-	if(node!=NULL){
-		node->absolutepath = strdup(absolutepath);
-		if(node->absolutepath==NULL){
-			procfuse_unregisterNodeInternal(pf->root, absolutepath);
+/* the 128 bits of words starting at bit shift, bits below bit 0 are zero */
+static void parse_bignum_bits(const uint32_t *words, unsigned int count, int shift, uint64_t result[2])
+{
+	unsigned int i;
+	int bit;
+
+	result[0] = 0;
+	result[1] = 0;
+	for (i = 0; i < 128; ++i) {
+		bit = shift + (int) i;
+		if (bit >= 0 && (unsigned int) bit < count * 32 && ((words[bit >> 5] >> (bit & 31)) & 1) != 0) {
+			result[1 - (i >> 6)] |= (uint64_t) 1 << (i & 63);
 		}
-		else{
-			memcpy(&node->onevent, &access, sizeof(access));
-			node->onpodevent.type = T_PROC_POD_NO;
-			flags = 0;
-			if(access.onFuseRead!=NULL && access.onFuseWrite!=NULL){
-				flags = O_RDWR;
-			}
-			else if(access.onFuseRead!=NULL){
-				flags = O_RDONLY;
-			}
-			else if(access.onFuseWrite!=NULL){
-				flags = O_WRONLY;
-			}
-			node->flags = flags;
-
-			pthread_rwlock_init(&node->lock, NULL);
-			node->concurrent_access_counter = 0;
-			node->pendingforunlink = PROCFUSE_NO;
+	}
+}
 
-			gettimeofday(&node->created, NULL);
-			rval = 1;
+static int parse_bignum_less(const uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	while (count-- > 0) {
+		if (a[count] != b[count]) {
+			return a[count] < b[count];
 		}
 	}
 
-	pthread_mutex_unlock(&pf->lock);
-
-	return rval;
+	return 0;
 }
 
-int procfuse_createPOD(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify onModify, procfuse_pod_t pod_type){
-	int rval = 0;
-	struct procfuse_hashnode *node = NULL;
-	struct procfuse_accessor access;
-	struct procfuse_pod_accessor podaccess;
+static void parse_bignum_sub(uint32_t *a, const uint32_t *b, unsigned int count)
+{
+	unsigned int i;
+	uint64_t borrow = 0, difference;
 
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
-	}
-	if(pod_type<=T_PROC_POD_NO || pod_type>=T_PROC_POD_MAX){
-		errno = EINVAL;
-		return 0;
+	for (i = 0; i < count; ++i) {
+		difference = (uint64_t) a[i] - b[i] - borrow;
+		a[i] = (uint32_t) difference;
+		borrow = (difference >> 32) & 1;
 	}
+}
 
-	memset(&podaccess, '\0', sizeof(podaccess));
-
-	podaccess.onModify = onModify;
-	podaccess.type = pod_type;
+static void parse_bignum_shl1(uint32_t *a, unsigned int count)
+{
+	unsigned int i;
 
-	if(pthread_rwlock_init(&podaccess.rwlock, NULL)!=0){
-		return 0;
+	for (i = count - 1; i > 0; --i) {
+		a[i] = (a[i] << 1) | (a[i - 1] >> 31);
 	}
+	a[0] <<= 1;
+}
 
-	pthread_mutex_lock(&pf->lock);
-
-	node = procfuse_pathToNode(pf->root, absolutepath, PROCFUSE_YES);
-	if(node!=NULL){
-		node->absolutepath = strdup(absolutepath);
-		if(node->absolutepath!=NULL){
-			memset(&access, '\0', sizeof(access));
-
-			access.onFuseOpen = procfuse_onFuseOpenPOD;
-			access.onFuseTruncate = procfuse_onFuseTruncatePOD;
-			access.onFuseRead = procfuse_onFuseReadPOD;
-			access.onFuseWrite = procfuse_onFuseWritePOD;
-			access.onFuseRelease = procfuse_onFuseReleasePOD;
-
-			memcpy(&node->onevent, &access, sizeof(access));
-			memcpy(&node->onpodevent, &podaccess, sizeof(podaccess));
-			node->flags = flags;
+static void parse_init_tables(void)
+{
+	uint32_t pow5[PARSE_BIGNUM_WORDS];
+	uint32_t remainder[PARSE_BIGNUM_WORDS];
+	uint64_t carry, *quotient;
+	unsigned int i, s, w, length, count;
+	int round_up;
 
-			pthread_rwlock_init(&node->lock, NULL);
-			node->concurrent_access_counter = 0;
-			node->pendingforunlink = PROCFUSE_NO;
+	memset(pow5, 0, sizeof(pow5));
+	pow5[0] = 1;
 
-			gettimeofday(&node->created, NULL);
+	for (i = 0; i <= (unsigned int) -PARSE_POW5_SMALLEST; ++i) {
+		length = parse_bignum_length(pow5, PARSE_BIGNUM_WORDS);
+		count = (length >> 5) + 2;
 
-			rval = 1;
-			if(node->onpodevent.type == T_PROC_POD_STRING){
-				node->onpodevent.value.str.mmapedfd64_r = node->onpodevent.value.str.mmapedfd64_w = -1;
-				node->onpodevent.value.str.mmapedfd64_r = procfuse_openTempFile("podstring", PROCFUSE_YES);
-
-				node->onpodevent.value.str.length_r = node->onpodevent.value.str.length_w = 4*1024*1024;
-				if(node->onpodevent.value.str.mmapedfd64_r==-1 ||
-				   ftruncate(node->onpodevent.value.str.mmapedfd64_r, node->onpodevent.value.str.length_r)==-1 ||
-				   (node->onpodevent.value.str.mmapedbuffer_r = (char*)mmap(NULL, node->onpodevent.value.str.length_r, PROT_READ | PROT_WRITE,
-																			MAP_SHARED, node->onpodevent.value.str.mmapedfd64_r, 0))==NULL){
-					if(node->onpodevent.value.str.mmapedfd64_r!=-1){
-						close(node->onpodevent.value.str.mmapedfd64_r);
-					}
+		if (i <= PARSE_POW5_LARGEST) {
+			parse_bignum_bits(pow5, count, (int) length - 128, parse_pow5_128[i - PARSE_POW5_SMALLEST]);
+		}
 
-					rval = 0;
+		if (i > 0) {
+			/* floor(2^(length + 127) / 5^i) by long division, starting at 2^length */
+			quotient = parse_pow5_128[-(int) i - PARSE_POW5_SMALLEST];
+			memset(remainder, 0, sizeof(remainder));
+			remainder[length >> 5] = (uint32_t) 1 << (length & 31);
+			quotient[0] = 0;
+			quotient[1] = 0;
+			for (s = 0; s < 128; ++s) {
+				if (s > 0) {
+					parse_bignum_shl1(remainder, count);
+					quotient[0] = (quotient[0] << 1) | (quotient[1] >> 63);
+					quotient[1] <<= 1;
+				}
+				if (!parse_bignum_less(remainder, pow5, count)) {
+					parse_bignum_sub(remainder, pow5, count);
+					quotient[1] |= 1;
 				}
+			}
 
+			/* the approximation is rounded up: for 5^27 and below by one, beyond that by one in the
+			 * length + 1 bits following the truncated ones, which only carries if all of them are set */
+			round_up = 1;
+			for (s = 0; i > 27 && s <= length && round_up; ++s) {
+				parse_bignum_shl1(remainder, count);
+				if (!parse_bignum_less(remainder, pow5, count)) {
+					parse_bignum_sub(remainder, pow5, count);
+				} else {
+					round_up = 0;
+				}
 			}
-			if(node->onpodevent.type!=T_PROC_POD_CHAR && node->onpodevent.type!=T_PROC_POD_STRING &&
-			   procfuse_ctorht(&node->transactions, PROCFUSE_NO)==0){
-				rval = 0;
+			if (round_up) {
+				quotient[1] += 1;
+				quotient[0] += (quotient[1] == 0);
 			}
 		}
 
-		if(rval==0)
-			procfuse_unregisterNodeInternal(pf->root, absolutepath); /* clean up unneeded tree structures */
+		carry = 0;
+		for (w = 0; w < PARSE_BIGNUM_WORDS; ++w) {
+			carry += (uint64_t) pow5[w] * 5;
+			pow5[w] = (uint32_t) carry;
+			carry >>= 32;
+		}
 	}
+}
 
-	pthread_mutex_unlock(&pf->lock);
+/* the low half of a * b, the high half is stored in high */
+#if defined(__SIZEOF_INT128__)
 
-	return rval;
-}
+__extension__ typedef unsigned __int128 parse_uint128;
 
-int procfuse_createPOD_c(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_c onModify){
-	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_CHAR);
-}
-int procfuse_createPOD_i(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_i onModify){
-	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_INT);
-}
-int procfuse_createPOD_i64(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_i64 onModify){
-	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_INT64);
-}
-int procfuse_createPOD_f(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_f onModify){
-	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_FLOAT);
-}
-int procfuse_createPOD_d(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_d onModify){
-	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_DOUBLE);
-}
-int procfuse_createPOD_ld(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_ld onModify){
-	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_LONGDOUBLE);
+static uint64_t parse_umul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+	const parse_uint128 product = (parse_uint128) a * b;
+
+	*high = (uint64_t) (product >> 64);
+
+	return (uint64_t) product;
 }
-int procfuse_createPOD_s(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_s onModify){
-	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_STRING);
+
+#else
+
+static uint64_t parse_umul128(uint64_t a, uint64_t b, uint64_t *high)
+{
+	const uint64_t a_lo = (uint32_t) a, a_hi = a >> 32;
+	const uint64_t b_lo = (uint32_t) b, b_hi = b >> 32;
+	const uint64_t b00 = a_lo * b_lo, b01 = a_lo * b_hi;
+	const uint64_t b10 = a_hi * b_lo, b11 = a_hi * b_hi;
+	const uint64_t mid1 = b10 + (b00 >> 32);
+	const uint64_t mid2 = b01 + (uint32_t) mid1;
+
+	*high = b11 + (mid1 >> 32) + (mid2 >> 32);
+
+	return (mid2 << 32) | (uint32_t) b00;
 }
 
-int procfuse_unlink(struct procfuse *pf, const char *absolutepath){
-	int rval = 0;
-	int unlinknode = 0;
-	struct procfuse_hashnode *node = NULL;
+#endif
 
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
+/* the properties of a binary floating point format the algorithm depends on */
+struct parse_binary_format {
+	int mantissa_bits;
+	int minimum_exponent;
+	int infinite_power;
+	int64_t smallest_power10;
+	int64_t largest_power10;
+	int64_t min_round_to_even;
+	int64_t max_round_to_even;
+};
+
+static const struct parse_binary_format parse_binary64 = { 52, -1023, 0x7ff, -342, 308, -4, 23 };
+static const struct parse_binary_format parse_binary32 = { 23, -127, 0xff, -65, 38, -17, 10 };
+
+/* the bits without the sign of w * 10^q rounded to nearest, w has at most 19 digits */
+static uint64_t parse_eisel_lemire(uint64_t w, int64_t q, const struct parse_binary_format *binary)
+{
+	const uint64_t *pow5;
+	const uint64_t precision_mask = UINT64_MAX >> (binary->mantissa_bits + 3);
+	uint64_t high, low, second_high, mantissa;
+	int64_t power2;
+	int lz, upperbit, shift;
+
+	if (w == 0 || q < binary->smallest_power10) {
 		return 0;
 	}
+	if (q > binary->largest_power10) {
+		return (uint64_t) binary->infinite_power << binary->mantissa_bits;
+	}
 
-	pthread_mutex_lock(&pf->lock);
+	lz = __builtin_clzll(w);
+	w <<= lz;
 
-	node = procfuse_pathToNode(pf->root, absolutepath, PROCFUSE_NO);
-	if(node!=NULL){
-		pthread_rwlock_wrlock(&node->lock);
+	pow5 = parse_pow5_128[q - PARSE_POW5_SMALLEST];
+	low = parse_umul128(w, pow5[0], &high);
+	if ((high & precision_mask) == precision_mask) {
+		/* the bits below the mantissa might carry, the low half of the power decides */
+		parse_umul128(w, pow5[1], &second_high);
+		low += second_high;
+		if (second_high > low) {
+			++high;
+		}
+	}
 
-		node->pendingforunlink = PROCFUSE_YES;
+	upperbit = (int) (high >> 63);
+	shift = upperbit + 64 - binary->mantissa_bits - 3;
+	mantissa = high >> shift;
+	/* floor(log2(10^q)) + 63 */
+	power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz - binary->minimum_exponent;
 
-		if(node->concurrent_access_counter<=0){
-			unlinknode = 1;
+	if (power2 <= 0) {
+		/* subnormal, rounding up to the smallest normal number carries into the exponent */
+		if (-power2 + 1 >= 64) {
+			return 0;
 		}
+		mantissa >>= -power2 + 1;
+		mantissa += (mantissa & 1);
+		mantissa >>= 1;
+		return mantissa;
+	}
 
-		pthread_rwlock_unlock(&node->lock);
+	/* exactly halfway between two values, which is only possible if 5^q fits into 64 bits */
+	if (low <= 1 && q >= binary->min_round_to_even && q <= binary->max_round_to_even &&
+	    (mantissa & 3) == 1 && (mantissa << shift) == high) {
+		mantissa &= ~(uint64_t) 1;
 	}
 
-	if(unlinknode){
-	    rval = procfuse_unregisterNodeInternal(pf->root, absolutepath);
+	mantissa += (mantissa & 1);
+	mantissa >>= 1;
+	if (mantissa >= ((uint64_t) 2 << binary->mantissa_bits)) {
+		mantissa = (uint64_t) 1 << binary->mantissa_bits;
+		++power2;
 	}
+	mantissa &= ~((uint64_t) 1 << binary->mantissa_bits);
 
-	pthread_mutex_unlock(&pf->lock);
+	if (power2 >= binary->infinite_power) {
+		return (uint64_t) binary->infinite_power << binary->mantissa_bits;
+	}
 
-	return rval;
+	return ((uint64_t) power2 << binary->mantissa_bits) | mantissa;
 }
 
-struct procfuse_hashnode* procfuse_acquireAccessToNode(struct procfuse *pf, const char *absolutepath){
-	struct procfuse_hashnode *node = NULL;
+/* a number split into significand and decimal exponent */
+struct parse_decimal {
+	uint64_t mantissa;
+	int64_t exponent;
+	int negative;
+	int many_digits; /* more than 19 significant digits, mantissa is useless */
+	int special; /* 1 for an infinity, 2 for a NaN */
+	const char *end;
+};
 
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return NULL;
+/* the length of word at p ignoring case, 0 if p doesn't start with it */
+static size_t parse_match(const char *p, const char *last, const char *word)
+{
+	size_t length = strlen(word), i;
+
+	if ((size_t) (last - p) < length) {
+		return 0;
+	}
+	for (i = 0; i < length; ++i) {
+		if ((p[i] | 0x20) != word[i]) {
+			return 0;
+		}
 	}
 
-	/* acquire outer global filesystem lock */
-	pthread_mutex_lock(&pf->lock);
+	return length;
+}
 
-	/* search node */
-	node = procfuse_pathToNode(pf->root, absolutepath, PROCFUSE_NO);
-	if(node!=NULL){
-		/* acquire inner node lock */
-		pthread_rwlock_wrlock(&node->lock);
-		/* and increase access counter */
-		node->concurrent_access_counter++;
-		/* release inner node lock */
-		pthread_rwlock_unlock(&node->lock);
+/* the digits at p accumulated into mantissa, returns their end */
+static const char *parse_digits(const char *p, const char *last, uint64_t *mantissa)
+{
+	uint64_t result = *mantissa;
 
-		/* acquire read only lock!! and leave it that */
-		pthread_rwlock_rdlock(&node->lock);
+#ifdef PARSE_SWAR
+	while (last - p >= 8 && parse_is_eight_digits(parse_load8(p))) {
+		result = result * 100000000 + parse_eight_digits(parse_load8(p));
+		p += 8;
 	}
-	/* realease outer lock */
-	pthread_mutex_unlock(&pf->lock);
+#endif
+	while (p != last && parse_is_digit(*p)) {
+		result = result * 10 + (uint64_t) (*p - '0');
+		++p;
+	}
+	*mantissa = result;
 
-	return node;
+	return p;
 }
 
-struct procfuse_hashnode* procfuse_upgradeNodeReadLockToWriteLock(struct procfuse_hashnode *node){
-	if(node==NULL){
-		errno = -EINVAL;
-		return NULL;
-	}
+static int parse_decimal(const char *first, const char *last, struct parse_decimal *decimal)
+{
+	const char *p = first, *digits, *fraction, *e;
+	int64_t digit_count, exponent_number;
+	size_t length;
+	int negative_exponent;
 
-	pthread_rwlock_unlock(&node->lock);
-	pthread_rwlock_wrlock(&node->lock);
+	memset(decimal, 0, sizeof(*decimal));
 
-	return node;
-}
-struct procfuse_hashnode* procfuse_downgradeNodeWriteLockToReadLock(struct procfuse_hashnode *node){
-	if(node==NULL){
-		errno = -EINVAL;
-		return NULL;
+	if (p != last && (*p == '-' || *p == '+')) {
+		decimal->negative = (*p == '-');
+		++p;
 	}
 
-	pthread_rwlock_unlock(&node->lock);
-	pthread_rwlock_rdlock(&node->lock);
+	if ((length = parse_match(p, last, "inf")) != 0) {
+		decimal->special = 1;
+		p += length;
+		p += parse_match(p, last, "inity");
+		decimal->end = p;
+		return 0;
+	}
+	if ((length = parse_match(p, last, "nan")) != 0) {
+		decimal->special = 2;
+		decimal->end = p + length;
+		return 0;
+	}
 
-	return node;
-}
+	digits = p;
+	p = parse_digits(p, last, &decimal->mantissa);
+	digit_count = p - digits;
 
-void procfuse_releaseAccessToNode(struct procfuse *pf, struct procfuse_hashnode *node){
-	int unlinknode = PROCFUSE_NO;
+	if (p != last && *p == '.') {
+		fraction = ++p;
+		p = parse_digits(p, last, &decimal->mantissa);
+		decimal->exponent = fraction - p;
+		digit_count += p - fraction;
+	}
+	if (digit_count == 0) {
+		return EINVAL;
+	}
 
-	if(pf==NULL || node==NULL){
-		errno = EINVAL;
-		return;
+	/* an exponent without digits isn't part of the number */
+	if (p != last && (*p == 'e' || *p == 'E')) {
+		e = p + 1;
+		negative_exponent = 0;
+		if (e != last && (*e == '-' || *e == '+')) {
+			negative_exponent = (*e == '-');
+			++e;
+		}
+		if (e != last && parse_is_digit(*e)) {
+			exponent_number = 0;
+			while (e != last && parse_is_digit(*e)) {
+				if (exponent_number < 0x10000000) {
+					exponent_number = exponent_number * 10 + (*e - '0');
+				}
+				++e;
+			}
+			decimal->exponent += negative_exponent ? -exponent_number : exponent_number;
+			p = e;
+		}
 	}
+	decimal->end = p;
 
-	/* first relase the read only lock!! */
-	pthread_rwlock_unlock(&node->lock);
+	if (digit_count > 19) {
+		/* leading zeros aren't significant */
+		while (digits != p && (*digits == '0' || *digits == '.')) {
+			digit_count -= (*digits == '0');
+			++digits;
+		}
+		decimal->many_digits = (digit_count > 19);
+	}
 
-	/* acquire outer global filesystem lock */
-	pthread_mutex_lock(&pf->lock);
+	return 0;
+}
 
-	/* search node */
-	/* acquire inner node lock */
-	pthread_rwlock_wrlock(&node->lock);
-	/* and decrease access counter */
-	node->concurrent_access_counter--;
+/* a null terminated copy of the text for strtod, in buffer if it fits */
+static char *parse_copy(const char *first, const char *last, char *buffer, size_t size)
+{
+	const size_t length = (size_t) (last - first);
+	char *text = buffer;
 
-	if(node->concurrent_access_counter<=0 &&
-	   node->pendingforunlink==PROCFUSE_YES &&
-	   node->transactions!=NULL && hash_table_num_entries(node->transactions)<=0){
-		unlinknode = PROCFUSE_YES;
+	if (length >= size) {
+		text = (char *) malloc(length + 1);
+		if (text == NULL) {
+			return NULL;
+		}
 	}
+	memcpy(text, first, length);
+	text[length] = '\0';
 
-	/* release inner node lock */
-	pthread_rwlock_unlock(&node->lock);
+	return text;
+}
 
-	if(unlinknode==PROCFUSE_YES){
-		/* why is it safe to unlink the node from the hashmap here?
-		 * as the decision of unlinknode=PROCFUSE_YES is done a few lines above
-		 * a lock is held on pf->lock AND exclusive lock on node->lock
-		 * at that time, no one else has access to the node object, not because the lock was held!
-		 * but because concurrent_access_counter<=0 and no "procfuse file system user" is accessing
-		 * this file cause of hash_table_num_entries <= 0
-		 *
-		 * thus we could be sure that we're the only ones having absolute exclusive access to the node
-		 *
-		 * if by the time of releasing the lock above and unlinking in the next line would have acquired the lock
-		 * e.g. cause of calling procfuse_upgradeNodeReadLockToWriteLock this upgrade would count as concurrent_access_counter
-		 * and thus unlinknode wouldn't have been set
-		 *
-		 * so every "new" access would have been blocked and concurrent access wouldn't lead to the next line unlinking the node
-		 */
-		procfuse_unregisterNodeInternal(pf->root, node->absolutepath);
-	}
+#ifdef PARSE_EXACT_ARITHMETIC
+static const double parse_double_powers10[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const float parse_float_powers10[11] = {
+	1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+#endif
 
-	/* realease outer lock */
-	pthread_mutex_unlock(&pf->lock);
+int parse_double(const char *first, const char *last, double *value, const char **end)
+{
+	struct parse_decimal decimal;
+	char buffer[64], *text;
+	uint64_t bits;
+	double result;
+
+	if (parse_decimal(first, last, &decimal) != 0) {
+		if (end != NULL) {
+			*end = first;
+		}
+		return EINVAL;
+	}
+	if (end != NULL) {
+		*end = decimal.end;
+	}
+
+	if (decimal.special) {
+		bits = (decimal.special == 1) ? 0x7FF0000000000000ULL : 0x7FF8000000000000ULL;
+	} else if (decimal.many_digits) {
+		text = parse_copy(first, decimal.end, buffer, sizeof(buffer));
+		if (text == NULL) {
+			return ENOMEM;
+		}
+		result = strtod(text, NULL);
+		if (text != buffer) {
+			free(text);
+		}
+		memcpy(&bits, &result, sizeof(bits));
+		if ((bits & 0x7FF0000000000000ULL) == 0x7FF0000000000000ULL) {
+			return ERANGE;
+		}
+		*value = result;
+		return 0;
+	}
+#ifdef PARSE_EXACT_ARITHMETIC
+	else if (decimal.exponent >= -22 && decimal.exponent <= 22 && decimal.mantissa <= ((uint64_t) 1 << 53)) {
+		result = (double) decimal.mantissa;
+		if (decimal.exponent < 0) {
+			result /= parse_double_powers10[-decimal.exponent];
+		} else {
+			result *= parse_double_powers10[decimal.exponent];
+		}
+		*value = decimal.negative ? -result : result;
+		return 0;
+	}
+#endif
+	else {
+		pthread_once(&parse_tables_once, parse_init_tables);
+		bits = parse_eisel_lemire(decimal.mantissa, decimal.exponent, &parse_binary64);
+		if ((bits >> 52) == 0x7FF) {
+			return ERANGE;
+		}
+	}
+
+	bits |= (uint64_t) decimal.negative << 63;
+	memcpy(value, &bits, sizeof(bits));
+
+	return 0;
 }
 
-struct procfuse_accessor procfuse_accessor(procfuse_onFuseOpen onFuseOpen, procfuse_onFuseTruncate onFuseTruncate,
-                                           procfuse_onFuseRead onFuseRead, procfuse_onFuseWrite onFuseWrite,
-                                           procfuse_onFuseRelease onFuseRelease){
-	struct procfuse_accessor access;
-	memset(&access, '\0', sizeof(access));
+int parse_float(const char *first, const char *last, float *value, const char **end)
+{
+	struct parse_decimal decimal;
+	char buffer[64], *text;
+	uint32_t bits;
+	float result;
+
+	if (parse_decimal(first, last, &decimal) != 0) {
+		if (end != NULL) {
+			*end = first;
+		}
+		return EINVAL;
+	}
+	if (end != NULL) {
+		*end = decimal.end;
+	}
 
-	access.onFuseOpen = onFuseOpen;
-	access.onFuseTruncate = onFuseTruncate;
-	access.onFuseRead = onFuseRead;
-	access.onFuseWrite = onFuseWrite;
-	access.onFuseRelease = onFuseRelease;
+	if (decimal.special) {
+		bits = (decimal.special == 1) ? 0x7F800000U : 0x7FC00000U;
+	} else if (decimal.many_digits) {
+		text = parse_copy(first, decimal.end, buffer, sizeof(buffer));
+		if (text == NULL) {
+			return ENOMEM;
+		}
+		result = strtof(text, NULL);
+		if (text != buffer) {
+			free(text);
+		}
+		memcpy(&bits, &result, sizeof(bits));
+		if ((bits & 0x7F800000U) == 0x7F800000U) {
+			return ERANGE;
+		}
+		*value = result;
+		return 0;
+	}
+#ifdef PARSE_EXACT_ARITHMETIC
+	else if (decimal.exponent >= -10 && decimal.exponent <= 10 && decimal.mantissa <= ((uint64_t) 1 << 24)) {
+		result = (float) decimal.mantissa;
+		if (decimal.exponent < 0) {
+			result /= parse_float_powers10[-decimal.exponent];
+		} else {
+			result *= parse_float_powers10[decimal.exponent];
+		}
+		*value = decimal.negative ? -result : result;
+		return 0;
+	}
+#endif
+	else {
+		pthread_once(&parse_tables_once, parse_init_tables);
+		bits = (uint32_t) parse_eisel_lemire(decimal.mantissa, decimal.exponent, &parse_binary32);
+		if ((bits >> 23) == 0xFF) {
+			return ERANGE;
+		}
+	}
 
-	return access;
+	bits |= (uint32_t) decimal.negative << 31;
+	memcpy(value, &bits, sizeof(bits));
+
+	return 0;
 }
 
-int procfuse_copyPOD(procfuse_pod_t dst_type, union procfuse_pod *dstpod, procfuse_pod_t src_type, union procfuse_pod *srcpod){
-	int rval = 0, printed = 0;
-	switch(src_type){
-	    case T_PROC_POD_CHAR:
-	    	switch(dst_type){
-				case T_PROC_POD_CHAR:
-					dstpod->c = srcpod->c;
-					rval = 1;
-					break;
-				case T_PROC_POD_INT:
-					dstpod->i = (int)srcpod->c;
-					rval = 1;
-					break;
-	    	    case T_PROC_POD_INT64:
-	    	    	dstpod->l = (int64_t)srcpod->c;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_FLOAT:
-	    	    	dstpod->f = (float)srcpod->c;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_DOUBLE:
-	    	    	dstpod->d = (double)srcpod->c;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_LONGDOUBLE:
-	    	    	dstpod->ld = (long double)srcpod->c;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_STRING:
-					if(dstpod->str.length_r>=1){
-						dstpod->str.mmapedbuffer_r[0] = srcpod->c;
-						dstpod->str.length_r = 1;
-						rval = 1;
-					}
-	    	    	break;
-	    	    default: break;
-	    	}
-	    	break;
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
 
-	    case T_PROC_POD_INT:
-	    	switch(dst_type){
-				case T_PROC_POD_INT:
-					dstpod->i = srcpod->i;
-					rval = 1;
-					break;
-	    	    case T_PROC_POD_INT64:
-	    	    	dstpod->l = srcpod->i;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_FLOAT:
-	    	    	dstpod->f = (float)srcpod->i;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_DOUBLE:
-	    	    	dstpod->d = srcpod->i;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_LONGDOUBLE:
-	    	    	dstpod->ld = srcpod->i;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_STRING:
-	    	    	printed = snprintf(dstpod->str.mmapedbuffer_r,
-	    	    			           dstpod->str.length_r, "%d", srcpod->i);
-	    	    	/* if successfully written */
-	    	    	if(printed>0 && printed<dstpod->str.length_r){
-	    	    		dstpod->str.length_r = printed;
-	    	    		rval = 1;
-	    	    	}
-	    	    	else{
-	    	    		rval = printed;
-	    	    	}
-	    	    	break;
-	    	    default: break;
-	    	}
-	    	break;
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
 
-	    case T_PROC_POD_INT64:
-	    	switch(dst_type){
-	    	    case T_PROC_POD_INT64:
-	    	    	dstpod->l = srcpod->l;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_FLOAT:
-	    	    	if(sizeof(dstpod->f)>=sizeof(srcpod->l)){
-						dstpod->f = (float)srcpod->l;
-						rval = 1;
-	    	    	}
-	    	    	break;
-	    	    case T_PROC_POD_DOUBLE:
-					dstpod->d = srcpod->l;
-					rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_LONGDOUBLE:
-	    	    	dstpod->ld = srcpod->l;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_STRING:
-	    	    	printed = snprintf(dstpod->str.mmapedbuffer_r,
-	    	    			           dstpod->str.length_r, "%"PRId64, srcpod->l);
-	    	    	/* if successfully written */
-	    	    	if(printed>0 && printed<dstpod->str.length_r){
-	    	    		dstpod->str.length_r = printed;
-	    	    		rval = 1;
-	    	    	}
-	    	    	else{
-	    	    		rval = printed;
-	    	    	}
-	    	    	break;
-	    	    default: break;
-	    	}
-	    	break;
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
 
-		case T_PROC_POD_FLOAT:
-	    	switch(dst_type){
-				case T_PROC_POD_FLOAT:
-					dstpod->f = srcpod->f;
-					rval = 1;
-					break;
-	    	    case T_PROC_POD_DOUBLE:
-	    	    	dstpod->d = srcpod->f;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_LONGDOUBLE:
-	    	    	dstpod->ld = srcpod->f;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_STRING:
-	    	    	printed = snprintf(dstpod->str.mmapedbuffer_r,
-	    	    			           dstpod->str.length_r, "%g", srcpod->f);
-	    	    	/* if successfully written */
-	    	    	if(printed>0 && printed<dstpod->str.length_r){
-	    	    		dstpod->str.length_r = printed;
-	    	    		rval = 1;
-	    	    	}
-	    	    	else{
-	    	    		rval = printed;
-	    	    	}
-	    	    	break;
-	    	    default: break;
-	    	}
-			break;
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
 
-	    case T_PROC_POD_DOUBLE:
-	    	switch(dst_type){
-	    	    case T_PROC_POD_DOUBLE:
-	    	    	dstpod->d = srcpod->d;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_LONGDOUBLE:
-	    	    	dstpod->ld = srcpod->d;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_STRING:
-	    	    	printed = snprintf(dstpod->str.mmapedbuffer_r,
-	    	    			           dstpod->str.length_r, "%g", srcpod->d);
-	    	    	/* if successfully written */
-	    	    	if(printed>0 && printed<dstpod->str.length_r){
-	    	    		dstpod->str.length_r = printed;
-	    	    		rval = 1;
-	    	    	}
-	    	    	else{
-	    	    		rval = printed;
-	    	    	}
-	    	    	break;
-	    	    default: break;
-	    	}
-	    	break;
 
-	    case T_PROC_POD_LONGDOUBLE:
-	    	switch(dst_type){
-	    	    case T_PROC_POD_LONGDOUBLE:
-	    	    	dstpod->ld = srcpod->ld;
-	    	    	rval = 1;
-	    	    	break;
-	    	    case T_PROC_POD_STRING:
-	    	    	printed = snprintf(dstpod->str.mmapedbuffer_r,
-	    	    			           dstpod->str.length_r, "%Le", srcpod->ld);
-	    	    	/* if successfully written */
-	    	    	if(printed>0 && printed<dstpod->str.length_r){
-	    	    		dstpod->str.length_r = printed;
-	    	    		rval = 1;
-	    	    	}
-	    	    	else{
-	    	    		rval = printed;
-	    	    	}
-	    	    	break;
-	    	    default: break;
-	    	}
-	    	break;
+#ifndef _LARGEFILE64_SOURCE
+#define _LARGEFILE64_SOURCE
+#endif
 
-	    case T_PROC_POD_STRING:
-	    	if(dst_type==T_PROC_POD_CHAR && srcpod->str.length_w==1){
-	    		dstpod->c = srcpod->str.mmapedbuffer_w[0];
-	    		rval = 1;
-	    	}
-	    	else if(dst_type==T_PROC_POD_STRING && dstpod->str.length_r >= srcpod->str.length_w){
-	    		memcpy(dstpod->str.mmapedbuffer_r, srcpod->str.mmapedbuffer_w, srcpod->str.length_w);
-	    		dstpod->str.length_r = srcpod->str.length_w;
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sched.h>
+
+
+#ifndef FUSE_USE_VERSION
+#define FUSE_USE_VERSION 26
+#endif
+
+#include <fuse.h>
+#include <fuse_lowlevel.h>
+
+
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <signal.h>
+#include <sys/mount.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <stdint.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <sys/time.h>
+#include <stdarg.h>
+#include <sys/sysinfo.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <unistd.h>
+#include <poll.h>
+#include <float.h>
+
+
+
+#define PROCFUSE_DELIMC '/'
+#define PROCFUSE_DELIMS "/"
+
+/* gives a new /dev/fuse file descriptor its own request queue of the connection the passed one belongs to */
+#ifndef FUSE_DEV_IOC_CLONE
+#define FUSE_DEV_IOC_CLONE _IOR(229, 0, uint32_t)
+#endif
+
+#define PROCFUSE_FNAMELEN 512
+#define PROCFUSE_PATHLEN 4096
+
+/* bits of procfuse_hashnode.pinstate, the lower bits count the pins (accesses) of the node */
+#define PROCFUSE_PIN_COUNT    0x0FFFFFFFu
+#define PROCFUSE_PIN_INODE    0x10000000u /* the node is registered in pf->inodes */
+#define PROCFUSE_PIN_DETACHED 0x20000000u /* the node has been removed from the tree, its memory is released once it's neither pinned nor in pf->inodes */
+#define PROCFUSE_PIN_UNLINK  0x40000000u /* procfuse_unlink() has been called, the node is removed when the last pin is dropped */
+#define PROCFUSE_PIN_CLAIMED 0x80000000u /* one thread is about to remove the node */
+
+typedef enum { T_PROC_POD_NO=0, T_PROC_POD_CHAR, T_PROC_POD_INT, T_PROC_POD_INT64,
+	                  T_PROC_POD_FLOAT, T_PROC_POD_DOUBLE, T_PROC_POD_LONGDOUBLE,
+	                  T_PROC_POD_STRING, T_PROC_POD_ARRAY, T_PROC_POD_RECORD,
+	                  T_PROC_POD_BINARY, T_PROC_POD_MAX} procfuse_pod_t;
+
+/* the children of a directory in the order they were created, readdir offsets are inode numbers
+ * inode numbers increase with every created node, so appending keeps the entries ordered and a listing
+ * resumes after the last entry it returned, no matter what has been created or removed in between
+ */
+struct procfuse_direntry{
+	fuse_ino_t ino;
+	struct procfuse_hashnode *node; /* NULL once removed, until the index is compacted */
+};
+struct procfuse_dirindex{
+	struct procfuse_direntry *entries;
+	size_t count;
+	size_t capacity;
+	size_t removed;
+};
+
+struct procfuse{
+	HashTable *root;
+	struct procfuse_dirindex rootindex; /* the children of root */
+	HashTable *paths; /* normalized absolute path => node, for every node of the tree below root */
+	HashTable *inodes; /* inode number => node, also holds removed nodes as long as the kernel references them */
+	HashTable *atoms; /* path component => procfuse_atom, every distinct file name is stored once */
+	fuse_ino_t inocounter;
+	/* tree lock: path lookups take it shared, only creating and removing nodes takes it exclusive */
+	pthread_rwlock_t lock;
+	/* protects the poll handles of the open files, see procfuse_pollFileHandle() */
+	pthread_mutex_t polllock;
+
+	/* fixed size objects are allocated from these instead of malloc() */
+	Slab *nodeslab;
+	Slab *transactionslab;
+	Slab *writebufferslab;
+
+	int64_t tidcounter;
+
+	int running;
+	pthread_t procfuseth;
+	struct fuse *fuse;
+	struct fuse_session *session; /* instead of fuse if the low level backend is used */
+	struct fuse_chan *chan;
+	pthread_mutex_t fuselock;
+
+	int fuseArgc;
+	const char *fuseArgv[9];
+	char *fuse_option;
+	int fuse_singlethreaded;
+	int fuse_lowlevel;
+	unsigned int fuse_workers; /* 0 if libfuse's multi threaded loop is used, see procfuse_setWorkers() */
+	int fuse_clonefd;
+	int fuse_pincpu;
+
+	char *absolutemountpoint;
+	struct fuse_operations procFS_oper;
+	struct fuse_lowlevel_ops procFS_lloper;
+
+	const void *appdata;
+	pthread_key_t key_thread_local_storage;
+};
+
+/* an interned path component, the directory tables are keyed by the atom pointer
+ * so probing them neither hashes nor compares the name again
+ * atoms are only created with pf->lock held exclusively and live until procfuse_dtor()
+ */
+struct procfuse_atom{
+	unsigned long hash;
+	unsigned int length;
+	char name[1]; /* allocated to hold the whole name */
+};
+
+struct procfuse_threadlocalstorage{
+	struct procfuse_error error;
+};
+
+struct procfuse_pod_string{
+	int mmapedfd64_r;
+    char *mmapedbuffer_r;
+    int64_t length_r;
+
+	int mmapedfd64_w;
+    char *mmapedbuffer_w;
+    int64_t length_w;
+};
+
+union procfuse_pod{
+	char c;
+	int i;
+	int64_t l;
+	float f;
+	double d;
+	long double ld;
+	struct procfuse_pod_string str;
+	struct procfuse_pod_array *array;
+	struct procfuse_pod_record *record;
+};
+
+typedef int (*procfuse_onModify)(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata, ...);
+
+struct procfuse_pod_accessor{
+	procfuse_onModify onModify; /* modify function corresponding to 'procfuse_pod_t type' */
+
+	union procfuse_pod value;
+
+	procfuse_pod_t type;
+
+	pthread_rwlock_t rwlock;
+	unsigned int seq; /* seqlock sequence for values which can't be accessed atomically, odd while written */
+};
+
+/* the elements of an array POD, the file shows one element per line
+ * writers store an element and set its dirty bit, both atomically and without any lock
+ * readers render the dirty elements again and keep the offset every line starts at, so a read at an offset
+ * finds its first line by binary search instead of formatting the lines in front of it
+ */
+#define PROCFUSE_ARRAYLINELEN FORMAT_NUMBER_MAX /* room for the text of an element and its newline */
+
+struct procfuse_pod_array{
+	procfuse_pod_t type; /* of the elements, T_PROC_POD_INT, T_PROC_POD_INT64, T_PROC_POD_FLOAT or T_PROC_POD_DOUBLE */
+	size_t length;
+	void *values;
+	uint64_t *dirty; /* one bit per element */
+
+	pthread_mutex_t lock; /* protects the rendered text */
+	char *text; /* PROCFUSE_ARRAYLINELEN bytes per element */
+	unsigned char *textlength;
+	uint64_t *linestart; /* length+1 offsets, linestart[length] is the size of the file */
+	size_t validstart; /* linestart is up to date up to this element */
+};
+
+/* the fields of a record POD live in a struct of the application, the file shows one "name value" line per field
+ * the application changes the fields between procfuse_lockRecord() and procfuse_unlockRecord(), the file is rendered
+ * and written with the same lock held
+ */
+#define PROCFUSE_RECORDVALUELEN 64 /* room for the text of a value, long doubles included */
+struct procfuse_pod_record{
+	pthread_mutex_t lock;
+	struct procfuse_field *fields; /* a copy of the fields passed to procfuse_createRecord(), names included */
+	size_t count;
+	void *data;
+	char *text; /* the rendered lines */
+	size_t textsize; /* the longest the lines can get */
+};
+
+#define PROCFUSE_WRITEBUFFERLEN 8192
+
+struct procfuse_transactionnode{
+	struct procfuse *pf;
+	char *writebuffer;
+	int length;
+	int haswritten;
+
+	int64_t tid; /* key */
+};
+
+struct procfuse_hashnode{
+	pthread_rwlock_t lock;
+
+	struct procfuse *pf;
+
+	char *absolutepath;
+
+    HashTable *subdirs;
+    struct procfuse_dirindex index; /* the children of subdirs in creation order */
+
+    HashTable *transactions;
+
+	struct procfuse_pod_accessor onpodevent;
+	struct procfuse_accessor onevent;
+
+	mode_t mode;
+	uid_t uid;
+    gid_t gid;
+    struct timeval created;
+	struct timeval access;
+	struct timeval modify;
+
+	int flags;  /* one of O_RDONLY,  O_WRONLY,  or  O_RDWR*/
+
+	struct procfuse_atom *key; /* the last component of absolutepath */
+	struct procfuse_cachepolicy cache;
+	int passthrough; /* PROCFUSE_YES if open files are served from the page cache, see procfuse_setPassthrough() */
+	int snapshot; /* PROCFUSE_YES if the content is rendered once per open, see procfuse_setSnapshot() */
+	int backed; /* PROCFUSE_YES for nodes created by procfuse_createBacked() */
+	int backingfd;
+
+	unsigned int generation; /* incremented by every change of the content, see procfuse_changeNode() */
+	unsigned int invalidated; /* PROCFUSE_YES from an invalidation by a pod handle until the kernel fetches the node again */
+	uint64_t renderedsize; /* generation+1 in the upper, the rendered length of a numeric POD in the lower half */
+	struct procfuse_filehandle *pollers; /* open files waiting for a change, protected by pf->polllock */
+
+	/* pin counter and deferred unlink flags, only accessed atomically - see PROCFUSE_PIN_* */
+	unsigned int pinstate;
+
+	fuse_ino_t ino;
+	unsigned long nlookup; /* number of lookups the kernel hasn't sent a forget for yet */
+};
+
+/* stored in fi->fh of every open file, the node is resolved once at open and stays pinned
+ * (counted in pinstate) until the file is released
+ */
+struct procfuse_filehandle{
+	struct procfuse_hashnode *node;
+	int64_t tid;
+
+	unsigned int seen; /* the generation of the node last read from the beginning */
+	struct fuse_pollhandle *ph; /* if not NULL the file is linked into node->pollers */
+	struct procfuse_filehandle *nextpoller;
+
+	/* the content rendered at open if snapshots are enabled for the node, reads are served from it
+	 * buffers of PROCFUSE_WRITEBUFFERLEN bytes are taken from pf->writebufferslab, larger ones are malloc'ed
+	 */
+	char *snapshot;
+	size_t snapshotlength;
+	size_t snapshotsize;
+	unsigned int snapshotgeneration;
+	pthread_mutex_t snapshotlock;
+};
+
+
+int procfuse_onFuseOpenPOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata);
+int procfuse_onFuseReadPOD(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+int procfuse_onFuseWritePOD(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+int procfuse_onFuseTruncatePOD(const struct procfuse *pf, const char *path, const off_t off, const void* appdata);
+int procfuse_onFuseReleasePOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata);
+int procfuse_onFuseReadBacked(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+int procfuse_onFuseWriteBacked(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+int procfuse_onFuseTruncateBacked(const struct procfuse *pf, const char *path, const off_t off, const void* appdata);
+int procfuse_renderPOD(procfuse_pod_t type, const union procfuse_pod *value, char *buffer, size_t size);
+int procfuse_parsePOD(procfuse_pod_t type, const char *text, size_t length, union procfuse_pod *value, const char **end);
+int procfuse_isBlank(char c);
+int procfuse_onFuseReadPODArray(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+int procfuse_onFuseWritePODArray(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+void procfuse_freePODArray(struct procfuse_pod_array *array);
+int procfuse_onFuseReadPODRecord(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+int procfuse_onFuseWritePODRecord(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+void procfuse_freePODRecord(struct procfuse_pod_record *record);
+int procfuse_onFuseReadBinaryView(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
+size_t procfuse_renderPODRecord(struct procfuse_pod_record *record);
+
+/* releases the content of a pod node, nobody else may use the node */
+void procfuse_releasePODValue(struct procfuse_hashnode *node){
+	switch(node->onpodevent.type){
+		case T_PROC_POD_STRING:
+			if(node->onpodevent.value.str.mmapedbuffer_r != NULL){
+			    munmap(node->onpodevent.value.str.mmapedbuffer_r, node->onpodevent.value.str.length_r);
+			}
+			if(node->onpodevent.value.str.mmapedfd64_r >= 0){
+			    close(node->onpodevent.value.str.mmapedfd64_r);
+			}
+
+			if(node->onpodevent.value.str.mmapedbuffer_w != NULL){
+			    munmap(node->onpodevent.value.str.mmapedbuffer_w, node->onpodevent.value.str.length_w);
+			}
+			if(node->onpodevent.value.str.mmapedfd64_w >= 0){
+			    close(node->onpodevent.value.str.mmapedfd64_w);
+			}
+			break;
+		case T_PROC_POD_ARRAY:
+			procfuse_freePODArray(node->onpodevent.value.array);
+			break;
+		case T_PROC_POD_RECORD:
+			procfuse_freePODRecord(node->onpodevent.value.record);
+			break;
+		default:
+			break;
+	}
+	/* procfuse_createPOD() initialised the lock of scalar and string PODs, the next value comes with its own */
+	if(node->onpodevent.type>T_PROC_POD_NO && node->onpodevent.type<T_PROC_POD_ARRAY){
+		pthread_rwlock_destroy(&node->onpodevent.rwlock);
+	}
+	node->onpodevent.seq = 0;
+	node->onpodevent.type = T_PROC_POD_NO;
+}
+/* releases the memory of a node, the node must not be reachable anymore */
+void procfuse_releaseNode(struct procfuse_hashnode *node){
+	if(node->subdirs!=NULL){
+		hash_table_free(node->subdirs);
+	}
+	free(node->index.entries);
+	if(node->transactions!=NULL){
+		hash_table_free(node->transactions);
+	}
+
+	pthread_rwlock_destroy(&node->lock);
+
+	procfuse_releasePODValue(node);
+
+	/* key is owned by pf->atoms */
+	free(node->absolutepath);
+
+	slab_release(node->pf->nodeslab, node);
+}
+/* value free function of the tree tables, called when a node is removed from the tree
+ * a node still pinned or referenced by the kernel is released later by procfuse_unpinNode() or procfuse_forgetInode()
+ */
+void procfuse_freeHashNode(void *n){
+	unsigned int state = 0;
+	struct procfuse_hashnode *node = (struct procfuse_hashnode *)n;
+
+	if(node==NULL) return;
+
+	state = __atomic_or_fetch(&node->pinstate, PROCFUSE_PIN_DETACHED, __ATOMIC_ACQ_REL);
+	if((state & (PROCFUSE_PIN_COUNT|PROCFUSE_PIN_INODE|PROCFUSE_PIN_CLAIMED))==0){
+		procfuse_releaseNode(node);
+	}
+}
+void procfuse_freeTransactionNode(void *n){
+	struct procfuse_transactionnode *tnode = NULL;
+
+	if(n==NULL) return;
+	tnode = (struct procfuse_transactionnode *)n;
+
+	slab_release(tnode->pf->writebufferslab, tnode->writebuffer);
+	slab_release(tnode->pf->transactionslab, tnode);
+}
+unsigned long procfuse_atomHash(void *atom){
+	return ((struct procfuse_atom*)atom)->hash;
+}
+int procfuse_atomEqual(void *atom1, void *atom2){
+	return atom1 == atom2;
+}
+unsigned long procfuse_inoHash(void *ino){
+	return (unsigned long)*((fuse_ino_t*)ino);
+}
+int procfuse_inoEqual(void *ino1, void *ino2){
+	return *((fuse_ino_t*)ino1) == *((fuse_ino_t*)ino2);
+}
+
+int procfuse_ctorht(struct procfuse *pf, HashTable **ht, int shall_str){
+	if(pf==NULL || ht==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	if(shall_str){
+	    *ht = hash_table_new(procfuse_atomHash, procfuse_atomEqual);
+	}
+	else{
+		*ht = hash_table_new(int_hash, int_equal);
+	}
+	if(*ht==NULL){
+		return 0;
+	}
+	/* the keys are owned by the nodes */
+	if(shall_str)
+        hash_table_register_free_functions(*ht, NULL, procfuse_freeHashNode);
+	else
+		hash_table_register_free_functions(*ht, NULL, procfuse_freeTransactionNode);
+	return 1;
+}
+int procfuse_dtorht(HashTable **ht){
+	if(ht==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	hash_table_free(*ht);
+	*ht=NULL;
+	return 1;
+}
+
+
+struct procfuse* procfuse_ctor(const char *filesystemname, const char *mountpoint, const char *fuse_option,const void *appdata){
+	struct procfuse *pf = NULL;
+	char *absolutemountpoint = NULL;
+	DIR *d = NULL;
+	int er = 0, len = 0;
+	const char *fusermountcmd = "fusermount -u ";
+	char *unmountcmd = NULL;
+
+	if(filesystemname==NULL || mountpoint==NULL){
+		errno = EINVAL;
+		return NULL;
+	}
+
+	errno = 0;
+	pf = (struct procfuse *)calloc(1, sizeof(struct procfuse));
+	absolutemountpoint = realpath(mountpoint, NULL);
+	if(pf==NULL || absolutemountpoint==NULL){
+		if(pf!=NULL) free(pf);
+		if(absolutemountpoint!=NULL) free(absolutemountpoint);
+
+		errno = ENOMEM;
+		return NULL;
+	}
+	memset(pf, '\0', sizeof(struct procfuse));
+	pthread_rwlock_init(&pf->lock, NULL);
+	pthread_mutex_init(&pf->fuselock, NULL);
+	pthread_mutex_init(&pf->polllock, NULL);
+
+	if(pthread_key_create(&pf->key_thread_local_storage, free)!=0){
+		free(pf);
+		free(absolutemountpoint);
+		return NULL;
+	}
+
+	pf->nodeslab = slab_new(sizeof(struct procfuse_hashnode), 256);
+	pf->transactionslab = slab_new(sizeof(struct procfuse_transactionnode), 64);
+	pf->writebufferslab = slab_new(PROCFUSE_WRITEBUFFERLEN, 16);
+	if(pf->nodeslab==NULL || pf->transactionslab==NULL || pf->writebufferslab==NULL ||
+	   procfuse_ctorht(pf, &pf->root, PROCFUSE_YES)==0){
+		slab_free(pf->nodeslab);
+		slab_free(pf->transactionslab);
+		slab_free(pf->writebufferslab);
+		free(pf);
+		free(absolutemountpoint);
+		return NULL;
+	}
+	/* keys are the absolutepath members of the nodes and the nodes are owned by the tree,
+	 * so no free functions are registered for the path index */
+	pf->paths = hash_table_new(string_hash, string_equal);
+	pf->inodes = hash_table_new(procfuse_inoHash, procfuse_inoEqual);
+	/* keys are the name members of the atoms */
+	pf->atoms = hash_table_new(string_hash, string_equal);
+	if(pf->paths==NULL || pf->inodes==NULL || pf->atoms==NULL){
+		if(pf->paths!=NULL) procfuse_dtorht(&pf->paths);
+		if(pf->inodes!=NULL) procfuse_dtorht(&pf->inodes);
+		if(pf->atoms!=NULL) procfuse_dtorht(&pf->atoms);
+		procfuse_dtorht(&pf->root);
+		slab_free(pf->nodeslab);
+		slab_free(pf->transactionslab);
+		slab_free(pf->writebufferslab);
+		free(pf);
+		free(absolutemountpoint);
+		return NULL;
+	}
+	hash_table_register_free_functions(pf->atoms, NULL, free);
+	pf->inocounter = FUSE_ROOT_ID;
+
+    pf->fuseArgv[0] = strdup(filesystemname);
+    pf->fuseArgv[1] = absolutemountpoint;
+    pf->absolutemountpoint = absolutemountpoint;
+
+	if(fuse_option!=NULL && strlen(fuse_option)>0){
+	    pf->fuse_option = strdup(fuse_option);
+	}
+
+	pf->fuse_singlethreaded = 0;
+	pf->fuse_lowlevel = 0;
+	pf->running = 0;
+
+	d = NULL;
+	if((d=opendir(pf->absolutemountpoint))==NULL){
+		if(errno==ENOTCONN){
+
+			er = umount2(pf->absolutemountpoint, MNT_DETACH);
+			if(er==-1){
+				len = strlen(pf->absolutemountpoint)+strlen(fusermountcmd)+1;
+				unmountcmd = (char*)calloc(sizeof(char), len);
+				if(unmountcmd!=NULL){
+				    snprintf(unmountcmd, len, "%s%s", fusermountcmd, pf->absolutemountpoint);
+				    system(unmountcmd);
+				    free(unmountcmd);
+				}
+			}
+		}
+	}
+	else{
+		closedir(d);
+	}
+
+	pf->appdata = appdata;
+
+	return pf;
+}
+
+/* every node is in pf->inodes, the kernel's references and the pins of handles left open end with the filesystem
+ * nodes already removed from the tree are released here, the others when pf->root is freed
+ */
+void procfuse_dropInodes(struct procfuse *pf){
+	HashTableIterator iterator;
+	struct procfuse_hashnode *node = NULL;
+	unsigned int state = 0;
+
+	hash_table_iterate(pf->inodes, &iterator);
+	while((node = (struct procfuse_hashnode *)hash_table_iter_next(&iterator)) != HASH_TABLE_NULL){
+		state = __atomic_and_fetch(&node->pinstate, ~(PROCFUSE_PIN_INODE|PROCFUSE_PIN_COUNT), __ATOMIC_ACQ_REL);
+		if(state & PROCFUSE_PIN_DETACHED){
+			procfuse_releaseNode(node);
+		}
+	}
+}
+void procfuse_dtor(struct procfuse *pf){
+	struct timespec ts;
+	if(pf==NULL || pf->root==NULL){
+		return;
+	}
+
+	/* waiting for the thread to exit */
+	do{
+		procfuse_teardown(pf);
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 100000000; /* 100 milliseconds */
+	}while(pthread_timedjoin_np(pf->procfuseth, NULL, &ts)!=0);
+    pthread_join(pf->procfuseth, NULL);
+
+	free((void*)pf->fuseArgv[0]);
+	free((void*)pf->absolutemountpoint);
+	if(pf->fuse_option!=NULL){
+	    free((void*)pf->fuse_option);
+	}
+
+	procfuse_dropInodes(pf);
+	procfuse_dtorht(&pf->inodes);
+	procfuse_dtorht(&pf->paths);
+	procfuse_dtorht(&pf->root);
+	free(pf->rootindex.entries);
+	procfuse_dtorht(&pf->atoms);
+	/* the memory of the nodes, released above */
+	slab_free(pf->nodeslab);
+	slab_free(pf->transactionslab);
+	slab_free(pf->writebufferslab);
+	pthread_rwlock_destroy(&pf->lock);
+	pthread_mutex_destroy(&pf->polllock);
+	pf->appdata = NULL;
+
+	memset(pf, '\0', sizeof(struct procfuse));
+	free(pf);
+}
+
+struct procfuse_threadlocalstorage* procfuse_getThreadLocalStorage(struct procfuse *pf){
+	struct procfuse_threadlocalstorage *tls = NULL;
+
+	if(pf==NULL){
+		errno = EINVAL;
+		return NULL;
+	}
+
+    if ((tls = (struct procfuse_threadlocalstorage *)pthread_getspecific(pf->key_thread_local_storage)) == NULL) {
+    	tls = (struct procfuse_threadlocalstorage *)calloc(1, sizeof(struct procfuse_threadlocalstorage));
+    	if(tls==NULL){
+    		errno = ENOMEM;
+    		return NULL;
+    	}
+
+        pthread_setspecific(pf->key_thread_local_storage, tls);
+    }
+
+    return tls;
+}
+
+struct procfuse_error* procfuse_error(struct procfuse *pf){
+	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
+	if(tls==NULL){
+		return NULL;
+	}
+
+	return &tls->error;
+}
+
+void procfuse_setErrno(struct procfuse *pf, int errn){
+	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
+	if(tls==NULL){
+		return;
+	}
+
+	tls->error.errn = errn;
+}
+void procfuse_setError(struct procfuse *pf, const char *fmt, ...){
+	int size = 0;
+	va_list ap;
+	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
+	if(tls==NULL){
+		return;
+	}
+	if(fmt==NULL){
+		errno = EINVAL;
+		return;
+	}
+
+	/* determine size of final string */
+	va_start(ap, fmt);
+	size = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    if(tls->error.error!=NULL){
+    	free(tls->error.error);
+    }
+
+    /* finally allocate and snprintf final string */
+   	tls->error.error = (char*)calloc(size+1, sizeof(char));
+	va_start(ap, fmt);
+	size = vsnprintf(tls->error.error, size, fmt, ap);
+    va_end(ap);
+}
+void procfuse_setSolution(struct procfuse *pf, const char *fmt, ...){
+	int size = 0;
+	va_list ap;
+	struct procfuse_threadlocalstorage *tls = procfuse_getThreadLocalStorage(pf);
+	if(tls==NULL){
+		return;
+	}
+	if(fmt==NULL){
+		errno = EINVAL;
+		return;
+	}
+
+	/* determine size of final string */
+	va_start(ap, fmt);
+	size = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    if(tls->error.solution!=NULL){
+    	free(tls->error.solution);
+    }
+
+    /* finally allocate and snprintf final string */
+   	tls->error.solution = (char*)calloc(size+1, sizeof(char));
+	va_start(ap, fmt);
+	size = vsnprintf(tls->error.solution, size, fmt, ap);
+    va_end(ap);
+}
+
+
+void procfuse_printTree(HashTable *htable){
+	struct procfuse_hashnode *value = NULL;
+	HashTableIterator iterator;
+	hash_table_iterate(htable, &iterator);
+
+	while ((value = (struct procfuse_hashnode *)hash_table_iter_next(&iterator)) != HASH_TABLE_NULL) {
+		printf("%s:%d:%s key=%p\n",__FILE__,__LINE__,__FUNCTION__, value->key->name);
+
+		if(value->subdirs==NULL){
+			printf("%s:%d:%s node = %s\n",__FILE__,__LINE__,__FUNCTION__, value->key->name);
+		}
+		else{
+			printf("%s:%d:%s subdir = %s\n",__FILE__,__LINE__,__FUNCTION__, value->key->name);
+			procfuse_printTree(value->subdirs);
+		}
+	}
+}
+
+/* return position of first non delim character at the beginning of what */
+const char* procfuse_ltrim(const char *what, char delim){
+	if(what==NULL){ return NULL; }
+	while(*what==delim){
+		what++;
+	}
+	return what;
+}
+/* return position of first non delim character at the end of what */
+const char* procfuse_rtrim(const char *what, char delim){
+	const char *eow = NULL;
+	if(what==NULL){ return NULL; }
+
+	eow = what+strlen(what);
+	do{
+		eow--;
+	}while(eow>what && *eow==delim);
+
+	return eow;
+}
+
+int procfuse_getNextFileName(const char *trimedabsolutepath, char fname[PROCFUSE_FNAMELEN]){
+	size_t len = 0;
+
+	const char *eop = strchr(trimedabsolutepath,PROCFUSE_DELIMC);
+	if(eop==NULL){
+		len = strlen(trimedabsolutepath);
+		eop = trimedabsolutepath+len;
+	}
+	else{
+		len = (eop-trimedabsolutepath);
+	}
+
+	if(len>PROCFUSE_FNAMELEN-1){
+		errno = ENAMETOOLONG;
+		return 0;
+	}
+	memcpy(fname, trimedabsolutepath, len);
+	fname[len] = '\0';
+
+	return 1;
+}
+
+/* returns absolutepath in the form the path index uses as key: a leading delimiter, no trailing or repeated ones
+ * paths given by fuse are already in this form, then absolutepath itself is returned, otherwise the
+ * normalized path is written to normalized
+ */
+const char* procfuse_normalizePath(const char *absolutepath, char normalized[PROCFUSE_PATHLEN]){
+	const char *p = NULL;
+	size_t len = 0;
+	int isnormalized = (absolutepath[0]==PROCFUSE_DELIMC) ? PROCFUSE_YES : PROCFUSE_NO;
+
+	for(p=absolutepath; *p!='\0' && isnormalized==PROCFUSE_YES; p++){
+		if(*p==PROCFUSE_DELIMC && (p[1]==PROCFUSE_DELIMC || (p[1]=='\0' && p!=absolutepath))){
+			isnormalized = PROCFUSE_NO;
+		}
+	}
+	if(isnormalized==PROCFUSE_YES){
+		return absolutepath;
+	}
+
+	for(p=absolutepath; *p!='\0'; p++){
+		if(*p==PROCFUSE_DELIMC && len>0 && normalized[len-1]==PROCFUSE_DELIMC){
+			continue;
+		}
+		if(len==0 && *p!=PROCFUSE_DELIMC){
+			normalized[len++] = PROCFUSE_DELIMC;
+		}
+		if(len>=PROCFUSE_PATHLEN-1){
+			errno = ENAMETOOLONG;
+			return NULL;
+		}
+		normalized[len++] = *p;
+	}
+	if(len>1 && normalized[len-1]==PROCFUSE_DELIMC){
+		len--;
+	}
+	if(len==0){
+		normalized[len++] = PROCFUSE_DELIMC;
+	}
+	normalized[len] = '\0';
+
+	return normalized;
+}
+
+/* returns the atom of name, if it doesn't exist yet and create==PROCFUSE_YES it's added to pf->atoms
+ * creating atoms requires pf->lock to be held exclusively
+ */
+struct procfuse_atom* procfuse_internAtom(struct procfuse *pf, const char *name, int create){
+	struct procfuse_atom *atom = NULL;
+	size_t length = 0;
+
+	atom = (struct procfuse_atom *)hash_table_lookup(pf->atoms, (HashTableKey)name);
+	if(atom!=NULL){
+		return atom;
+	}
+	if(create==PROCFUSE_NO){
+		errno = ENOENT;
+		return NULL;
+	}
+
+	length = strlen(name);
+	atom = (struct procfuse_atom *)malloc(sizeof(struct procfuse_atom)+length);
+	if(atom==NULL){
+		errno = ENOMEM;
+		return NULL;
+	}
+	memcpy(atom->name, name, length+1);
+	atom->length = length;
+	atom->hash = string_hash(atom->name);
+	if(hash_table_insert(pf->atoms, atom->name, atom)==0){
+		free(atom);
+		errno = ENOMEM;
+		return NULL;
+	}
+	return atom;
+}
+struct procfuse_hashnode* procfuse_getNextNode(struct procfuse *pf, HashTable *root, const char *fname){
+	struct procfuse_atom *atom = procfuse_internAtom(pf, fname, PROCFUSE_NO);
+
+	if(atom==NULL){
+		return NULL;
+	}
+	return (struct procfuse_hashnode *)hash_table_lookup(root, atom);
+}
+/* appends node, whose inode number is greater than the one of every entry already in index */
+int procfuse_dirIndexAdd(struct procfuse_dirindex *index, struct procfuse_hashnode *node){
+	size_t capacity = 0;
+	struct procfuse_direntry *entries = NULL;
+
+	if(index->count==index->capacity){
+		capacity = (index->capacity==0) ? 8 : index->capacity*2;
+		entries = (struct procfuse_direntry *)realloc(index->entries, capacity*sizeof(struct procfuse_direntry));
+		if(entries==NULL){
+			errno = ENOMEM;
+			return 0;
+		}
+		index->entries = entries;
+		index->capacity = capacity;
+	}
+	index->entries[index->count].ino = node->ino;
+	index->entries[index->count].node = node;
+	index->count++;
+
+	return 1;
+}
+/* the position of the first entry of index with an inode number greater than ino */
+size_t procfuse_dirIndexSeek(const struct procfuse_dirindex *index, fuse_ino_t ino){
+	size_t low = 0, high = index->count, mid = 0;
+
+	while(low<high){
+		mid = low + (high-low)/2;
+		if(index->entries[mid].ino<=ino){
+			low = mid+1;
+		}
+		else{
+			high = mid;
+		}
+	}
+
+	return low;
+}
+/* removed entries are skipped by listings until they make up half of the index, then it is compacted
+ * listings in progress aren't disturbed by that, they continue after an inode number, not a position
+ */
+void procfuse_dirIndexRemove(struct procfuse_dirindex *index, struct procfuse_hashnode *node){
+	size_t i = 0, j = 0;
+
+	i = procfuse_dirIndexSeek(index, node->ino);
+	if(i==0 || index->entries[i-1].node!=node){
+		return;
+	}
+	index->entries[i-1].node = NULL;
+	index->removed++;
+
+	if(index->removed*2>index->count){
+		for(i=0;i<index->count;i++){
+			if(index->entries[i].node!=NULL){
+				index->entries[j++] = index->entries[i];
+			}
+		}
+		index->count = j;
+		index->removed = 0;
+	}
+}
+
+/* allocates the node for the last component of absolutepath (which has length pathlen) and inserts it into root
+ * the node is registered in the path and inode index too
+ */
+struct procfuse_hashnode* procfuse_newNode(struct procfuse *pf, HashTable *root, struct procfuse_dirindex *index,
+                                           const char *absolutepath, size_t pathlen, size_t fnamelen){
+	struct procfuse_hashnode *node = NULL;
+
+	node = (struct procfuse_hashnode *)slab_alloc(pf->nodeslab);
+	if(node==NULL){
+		errno = ENOMEM;
+		return NULL;
+	}
+	node->pf = pf;
+	pthread_rwlock_init(&node->lock, NULL);
+	node->absolutepath = strndup(absolutepath, pathlen);
+	if(node->absolutepath==NULL){
+		slab_release(pf->nodeslab, node);
+		errno = ENOMEM;
+		return NULL;
+	}
+	node->key = procfuse_internAtom(pf, node->absolutepath + pathlen - fnamelen, PROCFUSE_YES);
+	node->ino = ++pf->inocounter;
+
+	if(node->key==NULL || hash_table_insert(root, node->key, node)==0){
+		free(node->absolutepath);
+		slab_release(pf->nodeslab, node);
+		errno = ENOMEM;
+		return NULL;
+	}
+	/* from now on removing the node from root releases it */
+	if(hash_table_insert(pf->paths, node->absolutepath, node)==0){
+		hash_table_remove(root, node->key);
+		errno = ENOMEM;
+		return NULL;
+	}
+	if(hash_table_insert(pf->inodes, &node->ino, node)==0){
+		hash_table_remove(pf->paths, node->absolutepath);
+		hash_table_remove(root, node->key);
+		errno = ENOMEM;
+		return NULL;
+	}
+	if(procfuse_dirIndexAdd(index, node)==0){
+		hash_table_remove(pf->inodes, &node->ino);
+		hash_table_remove(pf->paths, node->absolutepath);
+		hash_table_remove(root, node->key);
+		errno = ENOMEM;
+		return NULL;
+	}
+	__atomic_or_fetch(&node->pinstate, PROCFUSE_PIN_INODE, __ATOMIC_RELEASE);
+
+	return node;
+}
+
+/* existing nodes are found with a single probe of the path index, only if create==PROCFUSE_YES
+ * and the node doesn't exist yet the tree is walked component by component, creating missing nodes
+ * every created node gets its normalized absolutepath assigned and is added to the path index
+ */
+struct procfuse_hashnode* procfuse_pathToNode(struct procfuse *pf, const char *absolutepath, int create){
+	HashTable *root = NULL;
+	struct procfuse_dirindex *index = NULL;
+	struct procfuse_hashnode *node = NULL, *parent = NULL;
+	const char *normalizedpath = NULL, *eoc = NULL;
+	char normalized[PROCFUSE_PATHLEN];
+	char fname[PROCFUSE_FNAMELEN] = {'\0'};
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return NULL;
+	}
+
+	normalizedpath = procfuse_normalizePath(absolutepath, normalized);
+	if(normalizedpath==NULL){
+		return NULL;
+	}
+
+	node = (struct procfuse_hashnode *)hash_table_lookup(pf->paths, (HashTableKey)normalizedpath);
+	if(node!=NULL || create==PROCFUSE_NO || normalizedpath[1]=='\0'){
+		if(node==NULL){
+			errno = ENOENT;
+		}
+		return node;
+	}
+
+	root = pf->root;
+	index = &pf->rootindex;
+	absolutepath = normalizedpath+1;
+	while(root!=NULL){
+		if(!procfuse_getNextFileName(absolutepath, fname)){
+			return NULL;
+		}
+		eoc = absolutepath+strlen(fname);
+
+		node = procfuse_getNextNode(pf, root, fname);
+		if(node==NULL){
+			node = procfuse_newNode(pf, root, index, normalizedpath, eoc-normalizedpath, strlen(fname));
+			if(node==NULL){
+				return NULL;
+			}
+			/* a directory's cache policy applies to everything created below it, so listing it doesn't
+			 * cost a getattr per entry - see procfuse_setCachePolicy()
+			 */
+			if(parent!=NULL){
+				node->cache = parent->cache;
+			}
+		}
+
+		if(*eoc=='\0'){
+			break;
+		}
+
+		if(node->subdirs==NULL && procfuse_ctorht(pf, &node->subdirs, PROCFUSE_YES)==0){
+			return NULL;
+		}
+		root = node->subdirs;
+		index = &node->index;
+		parent = node;
+		absolutepath = eoc+1;
+	}
+
+	return node;
+}
+
+/* removes node and all nodes below it from the path index,
+ * and from the inode table unless the kernel still references them - procfuse_forgetInode() does it then
+ */
+void procfuse_unindexNode(struct procfuse *pf, struct procfuse_hashnode *node){
+	struct procfuse_hashnode *value = NULL;
+	HashTableIterator iterator;
+
+	if(node->subdirs!=NULL){
+		hash_table_iterate(node->subdirs, &iterator);
+		while ((value = (struct procfuse_hashnode *)hash_table_iter_next(&iterator)) != HASH_TABLE_NULL) {
+			procfuse_unindexNode(pf, value);
+		}
+	}
+	if(node->absolutepath!=NULL){
+		hash_table_remove(pf->paths, node->absolutepath);
+	}
+	if(node->nlookup==0 && hash_table_remove(pf->inodes, &node->ino)){
+		__atomic_and_fetch(&node->pinstate, ~PROCFUSE_PIN_INODE, __ATOMIC_ACQ_REL);
+	}
+}
+
+/* the caller has to hold pf->lock */
+struct procfuse_hashnode* procfuse_inoToNode(struct procfuse *pf, fuse_ino_t ino){
+	return (struct procfuse_hashnode *)hash_table_lookup(pf->inodes, &ino);
+}
+
+/* drops nlookup references the kernel held on inode ino */
+void procfuse_forgetInode(struct procfuse *pf, fuse_ino_t ino, unsigned long nlookup){
+	struct procfuse_hashnode *node = NULL;
+	int removenode = PROCFUSE_NO;
+
+	pthread_rwlock_rdlock(&pf->lock);
+
+	node = procfuse_inoToNode(pf, ino);
+	if(node!=NULL && __sync_sub_and_fetch(&node->nlookup, nlookup)==0 &&
+	   hash_table_lookup(pf->paths, node->absolutepath)!=node){
+		removenode = PROCFUSE_YES;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	if(removenode==PROCFUSE_YES){
+		/* node has been removed from the tree already and this was the last reference
+		 * verify again with the exclusive lock held, the kernel may have looked it up again in between
+		 */
+		pthread_rwlock_wrlock(&pf->lock);
+
+		node = procfuse_inoToNode(pf, ino);
+		if(node!=NULL && node->nlookup==0 && hash_table_lookup(pf->paths, node->absolutepath)!=node){
+			unsigned int state = 0;
+
+			hash_table_remove(pf->inodes, &node->ino);
+			state = __atomic_and_fetch(&node->pinstate, ~PROCFUSE_PIN_INODE, __ATOMIC_ACQ_REL);
+			if((state & PROCFUSE_PIN_DETACHED) && (state & (PROCFUSE_PIN_COUNT|PROCFUSE_PIN_CLAIMED))==0){
+				procfuse_releaseNode(node);
+			}
+		}
+
+		pthread_rwlock_unlock(&pf->lock);
+	}
+}
+
+int procfuse_unregisterNodeInternal(struct procfuse *pf, HashTable *root, struct procfuse_dirindex *index, const char *absolutepath){
+	int pathlen = 0, flen = 0, hassubpath = 0;
+	const char *eoap = NULL;
+	struct procfuse_hashnode *node = NULL;
+	char fname[PROCFUSE_FNAMELEN] = {'\0'};
+
+	if(pf==NULL || root==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	absolutepath = procfuse_ltrim(absolutepath, PROCFUSE_DELIMC);
+	eoap = procfuse_rtrim(absolutepath, PROCFUSE_DELIMC);
+	eoap++; /* reposition at delim character (or null byte) to have correct pointer arithmetic */
+
+
+	if(!procfuse_getNextFileName(absolutepath, fname)){
+		return 0;
+	}
+
+	pathlen = eoap-absolutepath;
+	flen = strlen(fname);
+	hassubpath = (pathlen==flen) ? 0 : 1 ;
+
+	/* if
+	 *    node exists AND is end node AND absolutepath is filename => update access
+	 *    node exists AND is root node AND absolutepath is root => recursive unregisterNode
+	 *    node not exists => alloc node as neeeded
+	 */
+	node = procfuse_getNextNode(pf, root, fname);
+	if(node==NULL){
+		errno = EEXIST;
+		return 0;
+	}
+
+	if(hassubpath && node->subdirs!=NULL){
+		int rval = procfuse_unregisterNodeInternal(pf, node->subdirs, &node->index, absolutepath+flen+1);
+		if(hash_table_num_entries(node->subdirs)<=0){
+			procfuse_unindexNode(pf, node);
+			procfuse_dirIndexRemove(index, node);
+			hash_table_remove(root, node->key);
+			node = NULL;
+		}
+		return rval;
+	}
+	else {
+		procfuse_unindexNode(pf, node);
+		procfuse_dirIndexRemove(index, node);
+		hash_table_remove(root, node->key);
+		return 1;
+	}
+	return 0;
+}
+
+int procfuse_openTempFile(const char *pfx, int deleteOnOpen){
+	int descriptor = -1;
+    char tmpfiletemplate[8192];
+    int iteration=0, maxiteration = 64*1024; /* max 2^16 iterations */
+    static const char *tmpdir = NULL;
+
+	memset(tmpfiletemplate, '\0', sizeof(tmpfiletemplate));
+
+	/* i'm not using a mutex here because the pointer values are very strict and since it's only written once here
+	 * even a race condition should result in the same tmpdir value
+	 */
+	if(tmpdir==NULL){
+	    tmpdir = getenv("TMPDIR");
+	}
+	if(tmpdir==NULL && P_tmpdir!=NULL){
+		tmpdir = P_tmpdir;
+	}
+	if(tmpdir==NULL){
+		tmpdir = "/tmp";
+	}
+
+	if(pfx==NULL){
+		pfx = "";
+	}
+
+	do{
+		iteration++;
+
+	    snprintf(tmpfiletemplate, sizeof(tmpfiletemplate)-1, "%s/procfuse.%d.%s.tmp.%d%d", tmpdir, getpid(), pfx, rand(),rand());
+	    descriptor = open(tmpfiletemplate, O_RDWR | O_CREAT | O_EXCL | O_LARGEFILE, S_IRUSR|S_IWUSR);
+
+        if (descriptor >= 0){
+        	if(deleteOnOpen == PROCFUSE_YES){
+        		unlink(tmpfiletemplate);
+        	}
+	        break;
+	    }
+        else if(errno != EEXIST){
+        	break;
+        }
+	}while(iteration<maxiteration);
+
+	return descriptor;
+}
+
+
+/* detaches the poll handles of the open files polling node
+ * returns a NULL terminated array of the detached poll handles for procfuse_notifyPollers(), NULL if there are none
+ * the caller may hold pf->lock or a node lock, the notifications are sent after releasing them
+ */
+struct fuse_pollhandle** procfuse_detachPollers(struct procfuse *pf, struct procfuse_hashnode *node){
+	struct procfuse_filehandle *handle = NULL, *next = NULL;
+	struct fuse_pollhandle **ph = NULL;
+	size_t count = 0;
+
+	if(__atomic_load_n(&node->pollers, __ATOMIC_ACQUIRE)==NULL){
+		return NULL;
+	}
+
+	pthread_mutex_lock(&pf->polllock);
+	for(handle=node->pollers;handle!=NULL;handle=handle->nextpoller){
+		count++;
+	}
+	/* without memory the pollers stay attached and are woken by the next change */
+	if(count>0 && (ph = (struct fuse_pollhandle**)malloc((count+1)*sizeof(*ph)))!=NULL){
+		/* a poll handle is notified once, the kernel polls again and passes a new one */
+		count = 0;
+		for(handle=node->pollers;handle!=NULL;handle=next){
+			next = handle->nextpoller;
+			ph[count++] = handle->ph;
+			handle->ph = NULL;
+			handle->nextpoller = NULL;
+		}
+		ph[count] = NULL;
+		__atomic_store_n(&node->pollers, NULL, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&pf->polllock);
+
+	return ph;
+}
+/* records a change of the content of node and detaches its pollers, see procfuse_detachPollers() */
+struct fuse_pollhandle** procfuse_changeNode(struct procfuse *pf, struct procfuse_hashnode *node){
+	__atomic_add_fetch(&node->generation, 1, __ATOMIC_RELEASE);
+	return procfuse_detachPollers(pf, node);
+}
+/* wakes the pollers detached by procfuse_changeNode(), it writes to the fuse device like the other notify functions */
+void procfuse_notifyPollers(struct fuse_pollhandle **ph){
+	size_t i = 0;
+
+	if(ph==NULL){
+		return;
+	}
+
+	for(i=0;ph[i]!=NULL;i++){
+		fuse_lowlevel_notify_poll(ph[i]);
+		fuse_pollhandle_destroy(ph[i]);
+	}
+	free(ph);
+}
+
+/* the file descriptor holding the content of node, -1 if it has none */
+int procfuse_nodeBackingFd(const struct procfuse_hashnode *node){
+	if(node->onpodevent.type==T_PROC_POD_STRING){
+		return node->onpodevent.value.str.mmapedfd64_r;
+	}
+	if(node->backed==PROCFUSE_YES){
+		return node->backingfd;
+	}
+	return -1;
+}
+/* returns the inode number of node if the kernel may hold cached attributes or content of it, 0 otherwise
+ * the caller has to hold pf->lock or a pin of node
+ */
+fuse_ino_t procfuse_cachedInode(struct procfuse_hashnode *node){
+	if(__atomic_load_n(&node->nlookup, __ATOMIC_RELAXED)==0 ||
+	   (node->cache.attr_timeout<=0.0 && node->cache.keep_cache!=PROCFUSE_YES && node->passthrough!=PROCFUSE_YES)){
+		return 0;
+	}
+	return node->ino;
+}
+/* stores the directory containing node in *parent, NULL for the root, returns 0 if it isn't in the tree
+ * the caller has to hold pf->lock
+ */
+int procfuse_parentNode(struct procfuse *pf, const struct procfuse_hashnode *node, struct procfuse_hashnode **parent){
+	char parentpath[PROCFUSE_PATHLEN];
+	size_t parentlen = 0;
+
+	/* absolutepath is normalized, so the parent path ends right before the delimiter preceding the name */
+	parentlen = strlen(node->absolutepath) - node->key->length - 1;
+	if(parentlen==0){
+		*parent = NULL;
+		return 1;
+	}
+	memcpy(parentpath, node->absolutepath, parentlen);
+	parentpath[parentlen] = '\0';
+
+	*parent = (struct procfuse_hashnode *)hash_table_lookup(pf->paths, parentpath);
+	return (*parent!=NULL) ? 1 : 0;
+}
+/* returns the inode number of the directory containing node if the kernel may have cached the name of node, 0 otherwise
+ * the caller has to hold pf->lock
+ */
+fuse_ino_t procfuse_cachedParentInode(struct procfuse *pf, struct procfuse_hashnode *node){
+	struct procfuse_hashnode *parent = NULL;
+
+	if(__atomic_load_n(&node->nlookup, __ATOMIC_RELAXED)==0 || node->cache.entry_timeout<=0.0){
+		return 0;
+	}
+
+	if(procfuse_parentNode(pf, node, &parent)){
+		return (parent!=NULL) ? parent->ino : FUSE_ROOT_ID;
+	}
+	return 0;
+}
+/* the notify functions write to the fuse device, so they must not be called with pf->lock or a node lock held */
+void procfuse_invalidateInode(struct procfuse *pf, fuse_ino_t ino){
+	if(ino==0){
+		return;
+	}
+
+	pthread_mutex_lock(&pf->fuselock);
+	if(pf->chan!=NULL){
+		fuse_lowlevel_notify_inval_inode(pf->chan, ino, 0, 0);
+	}
+	pthread_mutex_unlock(&pf->fuselock);
+}
+/* the invalidation of updates through pod handles, see procfuse_notifyPODHandle()
+ * once the kernel's cache of a node has been dropped, further updates don't need to drop it again until the kernel
+ * fetched the node, so notifying a counter in a loop costs one notification per read instead of one per call
+ */
+void procfuse_invalidateNodeOnce(struct procfuse *pf, struct procfuse_hashnode *node){
+	fuse_ino_t ino = procfuse_cachedInode(node);
+
+	if(ino!=0 && __atomic_exchange_n(&node->invalidated, PROCFUSE_YES, __ATOMIC_SEQ_CST)==PROCFUSE_NO){
+		procfuse_invalidateInode(pf, ino);
+	}
+}
+/* called before the attributes or the content of node are passed to the kernel, the next update invalidates them */
+void procfuse_nodeFetched(const struct procfuse_hashnode *node){
+	if(__atomic_load_n(&node->invalidated, __ATOMIC_RELAXED)!=PROCFUSE_NO){
+		__atomic_store_n((unsigned int*)&node->invalidated, PROCFUSE_NO, __ATOMIC_SEQ_CST);
+	}
+}
+void procfuse_invalidateEntry(struct procfuse *pf, fuse_ino_t parent, const char *name, size_t namelen){
+	if(parent==0){
+		return;
+	}
+
+	pthread_mutex_lock(&pf->fuselock);
+	if(pf->chan!=NULL){
+		fuse_lowlevel_notify_inval_entry(pf->chan, parent, name, namelen);
+	}
+	pthread_mutex_unlock(&pf->fuselock);
+}
+
+/* PROCFUSE_YES if the content of node may be replaced by a new one, the caller holds pf->lock exclusively
+ * open files and pod handles pin the node and use its value without any lock, nodes are only pinned with pf->lock
+ * held, so the node stays unpinned until pf->lock is released
+ * arrays, records and binary views keep their type as long as the node exists
+ */
+int procfuse_isReplaceable(const struct procfuse_hashnode *node){
+	if(node->onpodevent.type>=T_PROC_POD_ARRAY){
+		return PROCFUSE_NO;
+	}
+	/* a claimed node is about to be removed by the thread which dropped its last pin */
+	return (__atomic_load_n(&node->pinstate, __ATOMIC_ACQUIRE) & (PROCFUSE_PIN_COUNT|PROCFUSE_PIN_CLAIMED)) ?
+	        PROCFUSE_NO : PROCFUSE_YES;
+}
+/* the node a creator fills in at absolutepath, the caller holds pf->lock exclusively
+ * an unlinked node which is still open or claimed looks absent already, it's detached from the tree and replaced by
+ * a new node, procfuse_unpinNode() releases it once its last pin is dropped
+ */
+struct procfuse_hashnode* procfuse_createNode(struct procfuse *pf, const char *absolutepath){
+	struct procfuse_hashnode *node = NULL, *parent = NULL;
+
+	node = procfuse_pathToNode(pf, absolutepath, PROCFUSE_YES);
+	if(node==NULL || (__atomic_load_n(&node->pinstate, __ATOMIC_ACQUIRE) & (PROCFUSE_PIN_UNLINK|PROCFUSE_PIN_CLAIMED))==0){
+		return node;
+	}
+	if(!procfuse_parentNode(pf, node, &parent)){
+		return NULL;
+	}
+
+	/* only the node itself is removed, its directory stays */
+	procfuse_unindexNode(pf, node);
+	procfuse_dirIndexRemove((parent!=NULL) ? &parent->index : &pf->rootindex, node);
+	hash_table_remove((parent!=NULL) ? parent->subdirs : pf->root, node->key);
+
+	return procfuse_pathToNode(pf, absolutepath, PROCFUSE_YES);
+}
+int procfuse_create(struct procfuse *pf, const char *absolutepath, struct procfuse_accessor access){
+	int rval = 0, flags = 0;
+	struct procfuse_hashnode *node = NULL;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_createNode(pf, absolutepath);
+	if(node!=NULL && !procfuse_isReplaceable(node)){
+		errno = EEXIST;
+	}
+	else if(node!=NULL){
+		/* an existing file gets new content */
+		ino = procfuse_cachedInode(node);
+		pollers = procfuse_changeNode(pf, node);
+		/* nobody else uses an unpinned node, so its old content goes before it's overwritten */
+		procfuse_releasePODValue(node);
+
+		memcpy(&node->onevent, &access, sizeof(access));
+		node->onpodevent.type = T_PROC_POD_NO;
+		node->backed = PROCFUSE_NO;
+		flags = 0;
+		if(access.onFuseRead!=NULL && access.onFuseWrite!=NULL){
+			flags = O_RDWR;
+		}
+		else if(access.onFuseRead!=NULL){
+			flags = O_RDONLY;
+		}
+		else if(access.onFuseWrite!=NULL){
+			flags = O_WRONLY;
+		}
+		node->flags = flags;
+
+
+		gettimeofday(&node->created, NULL);
+		rval = 1;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_createPOD(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify onModify, procfuse_pod_t pod_type){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	struct procfuse_accessor access;
+	struct procfuse_pod_accessor podaccess;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	if(pod_type<=T_PROC_POD_NO || pod_type>=T_PROC_POD_ARRAY){
+		errno = EINVAL;
+		return 0;
+	}
+
+	memset(&podaccess, '\0', sizeof(podaccess));
+
+	podaccess.onModify = onModify;
+	podaccess.type = pod_type;
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_createNode(pf, absolutepath);
+	if(node!=NULL && !procfuse_isReplaceable(node)){
+		errno = EEXIST;
+	}
+	else if(node!=NULL){
+		ino = procfuse_cachedInode(node);
+		pollers = procfuse_changeNode(pf, node);
+		procfuse_releasePODValue(node);
+		memset(&access, '\0', sizeof(access));
+
+		access.onFuseOpen = procfuse_onFuseOpenPOD;
+		access.onFuseTruncate = procfuse_onFuseTruncatePOD;
+		access.onFuseRead = procfuse_onFuseReadPOD;
+		access.onFuseWrite = procfuse_onFuseWritePOD;
+		access.onFuseRelease = procfuse_onFuseReleasePOD;
+
+		memcpy(&node->onevent, &access, sizeof(access));
+		memcpy(&node->onpodevent, &podaccess, sizeof(podaccess));
+		node->flags = flags;
+		node->backed = PROCFUSE_NO;
+
+
+		gettimeofday(&node->created, NULL);
+
+		rval = 1;
+		/* a copy of an initialised lock isn't one, the lock is initialised where it's used */
+		if(pthread_rwlock_init(&node->onpodevent.rwlock, NULL)!=0){
+			node->onpodevent.type = T_PROC_POD_NO;
+			errno = ENOMEM;
+			rval = 0;
+		}
+		else if(node->onpodevent.type == T_PROC_POD_STRING){
+			node->onpodevent.value.str.mmapedfd64_r = node->onpodevent.value.str.mmapedfd64_w = -1;
+			node->onpodevent.value.str.mmapedfd64_r = procfuse_openTempFile("podstring", PROCFUSE_YES);
+
+			node->onpodevent.value.str.length_r = node->onpodevent.value.str.length_w = 4*1024*1024;
+			if(node->onpodevent.value.str.mmapedfd64_r==-1 ||
+			   ftruncate(node->onpodevent.value.str.mmapedfd64_r, node->onpodevent.value.str.length_r)==-1 ||
+			   (node->onpodevent.value.str.mmapedbuffer_r = (char*)mmap(NULL, node->onpodevent.value.str.length_r, PROT_READ | PROT_WRITE,
+																		MAP_SHARED, node->onpodevent.value.str.mmapedfd64_r, 0))==MAP_FAILED){
+				/* the node is released by procfuse_releasePODValue(), which must not see the failed fd or mapping */
+				node->onpodevent.value.str.mmapedbuffer_r = NULL;
+				if(node->onpodevent.value.str.mmapedfd64_r!=-1){
+					close(node->onpodevent.value.str.mmapedfd64_r);
+					node->onpodevent.value.str.mmapedfd64_r = -1;
+				}
+
+				rval = 0;
+			}
+
+		}
+		/* the transaction table is created by the first open which needs it */
+
+		if(rval==0)
+			procfuse_unregisterNodeInternal(pf, pf->root, &pf->rootindex, absolutepath); /* clean up unneeded tree structures */
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_createPOD_c(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_c onModify){
+	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_CHAR);
+}
+int procfuse_createPOD_i(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_i onModify){
+	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_INT);
+}
+int procfuse_createPOD_i64(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_i64 onModify){
+	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_INT64);
+}
+int procfuse_createPOD_f(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_f onModify){
+	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_FLOAT);
+}
+int procfuse_createPOD_d(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_d onModify){
+	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_DOUBLE);
+}
+int procfuse_createPOD_ld(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_ld onModify){
+	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_LONGDOUBLE);
+}
+int procfuse_createPOD_s(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_s onModify){
+	return procfuse_createPOD(pf, absolutepath, flags, (procfuse_onModify)onModify, T_PROC_POD_STRING);
+}
+
+int procfuse_createBacked(struct procfuse *pf, const char *absolutepath, int fd, int flags){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL || fd<0){
+		errno = EINVAL;
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_createNode(pf, absolutepath);
+	if(node!=NULL && !procfuse_isReplaceable(node)){
+		errno = EEXIST;
+	}
+	else if(node!=NULL){
+		ino = procfuse_cachedInode(node);
+		pollers = procfuse_changeNode(pf, node);
+		procfuse_releasePODValue(node);
+
+		memset(&node->onevent, '\0', sizeof(node->onevent));
+		if((flags & O_ACCMODE)==O_RDONLY || (flags & O_ACCMODE)==O_RDWR){
+			node->onevent.onFuseRead = procfuse_onFuseReadBacked;
+		}
+		if((flags & O_ACCMODE)==O_WRONLY || (flags & O_ACCMODE)==O_RDWR){
+			node->onevent.onFuseWrite = procfuse_onFuseWriteBacked;
+			node->onevent.onFuseTruncate = procfuse_onFuseTruncateBacked;
+		}
+		node->onpodevent.type = T_PROC_POD_NO;
+		node->flags = flags;
+		node->backed = PROCFUSE_YES;
+		node->backingfd = fd;
+
+		gettimeofday(&node->created, NULL);
+		rval = 1;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_setPassthrough(struct procfuse *pf, const char *absolutepath, int yes_or_no){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	fuse_ino_t ino = 0;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_pathToNode(pf, absolutepath, PROCFUSE_NO);
+	if(node!=NULL && procfuse_nodeBackingFd(node)<0){
+		errno = EINVAL;
+	}
+	else if(node!=NULL){
+		/* drop pages cached while the mode was different */
+		ino = procfuse_cachedInode(node);
+		node->passthrough = (yes_or_no==PROCFUSE_YES) ? PROCFUSE_YES : PROCFUSE_NO;
+		rval = 1;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_setSnapshot(struct procfuse *pf, const char *absolutepath, int yes_or_no){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_pathToNode(pf, absolutepath, PROCFUSE_NO);
+	if(node!=NULL && (node->subdirs!=NULL || procfuse_nodeBackingFd(node)>=0)){
+		/* reads of fd backed nodes are consistent anyway */
+		errno = EINVAL;
+	}
+	else if(node!=NULL){
+		/* open files keep the mode they were opened with */
+		node->snapshot = (yes_or_no==PROCFUSE_YES) ? PROCFUSE_YES : PROCFUSE_NO;
+		rval = 1;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	return rval;
+}
+
+int procfuse_notify(struct procfuse *pf, const char *absolutepath){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	pthread_rwlock_rdlock(&pf->lock);
+
+	node = procfuse_pathToNode(pf, absolutepath, PROCFUSE_NO);
+	if(node!=NULL){
+		pollers = procfuse_changeNode(pf, node);
+		ino = procfuse_cachedInode(node);
+		rval = 1;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_isPendingForUnlink(struct procfuse_hashnode *node){
+	return (__atomic_load_n(&node->pinstate, __ATOMIC_ACQUIRE) & PROCFUSE_PIN_UNLINK) ? PROCFUSE_YES : PROCFUSE_NO;
+}
+
+int procfuse_unlink(struct procfuse *pf, const char *absolutepath){
+	int rval = 0;
+	unsigned int state = 0;
+	struct procfuse_hashnode *node = NULL;
+	struct procfuse_atom *name = NULL;
+	fuse_ino_t parent = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_pathToNode(pf, absolutepath, PROCFUSE_NO);
+	if(node!=NULL){
+		/* the atom outlives the node */
+		parent = procfuse_cachedParentInode(pf, node);
+		name = node->key;
+		/* pollers see the file changing and notice the removal by reading it */
+		pollers = procfuse_changeNode(pf, node);
+
+		state = __atomic_fetch_or(&node->pinstate, PROCFUSE_PIN_UNLINK, __ATOMIC_ACQ_REL);
+
+		/* while pins are held the node is removed by procfuse_unpinNode() of the last one
+		 * a thread having claimed the node already waits for pf->lock to remove it
+		 */
+		if((state & (PROCFUSE_PIN_COUNT|PROCFUSE_PIN_CLAIMED))==0){
+		    rval = procfuse_unregisterNodeInternal(pf, pf->root, &pf->rootindex, absolutepath);
+		}
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_notifyPollers(pollers);
+	if(name!=NULL){
+		procfuse_invalidateEntry(pf, parent, name->name, name->length);
+	}
+
+	return rval;
+}
+
+/* the caller has to hold pf->lock */
+void procfuse_acquireAccessToNodeLocked(struct procfuse_hashnode *node){
+	/* pin the node, holding pf->lock guarantees it isn't removed meanwhile */
+	__atomic_add_fetch(&node->pinstate, 1, __ATOMIC_ACQUIRE);
+
+	/* acquire read only lock!! and leave it that */
+	pthread_rwlock_rdlock(&node->lock);
+}
+
+struct procfuse_hashnode* procfuse_acquireAccessToNode(struct procfuse *pf, const char *absolutepath){
+	struct procfuse_hashnode *node = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return NULL;
+	}
+
+	/* acquire outer global filesystem lock - shared, lookups of different threads don't exclude each other */
+	pthread_rwlock_rdlock(&pf->lock);
+
+	/* search node */
+	node = procfuse_pathToNode(pf, absolutepath, PROCFUSE_NO);
+	if(node!=NULL){
+		procfuse_acquireAccessToNodeLocked(node);
+	}
+	/* realease outer lock */
+	pthread_rwlock_unlock(&pf->lock);
+
+	return node;
+}
+
+/* like procfuse_acquireAccessToNode, but the node is searched by its inode number
+ * this also finds nodes which have been removed from the tree but are still referenced by the kernel
+ */
+struct procfuse_hashnode* procfuse_acquireAccessToInode(struct procfuse *pf, fuse_ino_t ino){
+	struct procfuse_hashnode *node = NULL;
+
+	if(pf==NULL){
+		errno = EINVAL;
+		return NULL;
+	}
+
+	pthread_rwlock_rdlock(&pf->lock);
+
+	node = procfuse_inoToNode(pf, ino);
+	if(node!=NULL){
+		procfuse_acquireAccessToNodeLocked(node);
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	return node;
+}
+
+struct procfuse_hashnode* procfuse_upgradeNodeReadLockToWriteLock(struct procfuse_hashnode *node){
+	if(node==NULL){
+		errno = -EINVAL;
+		return NULL;
+	}
+
+	pthread_rwlock_unlock(&node->lock);
+	pthread_rwlock_wrlock(&node->lock);
+
+	return node;
+}
+struct procfuse_hashnode* procfuse_downgradeNodeWriteLockToReadLock(struct procfuse_hashnode *node){
+	if(node==NULL){
+		errno = -EINVAL;
+		return NULL;
+	}
+
+	pthread_rwlock_unlock(&node->lock);
+	pthread_rwlock_rdlock(&node->lock);
+
+	return node;
+}
+
+/* drops the access counted by procfuse_acquireAccessToNode, without the read lock on node being held anymore
+ * if the node has been unlinked meanwhile and this was the last pin, the node is removed from the tree now
+ */
+void procfuse_unpinNode(struct procfuse *pf, struct procfuse_hashnode *node){
+	unsigned int state = 0;
+	char *absolutepath = NULL;
+
+	if(pf==NULL || node==NULL){
+		errno = EINVAL;
+		return;
+	}
+
+	state = __atomic_sub_fetch(&node->pinstate, 1, __ATOMIC_ACQ_REL);
+	if(state & PROCFUSE_PIN_COUNT){
+		/* still pinned - the common case, no locks involved */
+		return;
+	}
+	if(state & PROCFUSE_PIN_DETACHED){
+		/* removed from the tree while pinned, the last pin releases it */
+		if((state & (PROCFUSE_PIN_INODE|PROCFUSE_PIN_CLAIMED))==0){
+			procfuse_releaseNode(node);
+		}
+		return;
+	}
+
+	/* the last pin of an unlinked node has been dropped, but a new pin may be acquired until pf->lock
+	 * is held exclusively and that one may drop it again, so only the thread claiming the node removes it
+	 * until then the node must not be touched
+	 */
+	while((state & ~PROCFUSE_PIN_INODE)==PROCFUSE_PIN_UNLINK){
+		if(__atomic_compare_exchange_n(&node->pinstate, &state, state|PROCFUSE_PIN_CLAIMED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)){
+			break;
+		}
+	}
+	if((state & ~PROCFUSE_PIN_INODE)!=PROCFUSE_PIN_UNLINK){
+		return;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	/* while the exclusive lock is held no new pin can be acquired, but pins acquired before may still be dropped
+	 * and the node may have been removed from the tree with its parent directory meanwhile
+	 */
+	state = __atomic_load_n(&node->pinstate, __ATOMIC_ACQUIRE);
+	while(!__atomic_compare_exchange_n(&node->pinstate, &state, state & ~PROCFUSE_PIN_CLAIMED, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+	state &= ~PROCFUSE_PIN_CLAIMED;
+
+	if(state & PROCFUSE_PIN_COUNT){
+		/* pinned again meanwhile, the thread dropping the last of these pins takes over */
+	}
+	else if(state & PROCFUSE_PIN_DETACHED){
+		if((state & PROCFUSE_PIN_INODE)==0){
+			procfuse_releaseNode(node);
+		}
+	}
+	else{
+		/* the node may be released by the removal */
+		absolutepath = strdup(node->absolutepath);
+		if(absolutepath!=NULL){
+			procfuse_unregisterNodeInternal(pf, pf->root, &pf->rootindex, absolutepath);
+		}
+		free(absolutepath);
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+}
+
+void procfuse_releaseAccessToNode(struct procfuse *pf, struct procfuse_hashnode *node){
+	if(pf==NULL || node==NULL){
+		errno = EINVAL;
+		return;
+	}
+
+	/* first relase the read only lock!! */
+	pthread_rwlock_unlock(&node->lock);
+
+	procfuse_unpinNode(pf, node);
+}
+
+struct procfuse_accessor procfuse_accessor(procfuse_onFuseOpen onFuseOpen, procfuse_onFuseTruncate onFuseTruncate,
+                                           procfuse_onFuseRead onFuseRead, procfuse_onFuseWrite onFuseWrite,
+                                           procfuse_onFuseRelease onFuseRelease){
+	struct procfuse_accessor access;
+	memset(&access, '\0', sizeof(access));
+
+	access.onFuseOpen = onFuseOpen;
+	access.onFuseTruncate = onFuseTruncate;
+	access.onFuseRead = onFuseRead;
+	access.onFuseWrite = onFuseWrite;
+	access.onFuseRelease = onFuseRelease;
+
+	return access;
+}
+struct procfuse_cachepolicy procfuse_cachepolicy(double attr_timeout, double entry_timeout, int keep_cache){
+	struct procfuse_cachepolicy policy;
+	memset(&policy, '\0', sizeof(policy));
+
+	policy.attr_timeout = attr_timeout;
+	policy.entry_timeout = entry_timeout;
+	policy.keep_cache = keep_cache;
+
+	return policy;
+}
+int procfuse_setCachePolicy(struct procfuse *pf, const char *absolutepath, struct procfuse_cachepolicy policy){
+	struct procfuse_hashnode *node = NULL;
+	fuse_ino_t ino = 0;
+
+	if(pf==NULL || absolutepath==NULL || policy.attr_timeout<0.0 || policy.entry_timeout<0.0){
+		errno = EINVAL;
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_pathToNode(pf, absolutepath, PROCFUSE_NO);
+	if(node!=NULL){
+		/* drop what the kernel cached under the old policy */
+		ino = procfuse_cachedInode(node);
+		node->cache = policy;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_invalidateInode(pf, ino);
+
+	return (node!=NULL) ? 1 : 0;
+}
+
+int procfuse_copyPOD(procfuse_pod_t dst_type, union procfuse_pod *dstpod, procfuse_pod_t src_type, union procfuse_pod *srcpod){
+	int rval = 0, printed = 0;
+	switch(src_type){
+	    case T_PROC_POD_CHAR:
+	    	switch(dst_type){
+				case T_PROC_POD_CHAR:
+					dstpod->c = srcpod->c;
+					rval = 1;
+					break;
+				case T_PROC_POD_INT:
+					dstpod->i = (int)srcpod->c;
+					rval = 1;
+					break;
+	    	    case T_PROC_POD_INT64:
+	    	    	dstpod->l = (int64_t)srcpod->c;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_FLOAT:
+	    	    	dstpod->f = (float)srcpod->c;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_DOUBLE:
+	    	    	dstpod->d = (double)srcpod->c;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_LONGDOUBLE:
+	    	    	dstpod->ld = (long double)srcpod->c;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_STRING:
+					if(dstpod->str.length_r>=1){
+						dstpod->str.mmapedbuffer_r[0] = srcpod->c;
+						dstpod->str.length_r = 1;
+						rval = 1;
+					}
+	    	    	break;
+	    	    default: break;
+	    	}
+	    	break;
+
+	    case T_PROC_POD_INT:
+	    	switch(dst_type){
+				case T_PROC_POD_INT:
+					dstpod->i = srcpod->i;
+					rval = 1;
+					break;
+	    	    case T_PROC_POD_INT64:
+	    	    	dstpod->l = srcpod->i;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_FLOAT:
+	    	    	dstpod->f = (float)srcpod->i;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_DOUBLE:
+	    	    	dstpod->d = srcpod->i;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_LONGDOUBLE:
+	    	    	dstpod->ld = srcpod->i;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_STRING:
+	    	    	printed = procfuse_renderPOD(T_PROC_POD_INT, srcpod, dstpod->str.mmapedbuffer_r, dstpod->str.length_r);
+	    	    	/* if successfully written */
+	    	    	if(printed>0 && printed<dstpod->str.length_r){
+	    	    		dstpod->str.length_r = printed;
+	    	    		rval = 1;
+	    	    	}
+	    	    	else{
+	    	    		rval = printed;
+	    	    	}
+	    	    	break;
+	    	    default: break;
+	    	}
+	    	break;
+
+	    case T_PROC_POD_INT64:
+	    	switch(dst_type){
+	    	    case T_PROC_POD_INT64:
+	    	    	dstpod->l = srcpod->l;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_FLOAT:
+	    	    	if(sizeof(dstpod->f)>=sizeof(srcpod->l)){
+						dstpod->f = (float)srcpod->l;
+						rval = 1;
+	    	    	}
+	    	    	break;
+	    	    case T_PROC_POD_DOUBLE:
+					dstpod->d = srcpod->l;
+					rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_LONGDOUBLE:
+	    	    	dstpod->ld = srcpod->l;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_STRING:
+	    	    	printed = procfuse_renderPOD(T_PROC_POD_INT64, srcpod, dstpod->str.mmapedbuffer_r, dstpod->str.length_r);
+	    	    	/* if successfully written */
+	    	    	if(printed>0 && printed<dstpod->str.length_r){
+	    	    		dstpod->str.length_r = printed;
+	    	    		rval = 1;
+	    	    	}
+	    	    	else{
+	    	    		rval = printed;
+	    	    	}
+	    	    	break;
+	    	    default: break;
+	    	}
+	    	break;
+
+		case T_PROC_POD_FLOAT:
+	    	switch(dst_type){
+				case T_PROC_POD_FLOAT:
+					dstpod->f = srcpod->f;
+					rval = 1;
+					break;
+	    	    case T_PROC_POD_DOUBLE:
+	    	    	dstpod->d = srcpod->f;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_LONGDOUBLE:
+	    	    	dstpod->ld = srcpod->f;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_STRING:
+	    	    	printed = procfuse_renderPOD(T_PROC_POD_FLOAT, srcpod, dstpod->str.mmapedbuffer_r, dstpod->str.length_r);
+	    	    	/* if successfully written */
+	    	    	if(printed>0 && printed<dstpod->str.length_r){
+	    	    		dstpod->str.length_r = printed;
+	    	    		rval = 1;
+	    	    	}
+	    	    	else{
+	    	    		rval = printed;
+	    	    	}
+	    	    	break;
+	    	    default: break;
+	    	}
+			break;
+
+	    case T_PROC_POD_DOUBLE:
+	    	switch(dst_type){
+	    	    case T_PROC_POD_DOUBLE:
+	    	    	dstpod->d = srcpod->d;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_LONGDOUBLE:
+	    	    	dstpod->ld = srcpod->d;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_STRING:
+	    	    	printed = procfuse_renderPOD(T_PROC_POD_DOUBLE, srcpod, dstpod->str.mmapedbuffer_r, dstpod->str.length_r);
+	    	    	/* if successfully written */
+	    	    	if(printed>0 && printed<dstpod->str.length_r){
+	    	    		dstpod->str.length_r = printed;
+	    	    		rval = 1;
+	    	    	}
+	    	    	else{
+	    	    		rval = printed;
+	    	    	}
+	    	    	break;
+	    	    default: break;
+	    	}
+	    	break;
+
+	    case T_PROC_POD_LONGDOUBLE:
+	    	switch(dst_type){
+	    	    case T_PROC_POD_LONGDOUBLE:
+	    	    	dstpod->ld = srcpod->ld;
+	    	    	rval = 1;
+	    	    	break;
+	    	    case T_PROC_POD_STRING:
+	    	    	printed = procfuse_renderPOD(T_PROC_POD_LONGDOUBLE, srcpod, dstpod->str.mmapedbuffer_r, dstpod->str.length_r);
+	    	    	/* if successfully written */
+	    	    	if(printed>0 && printed<dstpod->str.length_r){
+	    	    		dstpod->str.length_r = printed;
+	    	    		rval = 1;
+	    	    	}
+	    	    	else{
+	    	    		rval = printed;
+	    	    	}
+	    	    	break;
+	    	    default: break;
+	    	}
+	    	break;
+
+	    case T_PROC_POD_STRING:
+	    	if(dst_type==T_PROC_POD_CHAR && srcpod->str.length_w==1){
+	    		dstpod->c = srcpod->str.mmapedbuffer_w[0];
+	    		rval = 1;
+	    	}
+	    	else if(dst_type==T_PROC_POD_STRING && dstpod->str.length_r >= srcpod->str.length_w){
+	    		memcpy(dstpod->str.mmapedbuffer_r, srcpod->str.mmapedbuffer_w, srcpod->str.length_w);
+	    		dstpod->str.length_r = srcpod->str.length_w;
 	    		rval = 1;
 	    	}
-	    	break;
+	    	break;
+	    default:
+		    /* error */
+	    	break;
+	}
+
+	return rval;
+}
+
+/* scalar POD values are read and written while only the read lock of the node is held,
+ * so concurrent readers of the same POD never wait for each other or for a writer
+ * values up to 8 bytes are accessed atomically, long double is guarded by the seqlock in pod->seq
+ * string PODs are only copied by descriptor, their content is protected by the node lock
+ */
+void procfuse_loadPOD(struct procfuse_pod_accessor *pod, union procfuse_pod *value){
+	unsigned int seq = 0;
+
+	switch(pod->type){
+		case T_PROC_POD_CHAR:
+			value->c = __atomic_load_n(&pod->value.c, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_INT:
+			value->i = __atomic_load_n(&pod->value.i, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_INT64:
+			value->l = __atomic_load_n(&pod->value.l, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_FLOAT:
+			__atomic_load(&pod->value.f, &value->f, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_DOUBLE:
+			__atomic_load(&pod->value.d, &value->d, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_LONGDOUBLE:
+			do{
+				while((seq = __atomic_load_n(&pod->seq, __ATOMIC_ACQUIRE)) & 1){
+					sched_yield();
+				}
+				memcpy(&value->ld, (const void*)&pod->value.ld, sizeof(value->ld));
+				__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			}while(__atomic_load_n(&pod->seq, __ATOMIC_RELAXED)!=seq);
+			break;
+		case T_PROC_POD_STRING:
+			memcpy(&value->str, &pod->value.str, sizeof(value->str));
+			break;
+		default:
+			break;
+	}
+}
+void procfuse_storePOD(struct procfuse_pod_accessor *pod, const union procfuse_pod *value){
+	unsigned int seq = 0;
+
+	switch(pod->type){
+		case T_PROC_POD_CHAR:
+			__atomic_store_n(&pod->value.c, value->c, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_INT:
+			__atomic_store_n(&pod->value.i, value->i, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_INT64:
+			__atomic_store_n(&pod->value.l, value->l, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_FLOAT:
+			__atomic_store(&pod->value.f, (float*)&value->f, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_DOUBLE:
+			__atomic_store(&pod->value.d, (double*)&value->d, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_LONGDOUBLE:
+			/* writers exclude each other by making the sequence odd */
+			seq = __atomic_load_n(&pod->seq, __ATOMIC_RELAXED);
+			while((seq & 1) ||
+			      !__atomic_compare_exchange_n(&pod->seq, &seq, seq+1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+				if(seq & 1){
+					sched_yield();
+					seq = __atomic_load_n(&pod->seq, __ATOMIC_RELAXED);
+				}
+			}
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+			memcpy((void*)&pod->value.ld, &value->ld, sizeof(value->ld));
+			__atomic_store_n(&pod->seq, seq+2, __ATOMIC_RELEASE);
+			break;
+		default:
+			break;
+	}
+}
+
+int procfuse_readPOD(struct procfuse *pf, const char *absolutepath, procfuse_pod_t pod_type, void *buffer){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+
+	if(pf==NULL || absolutepath==NULL || buffer==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL){
+		union procfuse_pod value;
+
+		procfuse_loadPOD(&node->onpodevent, &value);
+	    rval = procfuse_copyPOD(pod_type, (union procfuse_pod *)buffer, node->onpodevent.type, &value);
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	return rval;
+}
+
+int procfuse_readPOD_c(struct procfuse *pf, const char *absolutepath, char *value){
+	int rval = 0;
+	union procfuse_pod buffer;
+
+	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_CHAR, &buffer);
+	if(rval!=0){
+		*value = buffer.c;
+	}
+	return rval;
+}
+int procfuse_readPOD_i(struct procfuse *pf, const char *absolutepath, int *value){
+	int rval = 0;
+	union procfuse_pod buffer;
+
+	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT, &buffer);
+	if(rval!=0){
+		*value = buffer.i;
+	}
+	return rval;
+}
+int procfuse_readPOD_i64(struct procfuse *pf, const char *absolutepath, int64_t *value){
+	int rval = 0;
+	union procfuse_pod buffer;
+
+	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT64, &buffer);
+	if(rval!=0){
+		*value = buffer.l;
+	}
+	return rval;
+}
+int procfuse_readPOD_f(struct procfuse *pf, const char *absolutepath, float *value){
+	int rval = 0;
+	union procfuse_pod buffer;
+
+	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_FLOAT, &buffer);
+	if(rval!=0){
+		*value = buffer.f;
+	}
+	return rval;
+}
+int procfuse_readPOD_d(struct procfuse *pf, const char *absolutepath, double *value){
+	int rval = 0;
+	union procfuse_pod buffer;
+
+	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_DOUBLE, &buffer);
+	if(rval!=0){
+		*value = buffer.d;
+	}
+	return rval;
+}
+int procfuse_readPOD_ld(struct procfuse *pf, const char *absolutepath, long double *value){
+	int rval = 0;
+	union procfuse_pod buffer;
+
+	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_LONGDOUBLE, &buffer);
+	if(rval!=0){
+		*value = buffer.ld;
+	}
+	return rval;
+}
+int procfuse_readPOD_s(struct procfuse *pf, const char *absolutepath, char *value, int64_t *length){
+	int rval = 0;
+	union procfuse_pod buffer;
+
+	buffer.str.length_w = *length;
+	buffer.str.mmapedbuffer_w = value;
+
+	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT64, &buffer);
+	return rval;
+}
+
+int procfuse_writePOD(struct procfuse *pf, const char *absolutepath, procfuse_pod_t pod_type, void *buffer){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL && node->onpodevent.type==T_PROC_POD_STRING){
+		/* the string content is written in place */
+		procfuse_upgradeNodeReadLockToWriteLock(node);
+		rval = procfuse_copyPOD(node->onpodevent.type, &node->onpodevent.value, pod_type, (union procfuse_pod *)buffer);
+		procfuse_downgradeNodeWriteLockToReadLock(node);
+	}
+	else if(node!=NULL){
+		union procfuse_pod value;
+
+		memset(&value, '\0', sizeof(value));
+		rval = procfuse_copyPOD(node->onpodevent.type, &value, pod_type, (union procfuse_pod *)buffer);
+		if(rval==1){
+			procfuse_storePOD(&node->onpodevent, &value);
+		}
+	}
+	if(node!=NULL && rval==1){
+		pollers = procfuse_changeNode(pf, node);
+		ino = procfuse_cachedInode(node);
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+
+int procfuse_writePOD_c(struct procfuse *pf, const char *absolutepath, char value){
+	union procfuse_pod buffer;
+
+	buffer.c = value;
+	return procfuse_writePOD(pf, absolutepath, T_PROC_POD_CHAR, &buffer);
+}
+int procfuse_writePOD_i(struct procfuse *pf, const char *absolutepath, int value){
+	union procfuse_pod buffer;
+
+	buffer.i = value;
+	return procfuse_writePOD(pf, absolutepath, T_PROC_POD_INT, &buffer);
+}
+int procfuse_writePOD_i64(struct procfuse *pf, const char *absolutepath, int64_t value){
+	union procfuse_pod buffer;
+
+	buffer.l = value;
+	return procfuse_writePOD(pf, absolutepath, T_PROC_POD_INT64, &buffer);
+}
+int procfuse_writePOD_f(struct procfuse *pf, const char *absolutepath, float value){
+	union procfuse_pod buffer;
+
+	buffer.f = value;
+	return procfuse_writePOD(pf, absolutepath, T_PROC_POD_FLOAT, &buffer);
+}
+int procfuse_writePOD_d(struct procfuse *pf, const char *absolutepath, double value){
+	union procfuse_pod buffer;
+
+	buffer.d = value;
+	return procfuse_writePOD(pf, absolutepath, T_PROC_POD_DOUBLE, &buffer);
+}
+int procfuse_writePOD_ld(struct procfuse *pf, const char *absolutepath, long double value){
+	union procfuse_pod buffer;
+
+	buffer.ld = value;
+	return procfuse_writePOD(pf, absolutepath, T_PROC_POD_LONGDOUBLE, &buffer);
+}
+int procfuse_writePOD_s(struct procfuse *pf, const char *absolutepath, char *value, int64_t length){
+	union procfuse_pod buffer;
+
+	buffer.str.length_w = length;
+	buffer.str.mmapedbuffer_w = value;
+	return procfuse_writePOD(pf, absolutepath, T_PROC_POD_STRING, &buffer);
+}
+
+/* a pod handle pins the node of a scalar, an array or a record POD, so the application can update it from its hot paths
+ * without any lookup and without taking a lock - an unlinked POD is removed when its last handle is closed
+ */
+struct procfuse_podhandle{
+	struct procfuse *pf;
+	struct procfuse_hashnode *node;
+	unsigned int notified; /* the generation of the node passed on by the last procfuse_notifyPODHandle() */
+};
+
+struct procfuse_podhandle* procfuse_openPODHandle(struct procfuse *pf, const char *absolutepath){
+	struct procfuse_podhandle *handle = NULL;
+	struct procfuse_hashnode *node = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return NULL;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node==NULL){
+		errno = ENOENT;
+		return NULL;
+	}
+	if(node->onpodevent.type<=T_PROC_POD_NO || node->onpodevent.type==T_PROC_POD_STRING || node->onpodevent.type==T_PROC_POD_BINARY){
+		procfuse_releaseAccessToNode(pf, node);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	handle = (struct procfuse_podhandle*)calloc(1, sizeof(struct procfuse_podhandle));
+	if(handle==NULL){
+		procfuse_releaseAccessToNode(pf, node);
+		errno = ENOMEM;
+		return NULL;
+	}
+	handle->pf = pf;
+	handle->node = node;
+	handle->notified = __atomic_load_n(&node->generation, __ATOMIC_ACQUIRE);
+
+	/* keep the pin, but not the read lock */
+	pthread_rwlock_unlock(&node->lock);
+
+	return handle;
+}
+void procfuse_closePODHandle(struct procfuse_podhandle *handle){
+	if(handle==NULL){
+		errno = EINVAL;
+		return;
+	}
+
+	procfuse_unpinNode(handle->pf, handle->node);
+	free(handle);
+}
+/* a store through a handle only counts the change, reads and polls of open files compare the count when they come
+ * waiting pollers and the kernel's cache learn of it by procfuse_notifyPODHandle()
+ */
+void procfuse_podHandleChanged(struct procfuse_podhandle *handle){
+	__atomic_add_fetch(&handle->node->generation, 1, __ATOMIC_RELEASE);
+}
+/* passes the stores through handles since the last call on, one call covers any number of stores */
+int procfuse_notifyPODHandle(struct procfuse_podhandle *handle){
+	unsigned int generation = 0;
+
+	if(handle==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	generation = __atomic_load_n(&handle->node->generation, __ATOMIC_ACQUIRE);
+	if(__atomic_exchange_n(&handle->notified, generation, __ATOMIC_ACQ_REL)!=generation){
+		procfuse_notifyPollers(procfuse_detachPollers(handle->pf, handle->node));
+		procfuse_invalidateNodeOnce(handle->pf, handle->node);
+	}
+	return 1;
+}
+/* the type of a pinned node doesn't change, see procfuse_isReplaceable() */
+int procfuse_checkPODHandle(struct procfuse_podhandle *handle, procfuse_pod_t pod_type){
+	if(handle==NULL || handle->node->onpodevent.type!=pod_type){
+		errno = EINVAL;
+		return 0;
+	}
+	return 1;
+}
+
+int procfuse_writePODHandle_c(struct procfuse_podhandle *handle, char newvalue){
+	union procfuse_pod value;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_CHAR)){
+		return 0;
+	}
+	value.c = newvalue;
+	procfuse_storePOD(&handle->node->onpodevent, &value);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_readPODHandle_c(struct procfuse_podhandle *handle, char *value){
+	union procfuse_pod pod;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_CHAR) || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	procfuse_loadPOD(&handle->node->onpodevent, &pod);
+	*value = pod.c;
+	return 1;
+}
+int procfuse_writePODHandle_i(struct procfuse_podhandle *handle, int newvalue){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_INT)){
+		return 0;
+	}
+	__atomic_store_n(&handle->node->onpodevent.value.i, newvalue, __ATOMIC_RELEASE);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_readPODHandle_i(struct procfuse_podhandle *handle, int *value){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_INT) || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	*value = __atomic_load_n(&handle->node->onpodevent.value.i, __ATOMIC_ACQUIRE);
+	return 1;
+}
+int procfuse_writePODHandle_i64(struct procfuse_podhandle *handle, int64_t newvalue){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_INT64)){
+		return 0;
+	}
+	__atomic_store_n(&handle->node->onpodevent.value.l, newvalue, __ATOMIC_RELEASE);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_readPODHandle_i64(struct procfuse_podhandle *handle, int64_t *value){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_INT64) || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	*value = __atomic_load_n(&handle->node->onpodevent.value.l, __ATOMIC_ACQUIRE);
+	return 1;
+}
+int procfuse_writePODHandle_f(struct procfuse_podhandle *handle, float newvalue){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_FLOAT)){
+		return 0;
+	}
+	__atomic_store(&handle->node->onpodevent.value.f, &newvalue, __ATOMIC_RELEASE);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_readPODHandle_f(struct procfuse_podhandle *handle, float *value){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_FLOAT) || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	__atomic_load(&handle->node->onpodevent.value.f, value, __ATOMIC_ACQUIRE);
+	return 1;
+}
+int procfuse_writePODHandle_d(struct procfuse_podhandle *handle, double newvalue){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_DOUBLE)){
+		return 0;
+	}
+	__atomic_store(&handle->node->onpodevent.value.d, &newvalue, __ATOMIC_RELEASE);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_readPODHandle_d(struct procfuse_podhandle *handle, double *value){
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_DOUBLE) || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	__atomic_load(&handle->node->onpodevent.value.d, value, __ATOMIC_ACQUIRE);
+	return 1;
+}
+int procfuse_writePODHandle_ld(struct procfuse_podhandle *handle, long double newvalue){
+	union procfuse_pod value;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_LONGDOUBLE)){
+		return 0;
+	}
+	value.ld = newvalue;
+	procfuse_storePOD(&handle->node->onpodevent, &value);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_readPODHandle_ld(struct procfuse_podhandle *handle, long double *value){
+	union procfuse_pod pod;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_LONGDOUBLE) || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	procfuse_loadPOD(&handle->node->onpodevent, &pod);
+	*value = pod.ld;
+	return 1;
+}
+/* adds delta and returns 1, the new value is stored in newvalue if it's not NULL */
+int procfuse_addPODHandle_i(struct procfuse_podhandle *handle, int delta, int *newvalue){
+	int result = 0;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_INT)){
+		return 0;
+	}
+	result = __atomic_add_fetch(&handle->node->onpodevent.value.i, delta, __ATOMIC_ACQ_REL);
+	if(newvalue!=NULL){
+		*newvalue = result;
+	}
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_addPODHandle_i64(struct procfuse_podhandle *handle, int64_t delta, int64_t *newvalue){
+	int64_t result = 0;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_INT64)){
+		return 0;
+	}
+	result = __atomic_add_fetch(&handle->node->onpodevent.value.l, delta, __ATOMIC_ACQ_REL);
+	if(newvalue!=NULL){
+		*newvalue = result;
+	}
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_addPODHandle_f(struct procfuse_podhandle *handle, float delta, float *newvalue){
+	float expected = 0, desired = 0;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_FLOAT)){
+		return 0;
+	}
+	/* there's no atomic floating point addition, retry until no other thread changed the value in between */
+	__atomic_load(&handle->node->onpodevent.value.f, &expected, __ATOMIC_ACQUIRE);
+	do{
+		desired = expected + delta;
+	}while(!__atomic_compare_exchange(&handle->node->onpodevent.value.f, &expected, &desired, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+	if(newvalue!=NULL){
+		*newvalue = desired;
+	}
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_addPODHandle_d(struct procfuse_podhandle *handle, double delta, double *newvalue){
+	double expected = 0, desired = 0;
+
+	if(!procfuse_checkPODHandle(handle, T_PROC_POD_DOUBLE)){
+		return 0;
+	}
+	/* there's no atomic floating point addition, retry until no other thread changed the value in between */
+	__atomic_load(&handle->node->onpodevent.value.d, &expected, __ATOMIC_ACQUIRE);
+	do{
+		desired = expected + delta;
+	}while(!__atomic_compare_exchange(&handle->node->onpodevent.value.d, &expected, &desired, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+	if(newvalue!=NULL){
+		*newvalue = desired;
+	}
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+
+/* array PODs */
+
+void procfuse_freePODArray(struct procfuse_pod_array *array){
+	if(array==NULL){
+		return;
+	}
+	pthread_mutex_destroy(&array->lock);
+	free(array->values);
+	free(array->dirty);
+	free(array->text);
+	free(array->textlength);
+	free(array->linestart);
+	free(array);
+}
+struct procfuse_pod_array* procfuse_newPODArray(procfuse_pod_t type, size_t length){
+	struct procfuse_pod_array *array = NULL;
+	size_t elementsize = 0, words = 0, i = 0;
+
+	/* the text takes the most memory per element, a length within it fits every other size */
+	if(length>SIZE_MAX/PROCFUSE_ARRAYLINELEN){
+		errno = EINVAL;
+		return NULL;
+	}
+	words = (length+63)/64;
+
+	switch(type){
+		case T_PROC_POD_INT: elementsize = sizeof(int); break;
+		case T_PROC_POD_INT64: elementsize = sizeof(int64_t); break;
+		case T_PROC_POD_FLOAT: elementsize = sizeof(float); break;
+		case T_PROC_POD_DOUBLE: elementsize = sizeof(double); break;
+		default:
+			errno = EINVAL;
+			return NULL;
+	}
+
+	array = (struct procfuse_pod_array*)calloc(1, sizeof(struct procfuse_pod_array));
+	if(array==NULL){
+		errno = ENOMEM;
+		return NULL;
+	}
+	if(pthread_mutex_init(&array->lock, NULL)!=0){
+		free(array);
+		return NULL;
+	}
+	array->type = type;
+	array->length = length;
+	array->values = calloc(length, elementsize);
+	array->dirty = (uint64_t*)calloc(words, sizeof(uint64_t));
+	array->text = (char*)malloc(length*PROCFUSE_ARRAYLINELEN);
+	array->textlength = (unsigned char*)calloc(length, sizeof(unsigned char));
+	array->linestart = (uint64_t*)calloc(length+1, sizeof(uint64_t));
+	if(array->values==NULL || array->dirty==NULL || array->text==NULL || array->textlength==NULL || array->linestart==NULL){
+		procfuse_freePODArray(array);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	/* every element is rendered by the first read */
+	for(i=0;i<words;++i){
+		array->dirty[i] = (i<length/64) ? ~0ULL : ((1ULL << (length%64)) - 1);
+	}
+
+	return array;
+}
+void procfuse_loadArrayElement(const struct procfuse_pod_array *array, size_t index, union procfuse_pod *value){
+	switch(array->type){
+		case T_PROC_POD_INT:
+			value->i = __atomic_load_n((int*)array->values+index, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_INT64:
+			value->l = __atomic_load_n((int64_t*)array->values+index, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_FLOAT:
+			__atomic_load((float*)array->values+index, &value->f, __ATOMIC_ACQUIRE);
+			break;
+		case T_PROC_POD_DOUBLE:
+			__atomic_load((double*)array->values+index, &value->d, __ATOMIC_ACQUIRE);
+			break;
+		default:
+			break;
+	}
+}
+/* marks an element for the next read, after its value has been stored */
+void procfuse_markArrayElement(struct procfuse_pod_array *array, size_t index){
+	__atomic_fetch_or(&array->dirty[index/64], 1ULL << (index%64), __ATOMIC_RELEASE);
+}
+void procfuse_storeArrayElement(struct procfuse_pod_array *array, size_t index, const union procfuse_pod *value){
+	switch(array->type){
+		case T_PROC_POD_INT:
+			__atomic_store_n((int*)array->values+index, value->i, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_INT64:
+			__atomic_store_n((int64_t*)array->values+index, value->l, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_FLOAT:
+			__atomic_store((float*)array->values+index, (float*)&value->f, __ATOMIC_RELEASE);
+			break;
+		case T_PROC_POD_DOUBLE:
+			__atomic_store((double*)array->values+index, (double*)&value->d, __ATOMIC_RELEASE);
+			break;
+		default:
+			break;
+	}
+	procfuse_markArrayElement(array, index);
+}
+/* adds delta to an element and stores the sum in result */
+void procfuse_addArrayElement(struct procfuse_pod_array *array, size_t index, const union procfuse_pod *delta, union procfuse_pod *result){
+	float fexpected = 0, fdesired = 0;
+	double dexpected = 0, ddesired = 0;
+
+	switch(array->type){
+		case T_PROC_POD_INT:
+			result->i = __atomic_add_fetch((int*)array->values+index, delta->i, __ATOMIC_ACQ_REL);
+			break;
+		case T_PROC_POD_INT64:
+			result->l = __atomic_add_fetch((int64_t*)array->values+index, delta->l, __ATOMIC_ACQ_REL);
+			break;
+		case T_PROC_POD_FLOAT:
+			/* there's no atomic floating point addition, retry until no other thread changed the value in between */
+			__atomic_load((float*)array->values+index, &fexpected, __ATOMIC_ACQUIRE);
+			do{
+				fdesired = fexpected + delta->f;
+			}while(!__atomic_compare_exchange((float*)array->values+index, &fexpected, &fdesired, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+			result->f = fdesired;
+			break;
+		case T_PROC_POD_DOUBLE:
+			__atomic_load((double*)array->values+index, &dexpected, __ATOMIC_ACQUIRE);
+			do{
+				ddesired = dexpected + delta->d;
+			}while(!__atomic_compare_exchange((double*)array->values+index, &dexpected, &ddesired, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+			result->d = ddesired;
+			break;
+		default:
+			break;
+	}
+	procfuse_markArrayElement(array, index);
+}
+/* renders the elements changed since the last call and returns the size of the file, the caller holds array->lock
+ * the line offsets are only summed up again from the first element whose text changed its length
+ */
+uint64_t procfuse_renderPODArray(struct procfuse_pod_array *array){
+	union procfuse_pod value;
+	uint64_t bits = 0;
+	size_t word = 0, index = 0, first = array->validstart, i = 0;
+	int length = 0;
+
+	for(word=0;word<(array->length+63)/64;++word){
+		if(__atomic_load_n(&array->dirty[word], __ATOMIC_RELAXED)==0){
+			continue;
+		}
+		bits = __atomic_exchange_n(&array->dirty[word], 0, __ATOMIC_ACQUIRE);
+		while(bits!=0){
+			index = word*64 + __builtin_ctzll(bits);
+			bits &= bits-1;
+
+			procfuse_loadArrayElement(array, index, &value);
+			length = procfuse_renderPOD(array->type, &value, array->text+index*PROCFUSE_ARRAYLINELEN, PROCFUSE_ARRAYLINELEN);
+			array->text[index*PROCFUSE_ARRAYLINELEN+length] = '\n';
+			if(length+1!=array->textlength[index]){
+				array->textlength[index] = (unsigned char)(length+1);
+				if(index<first){
+					first = index;
+				}
+			}
+		}
+	}
+
+	for(i=first;i<array->length;++i){
+		array->linestart[i+1] = array->linestart[i] + array->textlength[i];
+	}
+	array->validstart = array->length;
+
+	return array->linestart[array->length];
+}
+/* the last element whose line starts at or before offset, the caller holds array->lock and has rendered the array */
+size_t procfuse_seekPODArray(const struct procfuse_pod_array *array, uint64_t offset){
+	size_t low = 0, high = array->length, middle = 0;
+
+	while(high-low>1){
+		middle = low + (high-low)/2;
+		if(array->linestart[middle]<=offset){
+			low = middle;
+		}
+		else{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+int procfuse_createPODArray(struct procfuse *pf, const char *absolutepath, int flags, procfuse_pod_t type, size_t length){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	struct procfuse_pod_array *array = NULL;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL || length==0){
+		errno = EINVAL;
+		return 0;
+	}
+
+	array = procfuse_newPODArray(type, length);
+	if(array==NULL){
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_createNode(pf, absolutepath);
+	if(node!=NULL && !procfuse_isReplaceable(node)){
+		errno = EEXIST;
+	}
+	else if(node!=NULL){
+		ino = procfuse_cachedInode(node);
+		pollers = procfuse_changeNode(pf, node);
+		procfuse_releasePODValue(node);
+
+		/* the length is fixed, neither opening nor truncating the file changes the elements */
+		memset(&node->onevent, '\0', sizeof(node->onevent));
+		node->onevent.onFuseRead = procfuse_onFuseReadPODArray;
+		node->onevent.onFuseWrite = procfuse_onFuseWritePODArray;
+
+		memset(&node->onpodevent, '\0', sizeof(node->onpodevent));
+		node->onpodevent.type = T_PROC_POD_ARRAY;
+		node->onpodevent.value.array = array;
+		node->flags = flags;
+		node->backed = PROCFUSE_NO;
+
+		gettimeofday(&node->created, NULL);
+
+		array = NULL;
+		rval = 1;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_freePODArray(array);
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_createPODArray_i(struct procfuse *pf, const char *absolutepath, int flags, size_t length){
+	return procfuse_createPODArray(pf, absolutepath, flags, T_PROC_POD_INT, length);
+}
+int procfuse_createPODArray_i64(struct procfuse *pf, const char *absolutepath, int flags, size_t length){
+	return procfuse_createPODArray(pf, absolutepath, flags, T_PROC_POD_INT64, length);
+}
+int procfuse_createPODArray_f(struct procfuse *pf, const char *absolutepath, int flags, size_t length){
+	return procfuse_createPODArray(pf, absolutepath, flags, T_PROC_POD_FLOAT, length);
+}
+int procfuse_createPODArray_d(struct procfuse *pf, const char *absolutepath, int flags, size_t length){
+	return procfuse_createPODArray(pf, absolutepath, flags, T_PROC_POD_DOUBLE, length);
+}
+
+/* the element types have to match exactly, unlike the scalar PODs the values aren't converted */
+struct procfuse_pod_array* procfuse_nodeArray(struct procfuse_hashnode *node, procfuse_pod_t type, size_t index){
+	if(node==NULL || node->onpodevent.type!=T_PROC_POD_ARRAY ||
+	   node->onpodevent.value.array->type!=type || index>=node->onpodevent.value.array->length){
+		errno = (node==NULL) ? ENOENT : EINVAL;
+		return NULL;
+	}
+	return node->onpodevent.value.array;
+}
+int procfuse_readPODArray(struct procfuse *pf, const char *absolutepath, size_t index, procfuse_pod_t type, union procfuse_pod *value){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	struct procfuse_pod_array *array = NULL;
+
+	if(pf==NULL || absolutepath==NULL || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	array = procfuse_nodeArray(node, type, index);
+	if(array!=NULL){
+		procfuse_loadArrayElement(array, index, value);
+		rval = 1;
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	return rval;
+}
+int procfuse_writePODArray(struct procfuse *pf, const char *absolutepath, size_t index, procfuse_pod_t type, const union procfuse_pod *value){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	struct procfuse_pod_array *array = NULL;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	array = procfuse_nodeArray(node, type, index);
+	if(array!=NULL){
+		procfuse_storeArrayElement(array, index, value);
+		pollers = procfuse_changeNode(pf, node);
+		ino = procfuse_cachedInode(node);
+		rval = 1;
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_readPODArray_i(struct procfuse *pf, const char *absolutepath, size_t index, int *value){
+	union procfuse_pod buffer;
+
+	if(!procfuse_readPODArray(pf, absolutepath, index, T_PROC_POD_INT, &buffer)){
+		return 0;
+	}
+	*value = buffer.i;
+	return 1;
+}
+int procfuse_readPODArray_i64(struct procfuse *pf, const char *absolutepath, size_t index, int64_t *value){
+	union procfuse_pod buffer;
+
+	if(!procfuse_readPODArray(pf, absolutepath, index, T_PROC_POD_INT64, &buffer)){
+		return 0;
+	}
+	*value = buffer.l;
+	return 1;
+}
+int procfuse_readPODArray_f(struct procfuse *pf, const char *absolutepath, size_t index, float *value){
+	union procfuse_pod buffer;
+
+	if(!procfuse_readPODArray(pf, absolutepath, index, T_PROC_POD_FLOAT, &buffer)){
+		return 0;
+	}
+	*value = buffer.f;
+	return 1;
+}
+int procfuse_readPODArray_d(struct procfuse *pf, const char *absolutepath, size_t index, double *value){
+	union procfuse_pod buffer;
+
+	if(!procfuse_readPODArray(pf, absolutepath, index, T_PROC_POD_DOUBLE, &buffer)){
+		return 0;
+	}
+	*value = buffer.d;
+	return 1;
+}
+int procfuse_writePODArray_i(struct procfuse *pf, const char *absolutepath, size_t index, int value){
+	union procfuse_pod buffer;
+
+	buffer.i = value;
+	return procfuse_writePODArray(pf, absolutepath, index, T_PROC_POD_INT, &buffer);
+}
+int procfuse_writePODArray_i64(struct procfuse *pf, const char *absolutepath, size_t index, int64_t value){
+	union procfuse_pod buffer;
+
+	buffer.l = value;
+	return procfuse_writePODArray(pf, absolutepath, index, T_PROC_POD_INT64, &buffer);
+}
+int procfuse_writePODArray_f(struct procfuse *pf, const char *absolutepath, size_t index, float value){
+	union procfuse_pod buffer;
+
+	buffer.f = value;
+	return procfuse_writePODArray(pf, absolutepath, index, T_PROC_POD_FLOAT, &buffer);
+}
+int procfuse_writePODArray_d(struct procfuse *pf, const char *absolutepath, size_t index, double value){
+	union procfuse_pod buffer;
+
+	buffer.d = value;
+	return procfuse_writePODArray(pf, absolutepath, index, T_PROC_POD_DOUBLE, &buffer);
+}
+
+/* the element functions of pod handles, opened on an array POD */
+struct procfuse_pod_array* procfuse_checkPODArrayHandle(struct procfuse_podhandle *handle, procfuse_pod_t type, size_t index){
+	if(handle==NULL){
+		errno = EINVAL;
+		return NULL;
+	}
+	return procfuse_nodeArray(handle->node, type, index);
+}
+int procfuse_writePODArrayHandle(struct procfuse_podhandle *handle, size_t index, procfuse_pod_t type, const union procfuse_pod *value){
+	struct procfuse_pod_array *array = procfuse_checkPODArrayHandle(handle, type, index);
+
+	if(array==NULL){
+		return 0;
+	}
+	procfuse_storeArrayElement(array, index, value);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+int procfuse_readPODArrayHandle(struct procfuse_podhandle *handle, size_t index, procfuse_pod_t type, union procfuse_pod *value){
+	struct procfuse_pod_array *array = procfuse_checkPODArrayHandle(handle, type, index);
+
+	if(array==NULL || value==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	procfuse_loadArrayElement(array, index, value);
+	return 1;
+}
+/* adds delta and returns 1, the new value is stored in newvalue if it's not NULL */
+int procfuse_addPODArrayHandle(struct procfuse_podhandle *handle, size_t index, procfuse_pod_t type, const union procfuse_pod *delta,
+                               union procfuse_pod *newvalue){
+	struct procfuse_pod_array *array = procfuse_checkPODArrayHandle(handle, type, index);
+
+	if(array==NULL){
+		return 0;
+	}
+	procfuse_addArrayElement(array, index, delta, newvalue);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+
+int procfuse_writePODArrayHandle_i(struct procfuse_podhandle *handle, size_t index, int newvalue){
+	union procfuse_pod value;
+
+	value.i = newvalue;
+	return procfuse_writePODArrayHandle(handle, index, T_PROC_POD_INT, &value);
+}
+int procfuse_writePODArrayHandle_i64(struct procfuse_podhandle *handle, size_t index, int64_t newvalue){
+	union procfuse_pod value;
+
+	value.l = newvalue;
+	return procfuse_writePODArrayHandle(handle, index, T_PROC_POD_INT64, &value);
+}
+int procfuse_writePODArrayHandle_f(struct procfuse_podhandle *handle, size_t index, float newvalue){
+	union procfuse_pod value;
+
+	value.f = newvalue;
+	return procfuse_writePODArrayHandle(handle, index, T_PROC_POD_FLOAT, &value);
+}
+int procfuse_writePODArrayHandle_d(struct procfuse_podhandle *handle, size_t index, double newvalue){
+	union procfuse_pod value;
+
+	value.d = newvalue;
+	return procfuse_writePODArrayHandle(handle, index, T_PROC_POD_DOUBLE, &value);
+}
+int procfuse_readPODArrayHandle_i(struct procfuse_podhandle *handle, size_t index, int *value){
+	union procfuse_pod pod;
+
+	if(!procfuse_readPODArrayHandle(handle, index, T_PROC_POD_INT, &pod) || value==NULL){
+		return 0;
+	}
+	*value = pod.i;
+	return 1;
+}
+int procfuse_readPODArrayHandle_i64(struct procfuse_podhandle *handle, size_t index, int64_t *value){
+	union procfuse_pod pod;
+
+	if(!procfuse_readPODArrayHandle(handle, index, T_PROC_POD_INT64, &pod) || value==NULL){
+		return 0;
+	}
+	*value = pod.l;
+	return 1;
+}
+int procfuse_readPODArrayHandle_f(struct procfuse_podhandle *handle, size_t index, float *value){
+	union procfuse_pod pod;
+
+	if(!procfuse_readPODArrayHandle(handle, index, T_PROC_POD_FLOAT, &pod) || value==NULL){
+		return 0;
+	}
+	*value = pod.f;
+	return 1;
+}
+int procfuse_readPODArrayHandle_d(struct procfuse_podhandle *handle, size_t index, double *value){
+	union procfuse_pod pod;
+
+	if(!procfuse_readPODArrayHandle(handle, index, T_PROC_POD_DOUBLE, &pod) || value==NULL){
+		return 0;
+	}
+	*value = pod.d;
+	return 1;
+}
+int procfuse_addPODArrayHandle_i(struct procfuse_podhandle *handle, size_t index, int delta, int *newvalue){
+	union procfuse_pod value, result;
+
+	value.i = delta;
+	if(!procfuse_addPODArrayHandle(handle, index, T_PROC_POD_INT, &value, &result)){
+		return 0;
+	}
+	if(newvalue!=NULL){
+		*newvalue = result.i;
+	}
+	return 1;
+}
+int procfuse_addPODArrayHandle_i64(struct procfuse_podhandle *handle, size_t index, int64_t delta, int64_t *newvalue){
+	union procfuse_pod value, result;
+
+	value.l = delta;
+	if(!procfuse_addPODArrayHandle(handle, index, T_PROC_POD_INT64, &value, &result)){
+		return 0;
+	}
+	if(newvalue!=NULL){
+		*newvalue = result.l;
+	}
+	return 1;
+}
+int procfuse_addPODArrayHandle_f(struct procfuse_podhandle *handle, size_t index, float delta, float *newvalue){
+	union procfuse_pod value, result;
+
+	value.f = delta;
+	if(!procfuse_addPODArrayHandle(handle, index, T_PROC_POD_FLOAT, &value, &result)){
+		return 0;
+	}
+	if(newvalue!=NULL){
+		*newvalue = result.f;
+	}
+	return 1;
+}
+int procfuse_addPODArrayHandle_d(struct procfuse_podhandle *handle, size_t index, double delta, double *newvalue){
+	union procfuse_pod value, result;
+
+	value.d = delta;
+	if(!procfuse_addPODArrayHandle(handle, index, T_PROC_POD_DOUBLE, &value, &result)){
+		return 0;
+	}
+	if(newvalue!=NULL){
+		*newvalue = result.d;
+	}
+	return 1;
+}
+
+/* record PODs */
+
+void procfuse_freePODRecord(struct procfuse_pod_record *record){
+	size_t i = 0;
+
+	if(record==NULL){
+		return;
+	}
+	pthread_mutex_destroy(&record->lock);
+	if(record->fields!=NULL){
+		for(i=0;i<record->count;++i){
+			free((char*)record->fields[i].name);
+		}
+	}
+	free(record->fields);
+	free(record->text);
+	free(record);
+}
+/* the pod type of a field, T_PROC_POD_NO if it has none */
+procfuse_pod_t procfuse_fieldType(int type){
+	switch(type){
+		case PROCFUSE_FIELD_CHAR: return T_PROC_POD_CHAR;
+		case PROCFUSE_FIELD_INT: return T_PROC_POD_INT;
+		case PROCFUSE_FIELD_INT64: return T_PROC_POD_INT64;
+		case PROCFUSE_FIELD_FLOAT: return T_PROC_POD_FLOAT;
+		case PROCFUSE_FIELD_DOUBLE: return T_PROC_POD_DOUBLE;
+		case PROCFUSE_FIELD_LONGDOUBLE: return T_PROC_POD_LONGDOUBLE;
+		default: return T_PROC_POD_NO;
+	}
+}
+size_t procfuse_fieldSize(procfuse_pod_t type){
+	switch(type){
+		case T_PROC_POD_CHAR: return sizeof(char);
+		case T_PROC_POD_INT: return sizeof(int);
+		case T_PROC_POD_INT64: return sizeof(int64_t);
+		case T_PROC_POD_FLOAT: return sizeof(float);
+		case T_PROC_POD_DOUBLE: return sizeof(double);
+		case T_PROC_POD_LONGDOUBLE: return sizeof(long double);
+		default: return 0;
+	}
+}
+/* names are shown in front of the values and looked up by writes, so they can't contain blanks or '=' and have to be unique */
+int procfuse_isFieldName(const struct procfuse_field *fields, size_t index){
+	const char *c = fields[index].name;
+	size_t i = 0;
+
+	if(c==NULL || *c=='\0'){
+		return PROCFUSE_NO;
+	}
+	for(;*c!='\0';++c){
+		if(procfuse_isBlank(*c) || *c=='='){
+			return PROCFUSE_NO;
+		}
+	}
+	for(i=0;i<index;++i){
+		if(strcmp(fields[i].name, fields[index].name)==0){
+			return PROCFUSE_NO;
+		}
+	}
+	return PROCFUSE_YES;
+}
+struct procfuse_pod_record* procfuse_newPODRecord(const struct procfuse_field *fields, size_t count, void *data){
+	struct procfuse_pod_record *record = NULL;
+	size_t i = 0;
+
+	for(i=0;i<count;++i){
+		if(!procfuse_isFieldName(fields, i) || procfuse_fieldType(fields[i].type)==T_PROC_POD_NO){
+			errno = EINVAL;
+			return NULL;
+		}
+	}
+
+	record = (struct procfuse_pod_record*)calloc(1, sizeof(struct procfuse_pod_record));
+	if(record==NULL){
+		errno = ENOMEM;
+		return NULL;
+	}
+	if(pthread_mutex_init(&record->lock, NULL)!=0){
+		free(record);
+		return NULL;
+	}
+	record->data = data;
+	record->fields = (struct procfuse_field*)calloc(count, sizeof(struct procfuse_field));
+	if(record->fields==NULL){
+		procfuse_freePODRecord(record);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for(i=0;i<count;++i){
+		record->fields[i].type = fields[i].type;
+		record->fields[i].offset = fields[i].offset;
+		record->fields[i].name = strdup(fields[i].name);
+		record->count = i+1;
+		if(record->fields[i].name==NULL){
+			procfuse_freePODRecord(record);
+			errno = ENOMEM;
+			return NULL;
+		}
+		record->textsize += strlen(fields[i].name) + 1 + PROCFUSE_RECORDVALUELEN + 1;
+	}
+	record->text = (char*)malloc(record->textsize+1);
+	if(record->text==NULL){
+		procfuse_freePODRecord(record);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return record;
+}
+/* renders every field as a "name value" line and returns the length of the text, the caller holds record->lock */
+size_t procfuse_renderPODRecord(struct procfuse_pod_record *record){
+	union procfuse_pod value;
+	procfuse_pod_t type = T_PROC_POD_NO;
+	size_t i = 0, length = 0, namelength = 0;
+	int n = 0;
+
+	for(i=0;i<record->count;++i){
+		type = procfuse_fieldType(record->fields[i].type);
+		memcpy(&value, (const char*)record->data+record->fields[i].offset, procfuse_fieldSize(type));
+
+		namelength = strlen(record->fields[i].name);
+		memcpy(record->text+length, record->fields[i].name, namelength);
+		length += namelength;
+		record->text[length++] = ' ';
+		n = procfuse_renderPOD(type, &value, record->text+length, PROCFUSE_RECORDVALUELEN+1);
+		length += (n<PROCFUSE_RECORDVALUELEN) ? n : PROCFUSE_RECORDVALUELEN;
+		record->text[length++] = '\n';
+	}
+
+	return length;
+}
+/* the field called like the length bytes at name, -1 if there's none */
+ssize_t procfuse_findField(const struct procfuse_pod_record *record, const char *name, size_t length){
+	size_t i = 0;
+
+	for(i=0;i<record->count;++i){
+		if(strncmp(record->fields[i].name, name, length)==0 && record->fields[i].name[length]=='\0'){
+			return (ssize_t)i;
+		}
+	}
+	return -1;
+}
+/* parses a "name=value" line into the value of its field, returns 0 or an errno */
+int procfuse_parseFieldLine(const struct procfuse_pod_record *record, const char *line, size_t length, size_t *index, union procfuse_pod *value){
+	const char *equal = (const char*)memchr(line, '=', length), *text = NULL, *end = NULL, *last = line+length;
+	char ldtmp[PROCFUSE_RECORDVALUELEN+1];
+	ssize_t field = 0;
+	size_t textlength = 0;
+	procfuse_pod_t type = T_PROC_POD_NO;
+	int rval = 0;
+
+	if(equal==NULL || (field = procfuse_findField(record, line, equal-line))<0){
+		return EINVAL;
+	}
+	*index = (size_t)field;
+	type = procfuse_fieldType(record->fields[field].type);
+	text = equal+1;
+	textlength = last-text;
+
+	switch(type){
+		case T_PROC_POD_CHAR:
+			if(textlength==0){
+				return EINVAL;
+			}
+			value->c = text[0];
+			end = text+1;
+			break;
+		case T_PROC_POD_LONGDOUBLE:
+			/* strtold() needs a terminated copy */
+			if(textlength>PROCFUSE_RECORDVALUELEN){
+				return EINVAL;
+			}
+			memcpy(ldtmp, text, textlength);
+			ldtmp[textlength] = '\0';
+			rval = procfuse_parsePOD(type, ldtmp, textlength, value, &end);
+			end = text+(end-ldtmp);
+			break;
+		default:
+			rval = procfuse_parsePOD(type, text, textlength, value, &end);
+			break;
+	}
+
+	/* the value is the rest of the line, up to trailing blanks */
+	for(;rval==0 && end!=last;++end){
+		if(!procfuse_isBlank(*end)){
+			rval = EINVAL;
+		}
+	}
+
+	return rval;
+}
+
+int procfuse_createRecord(struct procfuse *pf, const char *absolutepath, int flags, const struct procfuse_field *fields, size_t count, void *record){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL;
+	struct procfuse_pod_record *podrecord = NULL;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutepath==NULL || fields==NULL || count==0 || record==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	podrecord = procfuse_newPODRecord(fields, count, record);
+	if(podrecord==NULL){
+		return 0;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	node = procfuse_createNode(pf, absolutepath);
+	if(node!=NULL && !procfuse_isReplaceable(node)){
+		errno = EEXIST;
+	}
+	else if(node!=NULL){
+		ino = procfuse_cachedInode(node);
+		pollers = procfuse_changeNode(pf, node);
+		procfuse_releasePODValue(node);
+
+		memset(&node->onevent, '\0', sizeof(node->onevent));
+		node->onevent.onFuseRead = procfuse_onFuseReadPODRecord;
+		node->onevent.onFuseWrite = procfuse_onFuseWritePODRecord;
+
+		memset(&node->onpodevent, '\0', sizeof(node->onpodevent));
+		node->onpodevent.type = T_PROC_POD_RECORD;
+		node->onpodevent.value.record = podrecord;
+		node->flags = flags;
+		node->backed = PROCFUSE_NO;
+
+		gettimeofday(&node->created, NULL);
+
+		podrecord = NULL;
+		rval = 1;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_freePODRecord(podrecord);
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+int procfuse_lockRecord(struct procfuse_podhandle *handle){
+	if(handle==NULL || handle->node->onpodevent.type!=T_PROC_POD_RECORD){
+		errno = EINVAL;
+		return 0;
+	}
+	pthread_mutex_lock(&handle->node->onpodevent.value.record->lock);
+	return 1;
+}
+/* the application changed the fields, readers see the new values */
+int procfuse_unlockRecord(struct procfuse_podhandle *handle){
+	if(handle==NULL || handle->node->onpodevent.type!=T_PROC_POD_RECORD){
+		errno = EINVAL;
+		return 0;
+	}
+	pthread_mutex_unlock(&handle->node->onpodevent.value.record->lock);
+	procfuse_podHandleChanged(handle);
+	return 1;
+}
+
+/* binary view of PODs */
+
+/* the values of a binary view are appended in the same order twice, first with values NULL to measure them */
+struct procfuse_binarylayout{
+	struct procfuse_binaryentry *entries; /* NULL if only the values are wanted */
+	char *names;
+	char *values;
+	uint32_t count;
+	uint32_t nameslength;
+	uint32_t valueslength;
+};
+
+int procfuse_binaryFieldType(procfuse_pod_t type){
+	switch(type){
+		case T_PROC_POD_CHAR: return PROCFUSE_FIELD_CHAR;
+		case T_PROC_POD_INT: return PROCFUSE_FIELD_INT;
+		case T_PROC_POD_INT64: return PROCFUSE_FIELD_INT64;
+		case T_PROC_POD_FLOAT: return PROCFUSE_FIELD_FLOAT;
+		case T_PROC_POD_DOUBLE: return PROCFUSE_FIELD_DOUBLE;
+		case T_PROC_POD_LONGDOUBLE: return PROCFUSE_FIELD_LONGDOUBLE;
+		default: return 0;
+	}
+}
+/* PROCFUSE_YES if node has a binary view, numeric PODs, arrays and records */
+int procfuse_hasBinary(const struct procfuse_hashnode *node){
+	return (procfuse_binaryFieldType(node->onpodevent.type)!=0 ||
+	        node->onpodevent.type==T_PROC_POD_ARRAY || node->onpodevent.type==T_PROC_POD_RECORD) ? PROCFUSE_YES : PROCFUSE_NO;
+}
+/* adds an entry of count values named "name" or "name.suffix", every value is aligned to its size
+ * returns where the values go, NULL while measuring
+ */
+char* procfuse_reserveBinary(struct procfuse_binarylayout *layout, const char *name, const char *suffix, procfuse_pod_t type, uint32_t count){
+	struct procfuse_binaryentry *entry = NULL;
+	uint32_t size = (uint32_t)procfuse_fieldSize(type), namelength = 0;
+
+	layout->valueslength = (layout->valueslength + size-1) / size * size;
+
+	if(name!=NULL){
+		namelength = (uint32_t)strlen(name);
+		if(layout->entries!=NULL){
+			entry = &layout->entries[layout->count];
+			entry->name = layout->nameslength;
+			entry->type = (uint32_t)procfuse_binaryFieldType(type);
+			entry->offset = layout->valueslength;
+			entry->count = count;
+
+			memcpy(layout->names+layout->nameslength, name, namelength);
+			if(suffix!=NULL){
+				layout->names[layout->nameslength+namelength] = '.';
+				memcpy(layout->names+layout->nameslength+namelength+1, suffix, strlen(suffix));
+			}
+		}
+		if(suffix!=NULL){
+			namelength += 1 + (uint32_t)strlen(suffix);
+		}
+		if(layout->entries!=NULL){
+			layout->names[layout->nameslength+namelength] = '\0';
+		}
+		layout->nameslength += namelength + 1;
+		layout->count++;
+	}
+
+	layout->valueslength += size*count;
+
+	return (layout->values!=NULL) ? layout->values + layout->valueslength - size*count : NULL;
+}
+/* appends the values of node, the caller holds pf->lock so its type doesn't change meanwhile
+ * name is NULL if only the values are wanted
+ */
+void procfuse_appendBinary(struct procfuse_hashnode *node, const char *name, struct procfuse_binarylayout *layout){
+	struct procfuse_pod_array *array = NULL;
+	struct procfuse_pod_record *record = NULL;
+	union procfuse_pod value;
+	procfuse_pod_t type = T_PROC_POD_NO;
+	size_t size = 0, i = 0;
+	char *slot = NULL;
+
+	switch(node->onpodevent.type){
+		case T_PROC_POD_ARRAY:
+			array = node->onpodevent.value.array;
+			size = procfuse_fieldSize(array->type);
+			slot = procfuse_reserveBinary(layout, name, NULL, array->type, (uint32_t)array->length);
+			for(i=0;slot!=NULL && i<array->length;++i){
+				procfuse_loadArrayElement(array, i, &value);
+				memcpy(slot+i*size, &value, size);
+			}
+			break;
+		case T_PROC_POD_RECORD:
+			record = node->onpodevent.value.record;
+			pthread_mutex_lock(&record->lock);
+			for(i=0;i<record->count;++i){
+				type = procfuse_fieldType(record->fields[i].type);
+				slot = procfuse_reserveBinary(layout, name, record->fields[i].name, type, 1);
+				if(slot!=NULL){
+					memcpy(slot, (const char*)record->data+record->fields[i].offset, procfuse_fieldSize(type));
+				}
+			}
+			pthread_mutex_unlock(&record->lock);
+			break;
+		default:
+			if(procfuse_binaryFieldType(node->onpodevent.type)==0){
+				break;
+			}
+			slot = procfuse_reserveBinary(layout, name, NULL, node->onpodevent.type, 1);
+			if(slot!=NULL){
+				procfuse_loadPOD(&node->onpodevent, &value);
+				memcpy(slot, &value, procfuse_fieldSize(node->onpodevent.type));
+			}
+			break;
+	}
+}
+/* the binary view of the files in a directory, the caller holds pf->lock
+ * renders the view into buffer if it's not NULL and returns its length
+ */
+size_t procfuse_renderBinaryView(const struct procfuse_dirindex *index, char *buffer){
+	struct procfuse_binarylayout layout;
+	struct procfuse_binaryheader header;
+	struct procfuse_hashnode *child = NULL;
+	size_t i = 0, length = 0;
+
+	memset(&layout, 0, sizeof(layout));
+	for(i=0;i<index->count;++i){
+		child = index->entries[i].node;
+		if(child!=NULL && !procfuse_isPendingForUnlink(child) && child->subdirs==NULL){
+			procfuse_appendBinary(child, child->key->name, &layout);
+		}
+	}
+
+	header.magic = PROCFUSE_BINARY_MAGIC;
+	header.count = layout.count;
+	header.names = sizeof(header) + layout.count*sizeof(struct procfuse_binaryentry);
+	/* long doubles are aligned to 16 bytes, so are the values */
+	header.values = (header.names + layout.nameslength + 15) / 16 * 16;
+	length = header.values + layout.valueslength;
+
+	if(buffer!=NULL){
+		memset(buffer, '\0', length);
+
+		memset(&layout, 0, sizeof(layout));
+		layout.entries = (struct procfuse_binaryentry*)(buffer+sizeof(header));
+		layout.names = buffer+header.names;
+		layout.values = buffer+header.values;
+		for(i=0;i<index->count;++i){
+			child = index->entries[i].node;
+			if(child!=NULL && !procfuse_isPendingForUnlink(child) && child->subdirs==NULL){
+				procfuse_appendBinary(child, child->key->name, &layout);
+			}
+		}
+		/* a file unlinked since measuring is left out, its space stays zeroed */
+		header.count = layout.count;
+		memcpy(buffer, &header, sizeof(header));
+	}
+
+	return length;
+}
+/* the directory of a binary view, NULL for the root - the caller holds pf->lock */
+const struct procfuse_dirindex* procfuse_binaryViewIndex(struct procfuse *pf, const struct procfuse_hashnode *node){
+	const char *slash = strrchr(node->absolutepath, '/');
+	struct procfuse_hashnode *directory = NULL;
+	char *path = NULL;
+
+	if(slash==node->absolutepath){
+		return &pf->rootindex;
+	}
+	path = strndup(node->absolutepath, slash-node->absolutepath);
+	if(path==NULL){
+		return NULL;
+	}
+	directory = procfuse_pathToNode(pf, path, PROCFUSE_NO);
+	free(path);
+
+	return (directory!=NULL && directory->subdirs!=NULL) ? &directory->index : NULL;
+}
+
+int procfuse_setBinaryView(struct procfuse *pf, const char *absolutedirectorypath, int yes_or_no){
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL, *directory = NULL;
+	const struct procfuse_dirindex *index = NULL;
+	char *path = NULL;
+	size_t length = 0;
+	fuse_ino_t ino = 0;
+	struct fuse_pollhandle **pollers = NULL;
+
+	if(pf==NULL || absolutedirectorypath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+	length = strlen(absolutedirectorypath) + 1 + strlen(PROCFUSE_BINARY_FILE) + 1;
+	path = (char*)malloc(length);
+	if(path==NULL){
+		errno = ENOMEM;
+		return 0;
+	}
+	snprintf(path, length, "%s/%s", (strcmp(absolutedirectorypath, "/")==0) ? "" : absolutedirectorypath, PROCFUSE_BINARY_FILE);
+
+	if(yes_or_no==PROCFUSE_NO){
+		node = procfuse_acquireAccessToNode(pf, path);
+		rval = (node!=NULL && node->onpodevent.type==T_PROC_POD_BINARY);
+		procfuse_releaseAccessToNode(pf, node);
+		if(rval){
+			rval = procfuse_unlink(pf, path);
+		}
+		else{
+			errno = ENOENT;
+		}
+		free(path);
+		return rval;
+	}
+
+	pthread_rwlock_wrlock(&pf->lock);
+
+	if(strcmp(absolutedirectorypath, "/")==0){
+		index = &pf->rootindex;
+	}
+	else if((directory = procfuse_pathToNode(pf, absolutedirectorypath, PROCFUSE_NO))!=NULL && directory->subdirs!=NULL){
+		index = &directory->index;
+	}
+
+	if(index==NULL){
+		errno = ENOTDIR;
+	}
+	else if((node = procfuse_createNode(pf, path))!=NULL){
+		if(node->onpodevent.type==T_PROC_POD_BINARY){
+			rval = 1;
+		}
+		else if(!procfuse_isReplaceable(node)){
+			errno = EEXIST;
+		}
+		else{
+			ino = procfuse_cachedInode(node);
+			pollers = procfuse_changeNode(pf, node);
+			procfuse_releasePODValue(node);
+
+			memset(&node->onevent, '\0', sizeof(node->onevent));
+			node->onevent.onFuseRead = procfuse_onFuseReadBinaryView;
+
+			memset(&node->onpodevent, '\0', sizeof(node->onpodevent));
+			node->onpodevent.type = T_PROC_POD_BINARY;
+			node->flags = O_RDONLY;
+			node->backed = PROCFUSE_NO;
+
+			gettimeofday(&node->created, NULL);
+
+			rval = 1;
+		}
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_notifyPollers(pollers);
+	procfuse_invalidateInode(pf, ino);
+	free(path);
+
+	return rval;
+}
+
+int procfuse_isPOD(struct procfuse *pf, const char *absolutepath){
+	struct procfuse_hashnode *node = NULL;
+	int rval = PROCFUSE_NO;
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL && node->onpodevent.type>T_PROC_POD_NO && node->onpodevent.type<T_PROC_POD_BINARY){
+		rval = PROCFUSE_YES;
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	return rval;
+}
+
+int procfuse_exists(struct procfuse *pf, const char *absolutepath){
+	struct procfuse_hashnode *node = NULL;
+	int rval = PROCFUSE_NO;
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL){
+		rval = PROCFUSE_YES;
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	return rval;
+}
+int procfuse_chmod(struct procfuse *pf, const char *absolutepath, mode_t mode){
+	struct procfuse_hashnode *node = NULL;
+	int rval = PROCFUSE_NO;
+	fuse_ino_t ino = 0;
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL){
+		node->mode = mode;
+		rval = PROCFUSE_YES;
+		ino = procfuse_cachedInode(node);
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+int procfuse_chown(struct procfuse *pf, const char *absolutepath, uid_t owner, gid_t group){
+	struct procfuse_hashnode *node = NULL;
+	int rval = PROCFUSE_NO;
+	fuse_ino_t ino = 0;
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL){
+		node->uid = owner;
+		node->gid = group;
+		rval = PROCFUSE_YES;
+		ino = procfuse_cachedInode(node);
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+int procfuse_utime(struct procfuse *pf, const char *absolutepath, const struct utimbuf *times){
+	struct procfuse_hashnode *node = NULL;
+	int rval = PROCFUSE_NO;
+	fuse_ino_t ino = 0;
+	if(pf==NULL || absolutepath==NULL || times==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL){
+		node->access.tv_sec = times->actime;
+		node->access.tv_usec = 0;
+		node->modify.tv_sec = times->modtime;
+		node->modify.tv_usec = 0;
+		rval = PROCFUSE_YES;
+		ino = procfuse_cachedInode(node);
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+int procfuse_utimes(struct procfuse *pf, const char *absolutepath, const struct timeval times[2]){
+	struct procfuse_hashnode *node = NULL;
+	int rval = PROCFUSE_NO;
+	fuse_ino_t ino = 0;
+	if(pf==NULL || absolutepath==NULL){
+		errno = EINVAL;
+		return 0;
+	}
+
+	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	if(node!=NULL){
+		node->access = times[0];
+		node->modify = times[1];
+		rval = PROCFUSE_YES;
+		ino = procfuse_cachedInode(node);
+	}
+	procfuse_releaseAccessToNode(pf, node);
+
+	procfuse_invalidateInode(pf, ino);
+
+	return rval;
+}
+
+int procfuse_onFuseOpenPOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata){
+	int rval = 0;
+	struct procfuse_transactionnode *tnode = NULL;
+	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
+
+	(void)(path);
+
+	/* transactions not needed for read only files */
+	if((node->flags & O_ACCMODE) == O_RDONLY ||
+	   node->onpodevent.type==T_PROC_POD_STRING || node->onpodevent.type==T_PROC_POD_CHAR)
+		return rval;
+
+	tnode = (struct procfuse_transactionnode *)slab_alloc(pf->transactionslab);
+	if(tnode==NULL){
+		return -EIO;
+	}
+	tnode->pf = node->pf;
+	tnode->tid = tid;
+	tnode->length = PROCFUSE_WRITEBUFFERLEN;
+	tnode->haswritten = 0;
+	tnode->writebuffer = (char*)slab_alloc(pf->writebufferslab);
+	if(tnode->writebuffer==NULL){
+		slab_release(pf->transactionslab, tnode);
+		return -ENOMEM;
+	}
+	tnode->writebuffer[0] = '\0';
+
+	procfuse_upgradeNodeReadLockToWriteLock(node);
+
+	if((node->transactions==NULL && procfuse_ctorht(node->pf, &node->transactions, PROCFUSE_NO)==0) ||
+	   hash_table_insert(node->transactions, &tnode->tid, tnode)==0){
+		slab_release(pf->writebufferslab, tnode->writebuffer);
+		slab_release(pf->transactionslab, tnode);
+
+		tnode = NULL;
+		rval = -ENOMEM;
+	}
+
+	procfuse_downgradeNodeWriteLockToReadLock(node);
+
+    return rval;
+}
+/* formats a numeric POD value the way it's read from the file and returns the length of the text
+ * like snprintf the text is cut to size-1 bytes and terminated, the returned length is the one of the whole text
+ * floats and doubles are written with the fewest digits reading back to the same value, see format-number.h
+ */
+int procfuse_renderPOD(procfuse_pod_t type, const union procfuse_pod *value, char *buffer, size_t size){
+	char text[FORMAT_NUMBER_MAX];
+	char *out = (size>=FORMAT_NUMBER_MAX) ? buffer : text;
+	size_t length = 0;
+
+	switch(type){
+		case T_PROC_POD_CHAR:
+			if(size<1){
+				return 0;
+			}
+			buffer[0] = value->c;
+			return 1;
+		case T_PROC_POD_INT:
+			length = format_int32(value->i, out);
+			break;
+		case T_PROC_POD_INT64:
+			length = format_int64(value->l, out);
+			break;
+		case T_PROC_POD_FLOAT:
+			length = format_float(value->f, out);
+			break;
+		case T_PROC_POD_DOUBLE:
+			length = format_double(value->d, out);
+			break;
+		case T_PROC_POD_LONGDOUBLE:
+			return snprintf(buffer, size, "%Le", value->ld);
+		default:
+			return 0;
+	}
+
+	if(out==text && size>0){
+		memcpy(buffer, text, (length<size) ? length : size-1);
+		buffer[(length<size) ? length : size-1] = '\0';
+	}
+
+	return (int)length;
+}
+int procfuse_isBlank(char c){
+	return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\v' || c=='\f' || c=='\0';
+}
+/* parses the text written to a numeric POD: blanks, the number, then the end of the text or a blank
+ * whatever follows that blank is ignored, it's the rest of the old text when only its beginning was overwritten
+ * returns 0, EINVAL if the text isn't a number of the type or ERANGE if it doesn't fit, the value is only set on 0
+ * long doubles go through strtold, so their text has to be terminated at text[length]
+ */
+int procfuse_parsePOD(procfuse_pod_t type, const char *text, size_t length, union procfuse_pod *value, const char **end){
+	const char *first = text, *last = text + length, *p = NULL;
+	char *ldend = NULL;
+	long double ld;
+	int rval = 0;
+
+	while(first!=last && procfuse_isBlank(*first) && *first!='\0'){
+		++first;
+	}
+	p = first;
+
+	switch(type){
+		case T_PROC_POD_INT:
+			rval = parse_int32(first, last, &value->i, &p);
+			break;
+		case T_PROC_POD_INT64:
+			rval = parse_int64(first, last, &value->l, &p);
+			break;
+		case T_PROC_POD_FLOAT:
+			rval = parse_float(first, last, &value->f, &p);
+			break;
+		case T_PROC_POD_DOUBLE:
+			rval = parse_double(first, last, &value->d, &p);
+			break;
+		case T_PROC_POD_LONGDOUBLE:
+			errno = 0;
+			ld = strtold(first, &ldend);
+			p = ldend;
+			if(p==first || p>last){
+				p = first;
+				rval = EINVAL;
+			}
+			else if(errno==ERANGE && (ld>LDBL_MAX || ld<-LDBL_MAX)){
+				rval = ERANGE;
+			}
+			else{
+				value->ld = ld;
+			}
+			break;
+		default:
+			rval = EINVAL;
+			break;
+	}
+
+	if(rval==0 && p!=last && !procfuse_isBlank(*p)){
+		rval = EINVAL;
+	}
+	if(end!=NULL){
+		*end = p;
+	}
+
+	return rval;
+}
+
+int procfuse_onFuseReadPOD(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	int rval = 0, printed = 0;
+	off_t where = 0;
+	size_t cpylen = 0;
+	char podtmp[8192]; /* more than long enough for pod datatypes - 80bit long double range is 3.65×10^−4951 to 1.18×10^4932  */
+	union procfuse_pod value;
+	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
+
+	(void)pf;
+	(void)path;
+	(void)tid;
+	(void)size;
+
+	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_RDONLY)==O_RDONLY)){
+		return 0;
+	}
+
+	printed = 0;
+
+	/* the caller holds the read lock of the node, that's enough - see procfuse_loadPOD() */
+	procfuse_loadPOD(&node->onpodevent, &value);
+
+	switch(node->onpodevent.type){
+		case T_PROC_POD_CHAR:
+			if(offset==0){
+			    buffer[0] = value.c;
+			    rval = 1;
+			}
+			else
+				rval = 0;
+			break;
+		case T_PROC_POD_INT:
+		case T_PROC_POD_INT64:
+		case T_PROC_POD_FLOAT:
+		case T_PROC_POD_DOUBLE:
+		case T_PROC_POD_LONGDOUBLE:
+			printed = procfuse_renderPOD(node->onpodevent.type, &value, podtmp, sizeof(podtmp)-1);
+			break;
+		case T_PROC_POD_STRING:
+			if(node->onpodevent.value.str.length_r==0 || node->onpodevent.value.str.mmapedbuffer_r==NULL){
+				rval = 0;
+				break;
+			}
+
+			where = offset;
+			cpylen = size;
+			if(where>node->onpodevent.value.str.length_r){
+				rval = 0;
+				break;
+			}
+			if(cpylen>(size_t)((node->onpodevent.value.str.length_r)-where)){
+				cpylen = (node->onpodevent.value.str.length_r)-where;
+			}
+			memcpy(buffer, (node->onpodevent.value.str.mmapedbuffer_r)+where, cpylen);
+			rval = cpylen;
+			break;
+		default: break;
+	}
+	if(node->onpodevent.type!=T_PROC_POD_STRING && node->onpodevent.type!=T_PROC_POD_CHAR){
+	    if(offset>printed){
+		    rval = -EINVAL;
+	    }
+	    else{
+	        memcpy(buffer, podtmp+offset,printed-offset);
+	        rval = printed-offset;
+	    }
+	}
+
+	return rval;
+}
+
+/* keeps the text a write transaction stored last, procfuse_onFuseReleasePOD() commits it */
+void procfuse_keepTransactionText(struct procfuse_transactionnode *tnode, const char *text, size_t length){
+	if(tnode==NULL){
+		return;
+	}
+	if(length > (size_t)tnode->length-1){
+		length = tnode->length-1;
+	}
+	memcpy(tnode->writebuffer, text, length);
+	tnode->writebuffer[length] = '\0';
+}
+int procfuse_onFuseWritePOD(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	int rval = 0;
+	char podtmp[8192]; /* more than long enough for pod datatypes - 80bit long double range is 3.65×10^−4951 to 1.18×10^4932  */
+	size_t length = 0;
+	const char *end = NULL;
+	union procfuse_pod value;
+	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
+	struct procfuse_transactionnode *tnode = NULL;
+
+	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_WRONLY)==O_WRONLY)){
+		return 0;
+	}
+
+	if(size<=0){
+		return 0;
+	}
+
+	/* transactions are only inserted and removed with the write lock of the node being held */
+	if(node->transactions!=NULL)
+		tnode=(struct procfuse_transactionnode *)hash_table_lookup(node->transactions, &tid);
+
+	/*
+	if(tnode==NULL && node->onpodevent.type!=T_PROC_POD_CHAR && node->onpodevent.type!=T_PROC_POD_STRING){
+		rval = -EIO;
+		return rval;
+	}
+	*/
+
+/*
+    if(rval==0 && node->onpodevent.type ==T_PROC_POD_STRING && node->onpodevent.touch)
+        node->onpodevent.touch(pf, path, tid, O_WRONLY, PROCFUSE_PRE, pf->appdata);
+*/
+
+	switch(node->onpodevent.type){
+	    case T_PROC_POD_CHAR:
+	    	value.c = buffer[size-1]; /* write the last char in buffer */
+	    	procfuse_storePOD(&node->onpodevent, &value);
+	        rval = 1;
+		    break;
+	    case T_PROC_POD_STRING:
+	    	procfuse_upgradeNodeReadLockToWriteLock(node);
+	    	if(node->onpodevent.value.str.length_r==0 || node->onpodevent.value.str.mmapedbuffer_r==NULL){
+	    		rval = -EIO;
+	    	}
+	    	else if(offset > node->onpodevent.value.str.length_r){
+	    		rval = -EFBIG;
+	    	}
+	    	else{
+				if((off_t)size > ((off_t)node->onpodevent.value.str.length_r-offset)){
+					size = ((off_t)node->onpodevent.value.str.length_r-offset);
+				}
+				if(size>0){
+					memcpy(node->onpodevent.value.str.mmapedbuffer_r+offset, buffer, size);
+				}
+				rval = size;
+	    	}
+	    	procfuse_downgradeNodeWriteLockToReadLock(node);
+		    break;
 	    default:
-		    /* error */
-	    	break;
+	    	if(offset > (off_t)(sizeof(podtmp)-1)){
+	    		rval = -EFBIG;
+	    		break;
+	    	}
+
+	    	/* a number ended by a blank within the written bytes doesn't depend on the old text, "echo 42 >" never renders it */
+	    	if(offset==0 && node->onpodevent.type!=T_PROC_POD_LONGDOUBLE &&
+	    	   procfuse_parsePOD(node->onpodevent.type, buffer, size, &value, &end)==0 && end<buffer+size){
+	    		procfuse_storePOD(&node->onpodevent, &value);
+	    		procfuse_keepTransactionText(tnode, buffer, size);
+	    		rval = size;
+	    		break;
+	    	}
+
+	    	/* otherwise the written bytes replace those of the old text */
+	    	if((rval=procfuse_onFuseReadPOD(pf, path, podtmp, sizeof(podtmp), 0, tid, appdata))>0){
+	    		length = rval;
+	    		if(offset > (off_t)length){
+	    			memset(podtmp+length, '0', offset-length);
+	    			length = offset;
+	    		}
+	    		if((off_t)size > ((off_t)sizeof(podtmp)-1-offset)){
+	    			size = ((off_t)sizeof(podtmp)-1-offset);
+	    		}
+
+	    		memcpy(podtmp+offset, buffer, size);
+	    		if(offset+size > length){
+	    			length = offset+size;
+	    		}
+	    		podtmp[length] = '\0';
+
+	    		rval = -procfuse_parsePOD(node->onpodevent.type, podtmp, length, &value, NULL);
+	    		if(rval==0){
+	    			procfuse_storePOD(&node->onpodevent, &value);
+	    			procfuse_keepTransactionText(tnode, podtmp, length);
+	    			rval = size;
+	    		}
+	    	}
+
+		    break;
+	}
+
+	if(rval > 0){
+	    if(node->onpodevent.type!=T_PROC_POD_STRING && tnode!=NULL)
+		    tnode->haswritten = 1;
+/*	    if(node->onpodevent.type ==T_PROC_POD_STRING && node->onpodevent.touch)
+	        node->onpodevent.touch(pf, path, tid, O_WRONLY, PROCFUSE_POST, pf->appdata);
+*/
+	}
+
+	return rval;
+}
+
+int procfuse_callPODModify(const struct procfuse *pf, const char *path, struct procfuse_hashnode *node, union procfuse_pod *newvalue){
+	int rval = 0;
+
+	if(node->onpodevent.onModify!=NULL){
+		switch(node->onpodevent.type){
+			case T_PROC_POD_CHAR:
+				rval = ((procfuse_onModify_c)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->c);
+				break;
+			case T_PROC_POD_INT:
+				rval = ((procfuse_onModify_i)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->i);
+				break;
+			case T_PROC_POD_INT64:
+				rval = ((procfuse_onModify_i64)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->l);
+				break;
+			case T_PROC_POD_FLOAT:
+				rval = ((procfuse_onModify_f)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->f);
+				break;
+			case T_PROC_POD_DOUBLE:
+				rval = ((procfuse_onModify_d)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->d);
+				break;
+			case T_PROC_POD_LONGDOUBLE:
+				rval = ((procfuse_onModify_ld)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->ld);
+				break;
+			case T_PROC_POD_STRING:
+				rval = ((procfuse_onModify_s)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->str.mmapedbuffer_w, newvalue->str.length_w);
+				break;
+			default:break;
+		}
+	}
+
+	return rval;
+}
+
+int procfuse_onFuseTruncatePOD(const struct procfuse *pf, const char *path, const off_t off, const void* appdata){
+	int rval = 0;
+	union procfuse_pod newvalue;
+	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
+	void *remapedbuffer = NULL;
+
+    if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_WRONLY)==O_WRONLY || (node->flags & O_TRUNC)==O_TRUNC)){
+    	return 0;
+    }
+
+	memset(&newvalue, '\0', sizeof(newvalue));
+	procfuse_loadPOD(&node->onpodevent, &newvalue);
+	if(node->onpodevent.type == T_PROC_POD_STRING){
+	    newvalue.str.mmapedbuffer_w = newvalue.str.mmapedbuffer_r;
+	    newvalue.str.length_w = off;
+	}
+
+
+	rval = procfuse_callPODModify(pf, path, node, &newvalue);
+	if(rval!=PROCFUSE_YES){
+		rval = -EIO;
+		return rval;
+	}
+
+	if(rval==PROCFUSE_YES){
+		memset(&newvalue, '\0', sizeof(newvalue));
+
+		switch(node->onpodevent.type){
+			case T_PROC_POD_CHAR:
+			case T_PROC_POD_INT:
+			case T_PROC_POD_INT64:
+			case T_PROC_POD_FLOAT:
+			case T_PROC_POD_DOUBLE:
+			case T_PROC_POD_LONGDOUBLE:
+				/* all bits zero is 0 and 0.0 for each of them */
+				procfuse_storePOD(&node->onpodevent, &newvalue);
+				break;
+			case T_PROC_POD_STRING:
+				procfuse_upgradeNodeReadLockToWriteLock(node);
+				if(node->onpodevent.value.str.mmapedbuffer_r!=NULL){
+					if(off<=node->onpodevent.value.str.length_r){
+						memset(node->onpodevent.value.str.mmapedbuffer_r + off, '\0', node->onpodevent.value.str.length_r-off);
+					}
+					else{
+						if(ftruncate(node->onpodevent.value.str.mmapedfd64_r, off)==-1){
+							rval = -errno;
+						}
+						else{
+						    node->onpodevent.value.str.length_r = off;
+						    remapedbuffer = mremap(node->onpodevent.value.str.mmapedbuffer_r, node->onpodevent.value.str.length_r, off, MREMAP_MAYMOVE);
+						    if(remapedbuffer==MAP_FAILED){
+							    rval = -errno;
+						    }
+						}
+					}
+				}
+				procfuse_downgradeNodeWriteLockToReadLock(node);
+				break;
+			default:break;
+		}
+	}
+
+	return rval;
+}
+int procfuse_onFuseReleasePOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata){
+	int rval = 0;
+	union procfuse_pod value;
+	struct procfuse_transactionnode *tnode = NULL;
+	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
+
+	(void)pf;
+	(void)path;
+
+	if((node->flags & O_ACCMODE) == O_RDONLY ||
+	   node->onpodevent.type==T_PROC_POD_STRING || node->onpodevent.type==T_PROC_POD_CHAR)
+		return rval;
+
+	procfuse_upgradeNodeReadLockToWriteLock(node);
+
+	if(node->transactions!=NULL)
+		tnode = (struct procfuse_transactionnode *)hash_table_lookup(node->transactions, &tid);
+	if(tnode!=NULL){
+		/* the text written through this file wins over writes of others in between, text which isn't a value
+		 * changes nothing
+		 */
+		if(tnode->haswritten &&
+		   procfuse_parsePOD(node->onpodevent.type, tnode->writebuffer, strnlen(tnode->writebuffer, tnode->length), &value, NULL)==0){
+			procfuse_storePOD(&node->onpodevent, &value);
+		}
+
+		hash_table_remove(node->transactions, &tid);
+	}
+
+	procfuse_downgradeNodeWriteLockToReadLock(node);
+
+    return rval;
+}
+
+/* accessor of array PODs, the caller holds the read lock of the node */
+int procfuse_onFuseReadPODArray(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	const struct procfuse_hashnode *node = (const struct procfuse_hashnode *)appdata;
+	struct procfuse_pod_array *array = node->onpodevent.value.array;
+	size_t index = 0, copied = 0, skip = 0, n = 0;
+
+	(void)pf;
+	(void)path;
+	(void)tid;
+
+	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_RDONLY)==O_RDONLY)){
+		return 0;
+	}
+	if(offset<0){
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&array->lock);
+
+	if((uint64_t)offset<procfuse_renderPODArray(array)){
+		for(index=procfuse_seekPODArray(array, offset);index<array->length && copied<size;++index){
+			skip = (size_t)((uint64_t)offset + copied - array->linestart[index]);
+			n = array->textlength[index] - skip;
+			if(n>size-copied){
+				n = size-copied;
+			}
+			memcpy(buffer+copied, array->text+index*PROCFUSE_ARRAYLINELEN+skip, n);
+			copied += n;
+		}
+	}
+
+	pthread_mutex_unlock(&array->lock);
+
+	return (int)copied;
+}
+/* every line written sets one element, starting with the one whose line starts at offset
+ * a write has to start at the beginning of a line, the kernel splits only writes larger than max_write
+ */
+int procfuse_onFuseWritePODArray(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	const struct procfuse_hashnode *node = (const struct procfuse_hashnode *)appdata;
+	struct procfuse_pod_array *array = node->onpodevent.value.array;
+	union procfuse_pod value;
+	const char *p = buffer, *last = buffer+size, *newline = NULL;
+	size_t index = 0;
+	int rval = 0;
+
+	(void)pf;
+	(void)path;
+	(void)tid;
+
+	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_WRONLY)==O_WRONLY)){
+		return 0;
+	}
+	if(size==0){
+		return 0;
+	}
+	if(offset<0){
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&array->lock);
+	if((uint64_t)offset>=procfuse_renderPODArray(array)){
+		rval = -EFBIG;
+	}
+	else{
+		index = procfuse_seekPODArray(array, offset);
+		if(array->linestart[index]!=(uint64_t)offset){
+			rval = -EINVAL;
+		}
+	}
+	pthread_mutex_unlock(&array->lock);
+
+	while(rval==0 && p<last){
+		newline = (const char*)memchr(p, '\n', last-p);
+		if(newline==NULL){
+			newline = last;
+		}
+		if(index>=array->length){
+			rval = -EFBIG;
+		}
+		else{
+			rval = -procfuse_parsePOD(array->type, p, newline-p, &value, NULL);
+		}
+		if(rval==0){
+			procfuse_storeArrayElement(array, index++, &value);
+			p = (newline<last) ? newline+1 : last;
+		}
+	}
+
+	/* the lines stored before a bad one count as written */
+	return (p>buffer) ? (int)(p-buffer) : rval;
+}
+
+/* accessor of record PODs, the caller holds the read lock of the node */
+int procfuse_onFuseReadPODRecord(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	const struct procfuse_hashnode *node = (const struct procfuse_hashnode *)appdata;
+	struct procfuse_pod_record *record = node->onpodevent.value.record;
+	size_t length = 0;
+	int rval = 0;
+
+	(void)pf;
+	(void)path;
+	(void)tid;
+
+	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_RDONLY)==O_RDONLY)){
+		return 0;
+	}
+	if(offset<0){
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&record->lock);
+	length = procfuse_renderPODRecord(record);
+	if((uint64_t)offset<length){
+		rval = (int)((length-offset<size) ? length-offset : size);
+		memcpy(buffer, record->text+offset, rval);
+	}
+	pthread_mutex_unlock(&record->lock);
+
+	return rval;
+}
+/* every line written is "name=value", the fields are only changed if all lines are valid */
+int procfuse_onFuseWritePODRecord(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	const struct procfuse_hashnode *node = (const struct procfuse_hashnode *)appdata;
+	struct procfuse_pod_record *record = node->onpodevent.value.record;
+	union procfuse_pod value;
+	const char *p = NULL, *last = buffer+size, *newline = NULL;
+	size_t index = 0;
+	int rval = 0, pass = 0;
+
+	(void)pf;
+	(void)path;
+	(void)tid;
+
+	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_WRONLY)==O_WRONLY)){
+		return 0;
+	}
+	if(size==0){
+		return 0;
+	}
+	/* a line split across writes can't be checked before any field changes */
+	if(offset!=0){
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&record->lock);
+	/* the first pass checks every line, the second one stores them */
+	for(pass=0;pass<2 && rval==0;++pass){
+		for(p=buffer;p<last && rval==0;p=newline+1){
+			newline = (const char*)memchr(p, '\n', last-p);
+			if(newline==NULL){
+				newline = last;
+			}
+			if(newline==p){
+				continue;
+			}
+			rval = procfuse_parseFieldLine(record, p, newline-p, &index, &value);
+			if(rval==0 && pass==1){
+				memcpy((char*)record->data+record->fields[index].offset, &value,
+				       procfuse_fieldSize(procfuse_fieldType(record->fields[index].type)));
+			}
+		}
+	}
+	pthread_mutex_unlock(&record->lock);
+
+	return (rval==0) ? (int)size : -rval;
+}
+
+/* accessor of the binary view of a directory, see procfuse_setBinaryView() */
+int procfuse_onFuseReadBinaryView(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	(void)pf;
+	(void)path;
+	(void)buffer;
+	(void)size;
+	(void)offset;
+	(void)tid;
+	(void)appdata;
+
+	/* every open file of a binary view reads its snapshot, see procfuse_renderBinarySnapshot() */
+	return -EIO;
+}
+
+/* accessor of the nodes created by procfuse_createBacked(), used whenever the data isn't spliced */
+int procfuse_onFuseReadBacked(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	ssize_t rval = 0;
+	const struct procfuse_hashnode *node = (const struct procfuse_hashnode *)appdata;
+
+	(void)pf;
+	(void)path;
+	(void)tid;
+
+	rval = pread(node->backingfd, buffer, size, offset);
+	return (rval<0) ? -errno : (int)rval;
+}
+int procfuse_onFuseWriteBacked(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
+	ssize_t rval = 0;
+	const struct procfuse_hashnode *node = (const struct procfuse_hashnode *)appdata;
+
+	(void)pf;
+	(void)path;
+	(void)tid;
+
+	rval = pwrite(node->backingfd, buffer, size, offset);
+	return (rval<0) ? -errno : (int)rval;
+}
+int procfuse_onFuseTruncateBacked(const struct procfuse *pf, const char *path, const off_t off, const void* appdata){
+	const struct procfuse_hashnode *node = (const struct procfuse_hashnode *)appdata;
+
+	(void)pf;
+	(void)path;
+
+	return (ftruncate(node->backingfd, off)==-1) ? -errno : 0;
+}
+
+/* FUSE functions */
+
+/* the extended attribute PROCFUSE_BINARY_XATTR of node, its length if size is 0 - the caller holds pf->lock */
+int procfuse_nodeGetxattr(struct procfuse_hashnode *node, const char *name, char *value, size_t size){
+	struct procfuse_binarylayout layout;
+
+	if(strcmp(name, PROCFUSE_BINARY_XATTR)!=0 || !procfuse_hasBinary(node)){
+		return -ENODATA;
+	}
+
+	memset(&layout, 0, sizeof(layout));
+	procfuse_appendBinary(node, NULL, &layout);
+	if(size==0){
+		return (int)layout.valueslength;
+	}
+	if(size<layout.valueslength){
+		return -ERANGE;
+	}
+
+	memset(&layout, 0, sizeof(layout));
+	layout.values = value;
+	procfuse_appendBinary(node, NULL, &layout);
+
+	return (int)layout.valueslength;
+}
+int procfuse_nodeListxattr(const struct procfuse_hashnode *node, char *list, size_t size){
+	if(!procfuse_hasBinary(node)){
+		return 0;
+	}
+	if(size==0){
+		return sizeof(PROCFUSE_BINARY_XATTR);
+	}
+	if(size<sizeof(PROCFUSE_BINARY_XATTR)){
+		return -ERANGE;
+	}
+	memcpy(list, PROCFUSE_BINARY_XATTR, sizeof(PROCFUSE_BINARY_XATTR));
+	return sizeof(PROCFUSE_BINARY_XATTR);
+}
+
+/* PROCFUSE_YES if procfuse_nodeSize() knows the size of node */
+int procfuse_hasNodeSize(const struct procfuse_hashnode *node){
+	/* a binary view changes with the files of its directory, nothing drops it from the page cache */
+	if(node->onpodevent.type==T_PROC_POD_BINARY){
+		return PROCFUSE_NO;
+	}
+	return (node->onpodevent.type!=T_PROC_POD_NO || node->backed==PROCFUSE_YES || node->onevent.onFuseSize!=NULL) ?
+	        PROCFUSE_YES : PROCFUSE_NO;
+}
+/* PROCFUSE_YES if the accessor of node is implemented by procfuse, it gets the node instead of pf->appdata then */
+int procfuse_hasInternalAccessor(const struct procfuse_hashnode *node){
+	return (node->onpodevent.type!=T_PROC_POD_NO || node->backed==PROCFUSE_YES) ? PROCFUSE_YES : PROCFUSE_NO;
+}
+/* the number of bytes reading a file returns, 0 if unknown or reported by the application, see procfuse_pinAppSize()
+ * the rendered length of a numeric POD is cached until the next change of the node
+ * the caller holds pf->lock or the node lock, a binary view needs pf->lock to measure its directory
+ */
+off_t procfuse_nodeSize(const struct procfuse_hashnode *node){
+	const struct procfuse_dirindex *index = NULL;
+	char podtmp[8192];
+	union procfuse_pod value;
+	struct stat st;
+	uint64_t rendered = 0, tag = 0;
+	off_t size = 0;
+
+	switch(node->onpodevent.type){
+		case T_PROC_POD_NO:
+			if(node->backed==PROCFUSE_YES && fstat(node->backingfd, &st)==0){
+				return st.st_size;
+			}
+			return 0;
+		case T_PROC_POD_STRING:
+			return (off_t)__atomic_load_n(&node->onpodevent.value.str.length_r, __ATOMIC_RELAXED);
+		case T_PROC_POD_ARRAY:
+			pthread_mutex_lock(&node->onpodevent.value.array->lock);
+			size = (off_t)procfuse_renderPODArray(node->onpodevent.value.array);
+			pthread_mutex_unlock(&node->onpodevent.value.array->lock);
+			return size;
+		case T_PROC_POD_RECORD:
+			pthread_mutex_lock(&node->onpodevent.value.record->lock);
+			size = (off_t)procfuse_renderPODRecord(node->onpodevent.value.record);
+			pthread_mutex_unlock(&node->onpodevent.value.record->lock);
+			return size;
+		case T_PROC_POD_BINARY:
+			index = procfuse_binaryViewIndex(node->pf, node);
+			return (index!=NULL) ? (off_t)procfuse_renderBinaryView(index, NULL) : 0;
+		default:
+			/* the generation is loaded before the value, a change in between leaves a stale tag behind */
+			tag = (uint64_t)(__atomic_load_n(&node->generation, __ATOMIC_ACQUIRE)+1) << 32;
+			rendered = __atomic_load_n(&node->renderedsize, __ATOMIC_ACQUIRE);
+			if((rendered & 0xffffffff00000000ULL)==tag){
+				return (off_t)(rendered & 0xffffffffULL);
+			}
+			procfuse_loadPOD((struct procfuse_pod_accessor *)&node->onpodevent, &value);
+			size = procfuse_renderPOD(node->onpodevent.type, &value, podtmp, sizeof(podtmp)-1);
+			__atomic_store_n(&((struct procfuse_hashnode *)node)->renderedsize, tag | (uint64_t)size, __ATOMIC_RELEASE);
+			return size;
+	}
+}
+
+/* pins node if the application reports its size, NULL otherwise
+ * the caller holds pf->lock and calls procfuse_fillAppSize() after releasing it, so onFuseSize may call procfuse
+ * functions, the pin keeps the accessor from being replaced meanwhile
+ */
+struct procfuse_hashnode* procfuse_pinAppSize(struct procfuse_hashnode *node){
+	if(node==NULL || node->onpodevent.type!=T_PROC_POD_NO || node->backed==PROCFUSE_YES || node->onevent.onFuseSize==NULL){
+		return NULL;
+	}
+	__atomic_add_fetch(&node->pinstate, 1, __ATOMIC_ACQUIRE);
+	return node;
+}
+/* asks the application for the size of node pinned by procfuse_pinAppSize() and drops the pin, no lock may be held */
+void procfuse_fillAppSize(struct procfuse *pf, struct procfuse_hashnode *node, struct stat *stbuf){
+	off_t size = 0;
+
+	if(node==NULL){
+		return;
+	}
+	size = node->onevent.onFuseSize(pf, node->absolutepath, pf->appdata);
+	stbuf->st_size = (size>0) ? size : 0;
+	procfuse_unpinNode(pf, node);
+}
+
+/* fills the attributes a directory entry carries, the inode number and the file type
+ * libfuse 2 drops everything else of the attributes passed along with an entry
+ */
+void procfuse_fillDirentStat(const struct procfuse_hashnode *node, struct stat *stbuf){
+	stbuf->st_ino = node->ino;
+	stbuf->st_mode = (node->subdirs!=NULL) ? S_IFDIR : S_IFREG;
+}
+/* fills stbuf with the attributes of node, node==NULL stands for the root directory */
+void procfuse_fillStat(const struct procfuse_hashnode *node, struct stat *stbuf){
+	memset(stbuf, 0, sizeof(struct stat));
+	if(node==NULL){
+		stbuf->st_ino = FUSE_ROOT_ID;
+		stbuf->st_mode = S_IFDIR | (S_IRWXU | S_IRWXG | S_IRWXO);
+		stbuf->st_nlink = 2;
+		return;
+	}
+	procfuse_nodeFetched(node);
+
+	stbuf->st_ino = node->ino;
+	stbuf->st_gid = node->gid;
+	stbuf->st_uid = node->uid;
+	stbuf->st_atime = node->access.tv_sec;
+	stbuf->st_mtime = node->modify.tv_sec;
+
+	if(node->subdirs==NULL){
+		stbuf->st_mode = S_IFREG;
+		if(node->onevent.onFuseRead){
+		    stbuf->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
+		}
+		if(node->onevent.onFuseWrite){
+			stbuf->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
+		}
+
+		stbuf->st_nlink = 1;
+		/* lets readers size their reads from stat, see procfuse_nodeSize() */
+		stbuf->st_size = procfuse_nodeSize(node);
+	}
+	else{
+		stbuf->st_mode = S_IFDIR | (S_IRWXU | S_IRWXG | S_IRWXO);
+
+		stbuf->st_nlink = 2;
+	}
+}
+
+/* the procfuse_node* functions implement the file operations on an already acquired node
+ * they are shared by the path based (procfuse_FUSE*) and the inode based (procfuse_LL*) backend
+ */
+int procfuse_nodeOpen(struct procfuse *pf, struct procfuse_hashnode *node, const char *path, int flags, int64_t tid){
+	int rval = 0;
+
+	if(node==NULL || node->subdirs!=NULL || procfuse_isPendingForUnlink(node)){
+		rval = -ENOENT;
+	}
+	else if(!node->onevent.onFuseRead && ((flags & O_RDONLY) || (flags & O_RDWR))){
+		rval = -EACCES;
+	}
+	else if(!node->onevent.onFuseWrite && ((flags & O_WRONLY) || (flags & O_RDWR))){
+		rval = -EACCES;
+	}
+	else{
+		if(node->onevent.onFuseOpen){
+			const void *appdata = pf->appdata;
+			if(procfuse_hasInternalAccessor(node))
+				appdata = (const void*)node;
+			node->onevent.onFuseOpen(pf, path, tid, appdata);
+		}
+
 	}
 
 	return rval;
 }
+/* the caller holds the node lock and passes *pollers to procfuse_notifyPollers() after releasing it */
+int procfuse_nodeTruncate(struct procfuse *pf, struct procfuse_hashnode *node, const char *path, off_t off,
+                          struct fuse_pollhandle ***pollers){
+	if(node!=NULL && node->subdirs==NULL && node->onevent.onFuseTruncate!=NULL){
+		const void *appdata = pf->appdata;
+		if(procfuse_hasInternalAccessor(node))
+			appdata = (const void*)node;
+		node->onevent.onFuseTruncate(pf, path, off, appdata);
+		*pollers = procfuse_changeNode(pf, node);
+	}
 
-int procfuse_readPOD(struct procfuse *pf, const char *absolutepath, procfuse_pod_t pod_type, void *buffer){
+	return 0;
+}
+int procfuse_nodeRead(struct procfuse *pf, struct procfuse_hashnode *node, const char *path, char *buf, size_t size, off_t offset,
+                      int64_t tid){
 	int rval = 0;
-	struct procfuse_hashnode *node = NULL;
 
-	if(pf==NULL || absolutepath==NULL || buffer==NULL){
-		errno = EINVAL;
-		return 0;
+	if(node==NULL || node->subdirs!=NULL){
+		rval = -ENOENT;
 	}
-
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
-	if(node!=NULL){
-	    rval = procfuse_copyPOD(pod_type, (union procfuse_pod *)buffer, node->onpodevent.type, &node->onpodevent.value);
+	else if(!node->onevent.onFuseRead){
+		rval = -EBADF;
+	}
+	else{
+		if(node->onevent.onFuseRead!=NULL){
+			const void *appdata = pf->appdata;
+			if(procfuse_hasInternalAccessor(node))
+				appdata = (const void*)node;
+			rval = node->onevent.onFuseRead(pf, path, buf, size, offset, tid, appdata);
+		}
 	}
-	procfuse_releaseAccessToNode(pf, node);
 
 	return rval;
 }
-
-int procfuse_readPOD_c(struct procfuse *pf, const char *absolutepath, char *value){
+int procfuse_nodeWrite(struct procfuse *pf, struct procfuse_hashnode *node, const char *path, const char *buf, size_t size,
+                       off_t offset, int64_t tid){
 	int rval = 0;
-	union procfuse_pod buffer;
+	const void *appdata = NULL;
 
-	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_CHAR, &buffer);
-	if(rval!=0){
-		*value = buffer.c;
+	if(node==NULL || node->subdirs!=NULL){
+		rval = -ENOENT;
+	}
+	else if(!node->onevent.onFuseWrite){
+		rval = -EBADF;
+	}
+	else{
+		if(node->onevent.onFuseWrite){
+			appdata = pf->appdata;
+			if(procfuse_hasInternalAccessor(node)){
+				appdata = (void*)node;
+			}
+			rval = node->onevent.onFuseWrite(pf, path, buf, size, offset, tid, appdata);
+
+			if(rval==0){
+				rval = -EIO;
+			}
+		}
 	}
+
 	return rval;
 }
-int procfuse_readPOD_i(struct procfuse *pf, const char *absolutepath, int *value){
-	int rval = 0;
-	union procfuse_pod buffer;
+int procfuse_nodeRelease(struct procfuse *pf, struct procfuse_hashnode *node, const char *path, int64_t tid){
+	if(node!=NULL && node->subdirs==NULL){
+		if(node->onevent.onFuseRelease){
+			const void *appdata = pf->appdata;
+			if(procfuse_hasInternalAccessor(node))
+				appdata = (const void*)node;
+			node->onevent.onFuseRelease(pf, path, tid, appdata);
+		}
+	}
 
-	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT, &buffer);
-	if(rval!=0){
-		*value = buffer.i;
+	return 0;
+}
+
+/* string PODs and backed nodes are read and written as buffers referring to their backing file instead of memory,
+ * so libfuse can splice the data between it and the fuse device without copying it through user space
+ * both return -ENOTSUP for every other node, the caller falls back to procfuse_nodeRead/procfuse_nodeWrite then
+ * the caller holds the read lock of the node
+ */
+int procfuse_nodeReadBuf(struct procfuse_hashnode *node, struct fuse_bufvec *bufv, size_t size, off_t offset){
+	int fd = -1;
+	off_t length = 0;
+
+	if(node==NULL || (fd = procfuse_nodeBackingFd(node))<0){
+		return -ENOTSUP;
 	}
-	return rval;
+	length = procfuse_nodeSize(node);
+
+	*bufv = FUSE_BUFVEC_INIT(0);
+	if(length==0 || offset>length){
+		return 0;
+	}
+	if(size>(size_t)(length-offset)){
+		size = length-offset;
+	}
+
+	bufv->buf[0].size = size;
+	bufv->buf[0].flags = (enum fuse_buf_flags)(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+	bufv->buf[0].fd = fd;
+	bufv->buf[0].pos = offset;
+
+	return (int)size;
 }
-int procfuse_readPOD_i64(struct procfuse *pf, const char *absolutepath, int64_t *value){
-	int rval = 0;
-	union procfuse_pod buffer;
+int procfuse_nodeWriteBuf(struct procfuse_hashnode *node, struct fuse_bufvec *bufv, off_t offset){
+	int fd = -1;
+	off_t length = 0;
+	struct fuse_bufvec dst = FUSE_BUFVEC_INIT(0);
+	size_t size = 0;
+	ssize_t written = 0;
 
-	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT64, &buffer);
-	if(rval!=0){
-		*value = buffer.l;
+	if(node==NULL || (fd = procfuse_nodeBackingFd(node))<0){
+		return -ENOTSUP;
 	}
-	return rval;
+
+	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_WRONLY)==O_WRONLY)){
+		return -EIO;
+	}
+
+	procfuse_upgradeNodeReadLockToWriteLock(node);
+	size = fuse_buf_size(bufv);
+	/* string PODs have a fixed capacity, backed files grow */
+	length = (node->onpodevent.type==T_PROC_POD_STRING) ? node->onpodevent.value.str.length_r : offset+(off_t)size;
+	if(length==0){
+		written = -EIO;
+	}
+	else if(offset>length){
+		written = -EFBIG;
+	}
+	else{
+		if(size>(size_t)(length-offset)){
+			size = length-offset;
+		}
+		dst.buf[0].size = size;
+		dst.buf[0].flags = (enum fuse_buf_flags)(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+		dst.buf[0].fd = fd;
+		dst.buf[0].pos = offset;
+
+		/* a string POD file is mapped shared into mmapedbuffer_r, so the written data is visible there too */
+		written = (size>0) ? fuse_buf_copy(&dst, bufv, (enum fuse_buf_copy_flags)0) : 0;
+		if(written<0){
+			written = -EIO;
+		}
+	}
+	procfuse_downgradeNodeWriteLockToReadLock(node);
+
+	/* like procfuse_nodeWrite, writing nothing is an error */
+	return (written==0) ? -EIO : (int)written;
 }
-int procfuse_readPOD_f(struct procfuse *pf, const char *absolutepath, float *value){
-	int rval = 0;
-	union procfuse_pod buffer;
 
-	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_FLOAT, &buffer);
-	if(rval!=0){
-		*value = buffer.f;
+/* grows the snapshot buffer of handle to at least size bytes, keeping its content */
+int procfuse_reserveSnapshot(struct procfuse *pf, struct procfuse_filehandle *handle, size_t size){
+	size_t newsize = 0;
+	char *newbuffer = NULL;
+
+	if(handle->snapshot==NULL){
+		handle->snapshot = (char*)slab_alloc(pf->writebufferslab);
+		if(handle->snapshot==NULL){
+			return -ENOMEM;
+		}
+		handle->snapshotsize = PROCFUSE_WRITEBUFFERLEN;
 	}
-	return rval;
+	if(size<=handle->snapshotsize){
+		return 0;
+	}
+
+	for(newsize=handle->snapshotsize*2;newsize<size;newsize*=2);
+	if(handle->snapshotsize==PROCFUSE_WRITEBUFFERLEN){
+		newbuffer = (char*)malloc(newsize);
+		if(newbuffer!=NULL){
+			memcpy(newbuffer, handle->snapshot, handle->snapshotsize);
+			slab_release(pf->writebufferslab, handle->snapshot);
+		}
+	}
+	else{
+		newbuffer = (char*)realloc(handle->snapshot, newsize);
+	}
+	if(newbuffer==NULL){
+		return -ENOMEM;
+	}
+	handle->snapshot = newbuffer;
+	handle->snapshotsize = newsize;
+
+	return 0;
 }
-int procfuse_readPOD_d(struct procfuse *pf, const char *absolutepath, double *value){
+/* reads the whole content of the node of handle into its snapshot buffer, the content ends where onFuseRead returns 0
+ * the caller holds the read lock of the node and, once the handle is shared, handle->snapshotlock
+ */
+int procfuse_renderSnapshot(struct procfuse *pf, struct procfuse_filehandle *handle){
 	int rval = 0;
-	union procfuse_pod buffer;
+	size_t length = 0;
+	unsigned int generation = __atomic_load_n(&handle->node->generation, __ATOMIC_ACQUIRE);
 
-	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_DOUBLE, &buffer);
-	if(rval!=0){
-		*value = buffer.d;
+	rval = procfuse_reserveSnapshot(pf, handle, 0);
+	if(rval<0){
+		return rval;
 	}
-	return rval;
+	handle->snapshotlength = 0;
+
+	for(;;){
+		rval = procfuse_reserveSnapshot(pf, handle, length+1);
+		if(rval<0){
+			return rval;
+		}
+
+		rval = procfuse_nodeRead(pf, handle->node, handle->node->absolutepath, handle->snapshot+length,
+		                         handle->snapshotsize-length, length, handle->tid);
+		if(rval<0){
+			return rval;
+		}
+		if(rval==0){
+			break;
+		}
+		length += rval;
+	}
+
+	handle->snapshotlength = length;
+	handle->snapshotgeneration = generation;
+
+	return 0;
 }
-int procfuse_readPOD_ld(struct procfuse *pf, const char *absolutepath, long double *value){
+/* renders the binary view of handle into its snapshot buffer in one pass over the files of its directory
+ * the caller holds neither pf->lock nor a node lock, once the handle is shared it holds handle->snapshotlock
+ */
+int procfuse_renderBinarySnapshot(struct procfuse *pf, struct procfuse_filehandle *handle){
 	int rval = 0;
-	union procfuse_pod buffer;
+	const struct procfuse_dirindex *index = NULL;
+	unsigned int generation = __atomic_load_n(&handle->node->generation, __ATOMIC_ACQUIRE);
 
-	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_LONGDOUBLE, &buffer);
-	if(rval!=0){
-		*value = buffer.ld;
+	/* the files of the directory are only iterated, like procfuse_FUSEreaddir() does */
+	pthread_rwlock_rdlock(&pf->lock);
+	index = procfuse_binaryViewIndex(pf, handle->node);
+	if(index==NULL){
+		rval = -ENOENT;
+	}
+	else{
+		rval = procfuse_reserveSnapshot(pf, handle, procfuse_renderBinaryView(index, NULL));
+		if(rval==0){
+			handle->snapshotlength = procfuse_renderBinaryView(index, handle->snapshot);
+			handle->snapshotgeneration = generation;
+		}
 	}
+	pthread_rwlock_unlock(&pf->lock);
+
 	return rval;
 }
-int procfuse_readPOD_s(struct procfuse *pf, const char *absolutepath, char *value, int64_t *length){
+void procfuse_releaseSnapshot(struct procfuse *pf, struct procfuse_filehandle *handle){
+	if(handle->snapshot==NULL){
+		return;
+	}
+	if(handle->snapshotsize==PROCFUSE_WRITEBUFFERLEN){
+		slab_release(pf->writebufferslab, handle->snapshot);
+	}
+	else{
+		free(handle->snapshot);
+	}
+	handle->snapshot = NULL;
+}
+/* points data to at most size bytes of the snapshot of handle at offset and returns their number
+ * reading from the beginning renders the snapshot again if the node changed since it was rendered
+ * the caller holds handle->snapshotlock
+ */
+int procfuse_snapshotRange(struct procfuse *pf, struct procfuse_filehandle *handle, size_t size, off_t offset, const char **data){
 	int rval = 0;
-	union procfuse_pod buffer;
 
-	buffer.str.length_w = *length;
-	buffer.str.mmapedbuffer_w = value;
+	if(offset==0 && __atomic_load_n(&handle->node->generation, __ATOMIC_ACQUIRE)!=handle->snapshotgeneration){
+		if(handle->node->onpodevent.type==T_PROC_POD_BINARY){
+			rval = procfuse_renderBinarySnapshot(pf, handle);
+		}
+		else{
+			pthread_rwlock_rdlock(&handle->node->lock);
+			rval = procfuse_renderSnapshot(pf, handle);
+			pthread_rwlock_unlock(&handle->node->lock);
+		}
+		if(rval<0){
+			return rval;
+		}
+	}
+	if(offset==0){
+		__atomic_store_n(&handle->seen, handle->snapshotgeneration, __ATOMIC_RELAXED);
+	}
 
-	rval = procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT64, &buffer);
-	return rval;
+	*data = handle->snapshot;
+	if(offset<0 || (size_t)offset>=handle->snapshotlength){
+		return 0;
+	}
+	*data = handle->snapshot + offset;
+	if(size>handle->snapshotlength-offset){
+		size = handle->snapshotlength-offset;
+	}
+
+	return (int)size;
 }
 
-int procfuse_writePOD(struct procfuse *pf, const char *absolutepath, procfuse_pod_t pod_type, void *buffer){
+/* opens the node acquired by procfuse_acquireAccessTo(I)Node for fi
+ * on success the access is handed over to the file handle stored in fi->fh instead of being released,
+ * so read, write and release neither have to search the node again nor take pf->lock
+ * on failure the access is released
+ */
+int procfuse_openFileHandle(struct procfuse *pf, struct procfuse_hashnode *node, struct fuse_file_info *fi){
 	int rval = 0;
-	struct procfuse_hashnode *node = NULL;
+	struct procfuse_filehandle *handle = NULL;
 
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
+	if(node==NULL){
+		return -ENOENT;
 	}
 
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
-	if(node!=NULL){
-		rval = procfuse_copyPOD(node->onpodevent.type, &node->onpodevent.value, pod_type, (union procfuse_pod *)buffer);
+	handle = (struct procfuse_filehandle *)calloc(1, sizeof(struct procfuse_filehandle));
+	if(handle==NULL){
+		procfuse_releaseAccessToNode(pf, node);
+		return -ENOMEM;
 	}
-	procfuse_releaseAccessToNode(pf, node);
+	handle->node = node;
+	handle->tid = __sync_add_and_fetch(&pf->tidcounter, 1);
+	procfuse_nodeFetched(node);
+	handle->seen = __atomic_load_n(&node->generation, __ATOMIC_ACQUIRE);
+
+	rval = procfuse_nodeOpen(pf, node, node->absolutepath, fi->flags, handle->tid);
+	if(rval<0){
+		free(handle);
+		procfuse_releaseAccessToNode(pf, node);
+		return rval;
+	}
+
+	if(node->onpodevent.type==T_PROC_POD_BINARY){
+		/* pf->lock isn't taken with a node lock held, the pin keeps the node meanwhile */
+		pthread_rwlock_unlock(&node->lock);
+		rval = procfuse_renderBinarySnapshot(pf, handle);
+		pthread_rwlock_rdlock(&node->lock);
+	}
+	else if(node->snapshot==PROCFUSE_YES && (fi->flags & O_ACCMODE)==O_RDONLY && procfuse_nodeBackingFd(node)<0){
+		/* the read lock of the node is still held */
+		rval = procfuse_renderSnapshot(pf, handle);
+	}
+	if(rval<0){
+		procfuse_releaseSnapshot(pf, handle);
+		procfuse_nodeRelease(pf, node, node->absolutepath, handle->tid);
+		free(handle);
+		procfuse_releaseAccessToNode(pf, node);
+		return rval;
+	}
+	if(handle->snapshot!=NULL){
+		pthread_mutex_init(&handle->snapshotlock, NULL);
+		handle->seen = handle->snapshotgeneration;
+	}
+
+	fi->fh = (uint64_t)(uintptr_t)handle;
+
+	/* only the read lock is released, the access counter stays incremented */
+	pthread_rwlock_unlock(&node->lock);
 
 	return rval;
 }
+struct procfuse_filehandle* procfuse_fileHandle(struct fuse_file_info *fi){
+	if(fi==NULL || fi->fh==0){
+		return NULL;
+	}
+	return (struct procfuse_filehandle *)(uintptr_t)fi->fh;
+}
+/* reading a file from its beginning takes the current content as seen, polling it blocks until the next change */
+void procfuse_markSeen(struct procfuse_filehandle *handle){
+	__atomic_store_n(&handle->seen, __atomic_load_n(&handle->node->generation, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+}
+/* returns the poll events of the open file fi, POLLIN if the node changed since it was last read from the beginning
+ * ph - if not NULL - is notified by the next change of the node, it replaces the one of an earlier poll
+ */
+unsigned int procfuse_pollFileHandle(struct procfuse *pf, struct fuse_file_info *fi, struct fuse_pollhandle *ph){
+	unsigned int revents = 0;
+	struct procfuse_filehandle *handle = procfuse_fileHandle(fi);
 
+	if(handle==NULL){
+		if(ph!=NULL){
+			fuse_pollhandle_destroy(ph);
+		}
+		return POLLERR;
+	}
 
-int procfuse_writePOD_c(struct procfuse *pf, const char *absolutepath, char value){
-	union procfuse_pod buffer;
+	if((fi->flags & O_ACCMODE)!=O_RDONLY){
+		revents |= POLLOUT | POLLWRNORM;
+	}
 
-	buffer.c = value;
-	return procfuse_readPOD(pf, absolutepath, T_PROC_POD_CHAR, &buffer);
-}
-int procfuse_writePOD_i(struct procfuse *pf, const char *absolutepath, int value){
-	union procfuse_pod buffer;
+	/* procfuse_changeNode() increments the generation before taking the lock, so a change is either seen here or notified */
+	pthread_mutex_lock(&pf->polllock);
+	if(ph!=NULL){
+		if(handle->ph!=NULL){
+			fuse_pollhandle_destroy(handle->ph);
+		}
+		else{
+			handle->nextpoller = handle->node->pollers;
+			__atomic_store_n(&handle->node->pollers, handle, __ATOMIC_RELEASE);
+		}
+		handle->ph = ph;
+	}
+	if(__atomic_load_n(&handle->node->generation, __ATOMIC_ACQUIRE)!=__atomic_load_n(&handle->seen, __ATOMIC_RELAXED)){
+		revents |= POLLIN | POLLRDNORM;
+	}
+	pthread_mutex_unlock(&pf->polllock);
 
-	buffer.i = value;
-	return procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT, &buffer);
+	return revents;
 }
-int procfuse_writePOD_i64(struct procfuse *pf, const char *absolutepath, int64_t value){
-	union procfuse_pod buffer;
-
-	buffer.ld = value;
-	return procfuse_readPOD(pf, absolutepath, T_PROC_POD_INT64, &buffer);
+void procfuse_unpollFileHandle(struct procfuse *pf, struct procfuse_filehandle *handle){
+	struct procfuse_filehandle **link = NULL;
+
+	pthread_mutex_lock(&pf->polllock);
+	if(handle->ph!=NULL){
+		for(link=&handle->node->pollers;*link!=NULL;link=&(*link)->nextpoller){
+			if(*link==handle){
+				__atomic_store_n(link, handle->nextpoller, __ATOMIC_RELEASE);
+				break;
+			}
+		}
+		fuse_pollhandle_destroy(handle->ph);
+		handle->ph = NULL;
+		handle->nextpoller = NULL;
+	}
+	pthread_mutex_unlock(&pf->polllock);
 }
-int procfuse_writePOD_f(struct procfuse *pf, const char *absolutepath, float value){
-	union procfuse_pod buffer;
+int procfuse_closeFileHandle(struct procfuse *pf, struct fuse_file_info *fi){
+	struct procfuse_filehandle *handle = procfuse_fileHandle(fi);
+	struct fuse_pollhandle **pollers = NULL;
 
-	buffer.f = value;
-	return procfuse_readPOD(pf, absolutepath, T_PROC_POD_FLOAT, &buffer);
+	if(handle==NULL){
+		return -EBADF;
+	}
+
+	if(handle->ph!=NULL){
+		procfuse_unpollFileHandle(pf, handle);
+	}
+
+	pthread_rwlock_rdlock(&handle->node->lock);
+	procfuse_nodeRelease(pf, handle->node, handle->node->absolutepath, handle->tid);
+	/* the release commits the write transaction */
+	if((fi->flags & O_ACCMODE)!=O_RDONLY){
+		pollers = procfuse_changeNode(pf, handle->node);
+	}
+	procfuse_releaseAccessToNode(pf, handle->node);
+
+	procfuse_notifyPollers(pollers);
+
+	if(handle->snapshot!=NULL){
+		procfuse_releaseSnapshot(pf, handle);
+		pthread_mutex_destroy(&handle->snapshotlock);
+	}
+	fi->fh = 0;
+	free(handle);
+
+	return 0;
 }
-int procfuse_writePOD_d(struct procfuse *pf, const char *absolutepath, double value){
-	union procfuse_pod buffer;
+int procfuse_readFileHandle(struct procfuse *pf, struct fuse_file_info *fi, char *buf, size_t size, off_t offset){
+	int rval = 0;
+	struct procfuse_filehandle *handle = procfuse_fileHandle(fi);
 
-	buffer.d = value;
-	return procfuse_readPOD(pf, absolutepath, T_PROC_POD_DOUBLE, &buffer);
+	const char *data = NULL;
+
+	if(handle==NULL){
+		return -EBADF;
+	}
+
+	if(handle->snapshot!=NULL){
+		pthread_mutex_lock(&handle->snapshotlock);
+		rval = procfuse_snapshotRange(pf, handle, size, offset, &data);
+		if(rval>0){
+			memcpy(buf, data, rval);
+		}
+		pthread_mutex_unlock(&handle->snapshotlock);
+		return rval;
+	}
+
+	if(offset==0){
+		procfuse_markSeen(handle);
+	}
+	pthread_rwlock_rdlock(&handle->node->lock);
+	rval = procfuse_nodeRead(pf, handle->node, handle->node->absolutepath, buf, size, offset, handle->tid);
+	pthread_rwlock_unlock(&handle->node->lock);
+
+	return rval;
 }
-int procfuse_writePOD_ld(struct procfuse *pf, const char *absolutepath, long double value){
-	union procfuse_pod buffer;
+int procfuse_writeFileHandle(struct procfuse *pf, struct fuse_file_info *fi, const char *buf, size_t size, off_t offset){
+	int rval = 0;
+	struct procfuse_filehandle *handle = procfuse_fileHandle(fi);
+
+	if(handle==NULL){
+		return -EBADF;
+	}
+
+	pthread_rwlock_rdlock(&handle->node->lock);
+	rval = procfuse_nodeWrite(pf, handle->node, handle->node->absolutepath, buf, size, offset, handle->tid);
+	pthread_rwlock_unlock(&handle->node->lock);
 
-	buffer.ld = value;
-	return procfuse_readPOD(pf, absolutepath, T_PROC_POD_LONGDOUBLE, &buffer);
+	return rval;
 }
-int procfuse_writePOD_s(struct procfuse *pf, const char *absolutepath, char *value, int64_t length){
-	union procfuse_pod buffer;
 
-	buffer.str.length_w = length;
-	buffer.str.mmapedbuffer_w = value;
-	return procfuse_readPOD(pf, absolutepath, T_PROC_POD_STRING, &buffer);
-}
+/* writes bufv without copying it into a contiguous buffer first if possible */
+int procfuse_writeBufFileHandle(struct procfuse *pf, struct fuse_file_info *fi, struct fuse_bufvec *bufv, off_t offset){
+	int rval = 0;
+	size_t size = 0;
+	char *buf = NULL;
+	struct fuse_bufvec mem = FUSE_BUFVEC_INIT(0);
+	struct procfuse_filehandle *handle = procfuse_fileHandle(fi);
 
-int procfuse_isPOD(struct procfuse *pf, const char *absolutepath){
-	struct procfuse_hashnode *node = NULL;
-	int rval = PROCFUSE_NO;
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
+	if(handle==NULL){
+		return -EBADF;
 	}
 
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
-	if(node!=NULL && node->onpodevent.type>T_PROC_POD_NO && node->onpodevent.type<T_PROC_POD_MAX){
-		rval = PROCFUSE_YES;
+	pthread_rwlock_rdlock(&handle->node->lock);
+	rval = procfuse_nodeWriteBuf(handle->node, bufv, offset);
+	pthread_rwlock_unlock(&handle->node->lock);
+	if(rval!=-ENOTSUP){
+		return rval;
 	}
-	procfuse_releaseAccessToNode(pf, node);
+
+	if(bufv->count==1 && bufv->off==0 && !(bufv->buf[0].flags & FUSE_BUF_IS_FD)){
+		return procfuse_writeFileHandle(pf, fi, (const char *)bufv->buf[0].mem, bufv->buf[0].size, offset);
+	}
+
+	size = fuse_buf_size(bufv);
+	buf = (char*)malloc(size>0 ? size : 1);
+	if(buf==NULL){
+		return -ENOMEM;
+	}
+	mem.buf[0].size = size;
+	mem.buf[0].mem = buf;
+	if(fuse_buf_copy(&mem, bufv, (enum fuse_buf_copy_flags)0)!=(ssize_t)size){
+		rval = -EIO;
+	}
+	else{
+		rval = procfuse_writeFileHandle(pf, fi, buf, size, offset);
+	}
+	free(buf);
 
 	return rval;
 }
 
-int procfuse_exists(struct procfuse *pf, const char *absolutepath){
-	struct procfuse_hashnode *node = NULL;
-	int rval = PROCFUSE_NO;
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
-	}
+int procfuse_FUSEgetattr(const char *path, struct stat *stbuf)
+{
+	int rval = 0;
+	struct procfuse_hashnode *node = NULL, *sized = NULL;
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
+	/* like procfuse_LLgetattr(), procfuse_nodeSize() needs pf->lock */
+	pthread_rwlock_rdlock(&pf->lock);
 
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
-	if(node!=NULL){
-		rval = PROCFUSE_YES;
+	node = procfuse_pathToNode(pf, path, PROCFUSE_NO);
+
+	if(node!=NULL || strcmp(path, "/")==0){
+		procfuse_fillStat(node, stbuf);
+		sized = procfuse_pinAppSize(node);
 	}
-	procfuse_releaseAccessToNode(pf, node);
+	else{
+		memset(stbuf, 0, sizeof(struct stat));
+		rval = -ENOENT;
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_fillAppSize(pf, sized, stbuf);
 
 	return rval;
 }
-int procfuse_chmod(struct procfuse *pf, const char *absolutepath, mode_t mode){
-	struct procfuse_hashnode *node = NULL;
-	int rval = PROCFUSE_NO;
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
+
+int procfuse_FUSEreaddir(const char *path, void *buf, fuse_fill_dir_t filler, off_t off, struct fuse_file_info *fi){
+	struct procfuse_dirindex *index = NULL;
+	int rval = 0;
+	size_t i = 0;
+	struct stat st;
+	struct procfuse_hashnode *node = NULL, *value = NULL;
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
+
+	(void)fi;
+
+	/* the directory is only iterated, not accessed like a file, so instead of procfuse_acquireAccessToNode
+	 * the shared tree lock is held for the whole iteration - this keeps concurrent procfuse_create calls
+	 * from growing the index underneath it
+	 */
+	pthread_rwlock_rdlock(&pf->lock);
+
+	node = procfuse_pathToNode(pf, path, PROCFUSE_NO);
+
+	if(node==NULL && strcmp(path,"/")==0){
+		index = &pf->rootindex;
+	}
+	else if(node!=NULL && node->subdirs!=NULL){
+		index = &node->index;
+	}
+	else{
+		rval = -ENOTDIR;
 	}
 
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
-	if(node!=NULL){
-		node->mode = mode;
-		rval = PROCFUSE_YES;
+	if(rval==0){
+		memset(&st, 0, sizeof(st));
+
+		/* off is the inode number of the last entry passed to filler, 0 for the first call */
+		for(i=procfuse_dirIndexSeek(index, (fuse_ino_t)off);i<index->count;i++){
+			value = index->entries[i].node;
+			/* don't list files which shall have been unlinked, this reflects standard linux filesystem behaviour */
+			if(value==NULL || procfuse_isPendingForUnlink(value)){
+				continue;
+			}
+
+			procfuse_fillDirentStat(value, &st);
+
+			/* the buffer of libfuse is full, it calls again with the offset of the last entry it took */
+			if(filler(buf, value->key->name, &st, (off_t)value->ino)){
+				break;
+			}
+		}
 	}
-	procfuse_releaseAccessToNode(pf, node);
+
+	pthread_rwlock_unlock(&pf->lock);
 
 	return rval;
 }
-int procfuse_chown(struct procfuse *pf, const char *absolutepath, uid_t owner, gid_t group){
+
+int procfuse_FUSEgetxattr(const char *path, const char *name, char *value, size_t size){
+	int rval = -ENOENT;
 	struct procfuse_hashnode *node = NULL;
-	int rval = PROCFUSE_NO;
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
-	}
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	pthread_rwlock_rdlock(&pf->lock);
+	node = procfuse_pathToNode(pf, path, PROCFUSE_NO);
 	if(node!=NULL){
-		node->uid = owner;
-		node->gid = group;
-		rval = PROCFUSE_YES;
+		rval = procfuse_nodeGetxattr(node, name, value, size);
 	}
-	procfuse_releaseAccessToNode(pf, node);
+	else if(strcmp(path, "/")==0){
+		rval = -ENODATA;
+	}
+	pthread_rwlock_unlock(&pf->lock);
 
 	return rval;
 }
-int procfuse_utime(struct procfuse *pf, const char *absolutepath, const struct utimbuf *times){
+int procfuse_FUSElistxattr(const char *path, char *list, size_t size){
+	int rval = -ENOENT;
 	struct procfuse_hashnode *node = NULL;
-	int rval = PROCFUSE_NO;
-	if(pf==NULL || absolutepath==NULL || times==NULL){
-		errno = EINVAL;
-		return 0;
-	}
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
+	pthread_rwlock_rdlock(&pf->lock);
+	node = procfuse_pathToNode(pf, path, PROCFUSE_NO);
 	if(node!=NULL){
-		node->access.tv_sec = times->actime;
-		node->access.tv_usec = 0;
-		node->modify.tv_sec = times->modtime;
-		node->modify.tv_usec = 0;
-		rval = PROCFUSE_YES;
+		rval = procfuse_nodeListxattr(node, list, size);
 	}
-	procfuse_releaseAccessToNode(pf, node);
+	else if(strcmp(path, "/")==0){
+		rval = 0;
+	}
+	pthread_rwlock_unlock(&pf->lock);
 
 	return rval;
 }
-int procfuse_utimes(struct procfuse *pf, const char *absolutepath, const struct timeval times[2]){
+
+int procfuse_FUSEopen(const char *path, struct fuse_file_info *fi){
+	int rval = 0;
+
 	struct procfuse_hashnode *node = NULL;
-	int rval = PROCFUSE_NO;
-	if(pf==NULL || absolutepath==NULL){
-		errno = EINVAL;
-		return 0;
-	}
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	node = procfuse_acquireAccessToNode(pf, absolutepath);
-	if(node!=NULL){
-		node->access = times[0];
-		node->modify = times[1];
-		rval = PROCFUSE_YES;
-	}
-	procfuse_releaseAccessToNode(pf, node);
+	node = procfuse_acquireAccessToNode(pf, path);
+
+	rval = procfuse_openFileHandle(pf, node, fi);
 
 	return rval;
 }
+int procfuse_FUSEmknod(const char *path, mode_t mode, dev_t dev){
+	(void)path;
+	(void)mode;
+	(void)dev;
 
-int procfuse_onFuseOpenPOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata){
+	return 0;
+}
+int procfuse_FUSEcreate(const char *path, mode_t mode, struct fuse_file_info *fi){
+	(void)path;
+	(void)mode;
+	(void)fi;
+
+	return 0;
+}
+int procfuse_FUSEtruncate(const char *path, off_t off){
 	int rval = 0;
-	struct procfuse_transactionnode *tnode = NULL;
-	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
+	struct procfuse_hashnode *node = NULL;
+	struct fuse_pollhandle **pollers = NULL;
 
-	(void)(pf);
-	(void)(path);
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	/* transactions not needed for read only files */
-	if((node->flags & O_RDONLY) == O_RDONLY ||
-	   node->onpodevent.type==T_PROC_POD_STRING || node->onpodevent.type==T_PROC_POD_CHAR)
-		return rval;
+	node = procfuse_acquireAccessToNode(pf, path);
 
-	tnode = (struct procfuse_transactionnode *)calloc(sizeof(struct procfuse_transactionnode), 1);
-	if(tnode==NULL){
-		return -EIO;
-	}
-	tnode->tid = tid;
-	tnode->length = 8192;
-	tnode->writebuffer = (char*)calloc(sizeof(char), tnode->length);
-	if(tnode->writebuffer==NULL){
-		free(tnode);
-		return -ENOMEM;
-	}
+	rval = procfuse_nodeTruncate(pf, node, path, off, &pollers);
 
-	procfuse_upgradeNodeReadLockToWriteLock(node);
+	procfuse_releaseAccessToNode(pf, node);
 
-	if(hash_table_insert(node->transactions, &tnode->tid, tnode)==0){
-		free(tnode->writebuffer);
-		free(tnode);
+	procfuse_notifyPollers(pollers);
 
-		tnode = NULL;
-		rval = -ENOMEM;
-	}
+	return rval;
+}
 
-	procfuse_downgradeNodeWriteLockToReadLock(node);
+/* read, write and release are called with path==NULL, see flag_nopath in procfuse_run() */
+int procfuse_FUSEread(const char *path, char *buf, size_t size, off_t offset,
+                         struct fuse_file_info *fi)
+{
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-    return rval;
+	(void)path;
+
+	return procfuse_readFileHandle(pf, fi, buf, size, offset);
 }
-int procfuse_onFuseReadPOD(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
-	int rval = 0, printed = 0;
-	off_t where = 0;
-	size_t cpylen = 0;
-	char podtmp[8192] = {'\0'}; /* more than long enough for pod datatypes - 80bit long double range is 3.65×10^−4951 to 1.18×10^4932  */
-	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
 
-	(void)pf;
+int procfuse_FUSEwrite(const char *path, const char *buf, size_t size,
+                          off_t offset, struct fuse_file_info *fi)
+{
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
+
 	(void)path;
-	(void)tid;
-	(void)size;
 
-	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_RDONLY)==O_RDONLY)){
-		return 0;
-	}
+	return procfuse_writeFileHandle(pf, fi, buf, size, offset);
+}
 
-	printed = 0;
+/* libfuse frees *bufp and the memory of its buffers after replying */
+int procfuse_FUSEread_buf(const char *path, struct fuse_bufvec **bufp, size_t size, off_t offset,
+                          struct fuse_file_info *fi)
+{
+	int rval = 0;
+	struct fuse_bufvec *bufv = NULL;
+	struct procfuse_filehandle *handle = procfuse_fileHandle(fi);
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	procfuse_upgradeNodeReadLockToWriteLock(node);
+	(void)path;
 
-	switch(node->onpodevent.type){
-		case T_PROC_POD_CHAR:
-			if(offset==0){
-			    buffer[0] = node->onpodevent.value.c;
-			    rval = 1;
-			}
-			else
-				rval = 0;
-			break;
-		case T_PROC_POD_INT:
-			printed = snprintf(podtmp, sizeof(podtmp)-1, "%d", node->onpodevent.value.i);
-			break;
-		case T_PROC_POD_INT64:
-			printed = snprintf(podtmp, sizeof(podtmp)-1, "%"PRId64, node->onpodevent.value.l);
-			break;
-		case T_PROC_POD_FLOAT:
-			printed = snprintf(podtmp, sizeof(podtmp)-1, "%g", (double)node->onpodevent.value.f);
-			break;
-		case T_PROC_POD_DOUBLE:
-			printed = snprintf(podtmp, sizeof(podtmp)-1, "%g", node->onpodevent.value.d);
-			break;
-		case T_PROC_POD_LONGDOUBLE:
-			printed = snprintf(podtmp, sizeof(podtmp)-1, "%Le", node->onpodevent.value.ld);
-			break;
-		case T_PROC_POD_STRING:
-			if(node->onpodevent.value.str.length_r==0 || node->onpodevent.value.str.mmapedbuffer_r==NULL){
-				rval = 0;
-				break;
-			}
+	if(handle==NULL){
+		return -EBADF;
+	}
 
-			where = offset;
-			cpylen = size;
-			if(where>node->onpodevent.value.str.length_r){
-				rval = 0;
-				break;
-			}
-			if(cpylen>(size_t)((node->onpodevent.value.str.length_r)-where)){
-				cpylen = (node->onpodevent.value.str.length_r)-where;
-			}
-			memcpy(buffer, (node->onpodevent.value.str.mmapedbuffer_r)+where, cpylen);
-			rval = cpylen;
-			break;
-		default: break;
+	bufv = (struct fuse_bufvec *)malloc(sizeof(struct fuse_bufvec));
+	if(bufv==NULL){
+		return -ENOMEM;
 	}
-	if(node->onpodevent.type!=T_PROC_POD_STRING && node->onpodevent.type!=T_PROC_POD_CHAR){
-	    if(offset>printed){
-		    rval = -EINVAL;
-	    }
-	    else{
-	        memcpy(buffer, podtmp+offset,printed-offset);
-	        rval = printed-offset;
-	    }
+
+	/* unlike the low level backend the data is spliced after the node lock has been released,
+	 * a concurrent write may be seen partially as with any other file
+	 */
+	if(offset==0){
+		procfuse_markSeen(handle);
+	}
+	pthread_rwlock_rdlock(&handle->node->lock);
+	rval = procfuse_nodeReadBuf(handle->node, bufv, size, offset);
+	pthread_rwlock_unlock(&handle->node->lock);
+
+	if(rval==-ENOTSUP){
+		*bufv = FUSE_BUFVEC_INIT(size);
+		bufv->buf[0].mem = malloc(size>0 ? size : 1);
+		if(bufv->buf[0].mem==NULL){
+			free(bufv);
+			return -ENOMEM;
+		}
+		rval = procfuse_readFileHandle(pf, fi, (char*)bufv->buf[0].mem, size, offset);
+		bufv->buf[0].size = (rval>0) ? (size_t)rval : 0;
+	}
+	if(rval<0){
+		free(bufv->buf[0].mem);
+		free(bufv);
+		return rval;
 	}
 
-	procfuse_downgradeNodeWriteLockToReadLock(node);
+	*bufp = bufv;
+	return 0;
+}
+
+int procfuse_FUSEwrite_buf(const char *path, struct fuse_bufvec *buf, off_t offset, struct fuse_file_info *fi)
+{
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
+
+	(void)path;
+
+	return procfuse_writeBufFileHandle(pf, fi, buf, offset);
+}
 
-	return rval;
+/* the private data returned becomes the one of every later fuse context */
+void *procfuse_FUSEinit(struct fuse_conn_info *conn){
+	/* let libfuse splice string POD data from and to the fuse device if the kernel supports it */
+	conn->want |= conn->capable & (FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE);
+
+	return fuse_get_context()->private_data;
 }
 
-int procfuse_onFuseWritePOD(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata){
-	int rval = 0;
-	char podtmp[8192] = {'\0'}; /* more than long enough for pod datatypes - 80bit long double range is 3.65×10^−4951 to 1.18×10^4932  */
-	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
-	struct procfuse_transactionnode *tnode = NULL;
+int procfuse_FUSEpoll(const char *path, struct fuse_file_info *fi, struct fuse_pollhandle *ph, unsigned *reventsp){
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	podtmp[sizeof(podtmp)-1]='\0';
+	(void)path;
 
-	if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_WRONLY)==O_WRONLY)){
-		return 0;
-	}
+	*reventsp = procfuse_pollFileHandle(pf, fi, ph);
 
-	if(size<=0){
-		return 0;
-	}
+	return 0;
+}
 
-	procfuse_upgradeNodeReadLockToWriteLock(node);
+int procfuse_FUSErelease(const char *path, struct fuse_file_info *fi){
+	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	if(node->transactions!=NULL)
-		tnode=(struct procfuse_transactionnode *)hash_table_lookup(node->transactions, &tid);
+	(void)path;
 
-	procfuse_downgradeNodeWriteLockToReadLock(node);
+	procfuse_closeFileHandle(pf, fi);
 
-	/*
-	if(tnode==NULL && node->onpodevent.type!=T_PROC_POD_CHAR && node->onpodevent.type!=T_PROC_POD_STRING){
-		rval = -EIO;
-		return rval;
-	}
-	*/
+	return 0;
+}
+/* EOF - End of Fuse */
 
-/*
-    if(rval==0 && node->onpodevent.type ==T_PROC_POD_STRING && node->onpodevent.touch)
-        node->onpodevent.touch(pf, path, tid, O_WRONLY, PROCFUSE_PRE, pf->appdata);
-*/
+/* FUSE low level functions - inode based backend, see procfuse_setLowLevel() */
 
-	procfuse_upgradeNodeReadLockToWriteLock(node);
+/* the request currently processed by this thread, so procfuse_caller() works for both backends */
+static pthread_key_t procfuse_key_request;
+static pthread_once_t procfuse_key_request_once = PTHREAD_ONCE_INIT;
 
-	switch(node->onpodevent.type){
-	    case T_PROC_POD_CHAR:
-	        node->onpodevent.value.c = buffer[size-1]; /* write the last char in buffer */
-	        rval = 1;
-		    break;
-	    case T_PROC_POD_STRING:
-	    	if(node->onpodevent.value.str.length_r==0 || node->onpodevent.value.str.mmapedbuffer_r==NULL){
-	    		rval = -EIO;
-	    		break;
-	    	}
-	    	if(offset > node->onpodevent.value.str.length_r){
-	    		rval = -EFBIG;
-	    		break;
-	    	}
+void procfuse_createRequestKey(void){
+	pthread_key_create(&procfuse_key_request, NULL);
+}
+struct procfuse* procfuse_LLbegin(fuse_req_t req){
+	pthread_once(&procfuse_key_request_once, procfuse_createRequestKey);
+	pthread_setspecific(procfuse_key_request, req);
+	return (struct procfuse *)fuse_req_userdata(req);
+}
+void procfuse_LLend(void){
+	pthread_setspecific(procfuse_key_request, NULL);
+}
 
-	    	if((off_t)size > ((off_t)node->onpodevent.value.str.length_r-offset)){
-	    		size = ((off_t)node->onpodevent.value.str.length_r-offset);
-	    	}
-	    	if(size>0){
-	    		memcpy(node->onpodevent.value.str.mmapedbuffer_r+offset, buffer, size);
-	    	}
-	    	rval = size;
+void procfuse_LLinit(void *userdata, struct fuse_conn_info *conn){
+	(void)userdata;
 
-		    break;
-	    default:
-	    	if(offset > (off_t)(sizeof(podtmp)-1)){
-	    		rval = -EFBIG;
-	    		break;
-	    	}
+	/* let libfuse splice string POD data from and to the fuse device if the kernel supports it */
+	conn->want |= conn->capable & (FUSE_CAP_SPLICE_READ | FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE);
+}
+void procfuse_LLlookup(fuse_req_t req, fuse_ino_t parent, const char *name){
+	HashTable *htable = NULL;
+	struct procfuse_hashnode *node = NULL, *sized = NULL;
+	struct fuse_entry_param e;
+	int rval = 0;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-	    	if((rval=procfuse_onFuseReadPOD(pf, path, podtmp, sizeof(podtmp), 0, tid, appdata))>0){
-	    		if(offset > (off_t)strlen(podtmp)){
-	    			memset(podtmp+strlen(podtmp), '0', offset-strlen(podtmp));
-	    			podtmp[offset] = '\0';
-	    		}
-	    		if((off_t)size > ((off_t)sizeof(podtmp)-offset)){
-	    			size = ((off_t)sizeof(podtmp)-offset);
-	    		}
+	memset(&e, 0, sizeof(e));
 
-	    		memcpy(podtmp+offset, buffer, size);
-	    		rval = size;
+	pthread_rwlock_rdlock(&pf->lock);
 
-	    		switch(node->onpodevent.type){
-					case T_PROC_POD_INT:
-						node->onpodevent.value.i = atoi(podtmp);
-						break;
-					case T_PROC_POD_INT64:
-						node->onpodevent.value.l = (int64_t)strtoll(podtmp, NULL, 10);
-						break;
-					case T_PROC_POD_FLOAT:
-						node->onpodevent.value.f = strtof(podtmp, NULL);
-						break;
-					case T_PROC_POD_DOUBLE:
-						node->onpodevent.value.d = strtod(podtmp, NULL);
-						break;
-					case T_PROC_POD_LONGDOUBLE:
-						node->onpodevent.value.ld = strtold(podtmp, NULL);
-						break;
-					default:
-						break;
-	    		}
-	    	}
+	if(parent==FUSE_ROOT_ID){
+		htable = pf->root;
+	}
+	else if((node = procfuse_inoToNode(pf, parent))!=NULL){
+		htable = node->subdirs;
+	}
 
-		    break;
+	if(htable==NULL){
+		rval = (node==NULL) ? ENOENT : ENOTDIR;
+	}
+	else{
+		node = procfuse_getNextNode(pf, htable, name);
+		if(node==NULL || procfuse_isPendingForUnlink(node)){
+			rval = ENOENT;
+		}
+		else{
+			e.ino = node->ino;
+			e.attr_timeout = node->cache.attr_timeout;
+			e.entry_timeout = node->cache.entry_timeout;
+			procfuse_fillStat(node, &e.attr);
+			sized = procfuse_pinAppSize(node);
+			/* the kernel now references the inode until it sends a forget for it */
+			__sync_fetch_and_add(&node->nlookup, 1);
+		}
 	}
 
-	procfuse_downgradeNodeWriteLockToReadLock(node);
+	pthread_rwlock_unlock(&pf->lock);
 
-	if(rval > 0){
-	    if(node->onpodevent.type!=T_PROC_POD_STRING && tnode!=NULL)
-		    tnode->haswritten = 1;
-/*	    if(node->onpodevent.type ==T_PROC_POD_STRING && node->onpodevent.touch)
-	        node->onpodevent.touch(pf, path, tid, O_WRONLY, PROCFUSE_POST, pf->appdata);
-*/
-	}
+	procfuse_fillAppSize(pf, sized, &e.attr);
 
-	return rval;
+	if(rval==0 && fuse_reply_entry(req, &e)!=0){
+		procfuse_forgetInode(pf, e.ino, 1);
+	}
+	else if(rval!=0){
+		fuse_reply_err(req, rval);
+	}
+	procfuse_LLend();
 }
+void procfuse_LLforget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup){
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-int procfuse_callPODModify(const struct procfuse *pf, const char *path, struct procfuse_hashnode *node, union procfuse_pod *newvalue){
-	int rval = 0;
+	procfuse_forgetInode(pf, ino, nlookup);
 
-	if(node->onpodevent.onModify!=NULL){
-		switch(node->onpodevent.type){
-			case T_PROC_POD_CHAR:
-				rval = ((procfuse_onModify_c)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->c);
-				break;
-			case T_PROC_POD_INT:
-				rval = ((procfuse_onModify_i)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->i);
-				break;
-			case T_PROC_POD_INT64:
-				rval = ((procfuse_onModify_i64)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->l);
-				break;
-			case T_PROC_POD_FLOAT:
-				rval = ((procfuse_onModify_f)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->f);
-				break;
-			case T_PROC_POD_DOUBLE:
-				rval = ((procfuse_onModify_d)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->d);
-				break;
-			case T_PROC_POD_LONGDOUBLE:
-				rval = ((procfuse_onModify_ld)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->ld);
-				break;
-			case T_PROC_POD_STRING:
-				rval = ((procfuse_onModify_s)node->onpodevent.onModify)(pf, path, -1, pf->appdata, newvalue->str.mmapedbuffer_w, newvalue->str.length_w);
-				break;
-			default:break;
-		}
+	fuse_reply_none(req);
+	procfuse_LLend();
+}
+void procfuse_LLforgetMulti(fuse_req_t req, size_t count, struct fuse_forget_data *forgets){
+	size_t i = 0;
+	struct procfuse *pf = procfuse_LLbegin(req);
+
+	for(i=0;i<count;i++){
+		procfuse_forgetInode(pf, forgets[i].ino, forgets[i].nlookup);
 	}
 
-	return rval;
+	fuse_reply_none(req);
+	procfuse_LLend();
 }
-
-int procfuse_onFuseTruncatePOD(const struct procfuse *pf, const char *path, const off_t off, const void* appdata){
+void procfuse_LLgetattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi){
+	struct procfuse_hashnode *node = NULL, *sized = NULL;
+	struct stat st;
+	double timeout = 0.0;
 	int rval = 0;
-	union procfuse_pod newvalue;
-	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
-	void *remapedbuffer = NULL;
-
-    if(!((node->flags & O_RDWR)==O_RDWR || (node->flags & O_WRONLY)==O_WRONLY || (node->flags & O_TRUNC)==O_TRUNC)){
-    	return 0;
-    }
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-    procfuse_upgradeNodeReadLockToWriteLock(node);
+	(void)fi;
 
-	memset(&newvalue, '\0', sizeof(newvalue));
-	memcpy(&newvalue, &node->onpodevent.value, sizeof(union procfuse_pod));
-	if(node->onpodevent.type == T_PROC_POD_STRING){
-	    newvalue.str.mmapedbuffer_w = newvalue.str.mmapedbuffer_r;
-	    newvalue.str.length_w = off;
+	pthread_rwlock_rdlock(&pf->lock);
+	if(ino==FUSE_ROOT_ID){
+		procfuse_fillStat(NULL, &st);
 	}
+	else if((node = procfuse_inoToNode(pf, ino))!=NULL){
+		procfuse_fillStat(node, &st);
+		sized = procfuse_pinAppSize(node);
+		timeout = node->cache.attr_timeout;
+	}
+	else{
+		rval = ENOENT;
+	}
+	pthread_rwlock_unlock(&pf->lock);
 
-	procfuse_downgradeNodeWriteLockToReadLock(node);
-
+	procfuse_fillAppSize(pf, sized, &st);
 
-	rval = procfuse_callPODModify(pf, path, node, &newvalue);
-	if(rval!=PROCFUSE_YES){
-		rval = -EIO;
-		return rval;
+	if(rval==0){
+		fuse_reply_attr(req, &st, timeout);
 	}
+	else{
+		fuse_reply_err(req, rval);
+	}
+	procfuse_LLend();
+}
+void procfuse_LLgetxattr(fuse_req_t req, fuse_ino_t ino, const char *name, size_t size){
+	struct procfuse_hashnode *node = NULL;
+	char *value = NULL;
+	int rval = -ENOENT;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-	procfuse_upgradeNodeReadLockToWriteLock(node);
-
-	if(rval==PROCFUSE_YES){
-		switch(node->onpodevent.type){
-			case T_PROC_POD_CHAR:
-				node->onpodevent.value.c = '\0';
-				break;
-			case T_PROC_POD_INT:
-				node->onpodevent.value.i = 0;
-				break;
-			case T_PROC_POD_INT64:
-				node->onpodevent.value.l = 0;
-				break;
-			case T_PROC_POD_FLOAT:
-				node->onpodevent.value.f = 0.0;
-				break;
-			case T_PROC_POD_DOUBLE:
-				node->onpodevent.value.d = 0.0;
-				break;
-			case T_PROC_POD_LONGDOUBLE:
-				node->onpodevent.value.ld = 0.0;
-				break;
-			case T_PROC_POD_STRING:
-				if(node->onpodevent.value.str.mmapedbuffer_r!=NULL){
-					if(off<=node->onpodevent.value.str.length_r){
-						memset(node->onpodevent.value.str.mmapedbuffer_r + off, '\0', node->onpodevent.value.str.length_r-off);
-					}
-					else{
-						if(ftruncate(node->onpodevent.value.str.mmapedfd64_r, off)==-1){
-							rval = -errno;
-						}
-						else{
-						    node->onpodevent.value.str.length_r = off;
-						    remapedbuffer = mremap(node->onpodevent.value.str.mmapedbuffer_r, node->onpodevent.value.str.length_r, off, MREMAP_MAYMOVE);
-						    if(remapedbuffer==MAP_FAILED){
-							    rval = -errno;
-						    }
-						}
-					}
-				}
-				break;
-			default:break;
+	/* the value is rendered with the tree lock held and replied to after releasing it */
+	if(size>0 && (value = (char*)malloc(size))==NULL){
+		rval = -ENOMEM;
+	}
+	else{
+		pthread_rwlock_rdlock(&pf->lock);
+		if(ino==FUSE_ROOT_ID){
+			rval = -ENODATA;
 		}
+		else if((node = procfuse_inoToNode(pf, ino))!=NULL){
+			rval = procfuse_nodeGetxattr(node, name, value, size);
+		}
+		pthread_rwlock_unlock(&pf->lock);
 	}
-	procfuse_downgradeNodeWriteLockToReadLock(node);
 
-	return rval;
+	if(rval<0){
+		fuse_reply_err(req, -rval);
+	}
+	else if(size==0){
+		fuse_reply_xattr(req, rval);
+	}
+	else{
+		fuse_reply_buf(req, value, rval);
+	}
+	free(value);
+	procfuse_LLend();
 }
-int procfuse_onFuseReleasePOD(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata){
+void procfuse_LLlistxattr(fuse_req_t req, fuse_ino_t ino, size_t size){
+	struct procfuse_hashnode *node = NULL;
+	char list[sizeof(PROCFUSE_BINARY_XATTR)];
 	int rval = 0;
-	struct procfuse_transactionnode *tnode = NULL;
-	struct procfuse_hashnode *node = (struct procfuse_hashnode *)appdata;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-	(void)pf;
-	(void)path;
+	pthread_rwlock_rdlock(&pf->lock);
+	if(ino!=FUSE_ROOT_ID){
+		node = procfuse_inoToNode(pf, ino);
+		rval = (node!=NULL) ? procfuse_nodeListxattr(node, list, (size<sizeof(list)) ? size : sizeof(list)) : -ENOENT;
+	}
+	pthread_rwlock_unlock(&pf->lock);
 
-	if((node->flags & O_RDWR) == O_RDONLY ||
-	   node->onpodevent.type==T_PROC_POD_STRING || node->onpodevent.type==T_PROC_POD_CHAR)
-		return rval;
+	if(rval<0){
+		fuse_reply_err(req, -rval);
+	}
+	else if(size==0){
+		fuse_reply_xattr(req, rval);
+	}
+	else{
+		fuse_reply_buf(req, list, rval);
+	}
+	procfuse_LLend();
+}
+void procfuse_LLsetattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *fi){
+	struct procfuse_hashnode *node = NULL, *sized = NULL;
+	struct stat st;
+	double timeout = 0.0;
+	struct fuse_pollhandle **pollers = NULL;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-	procfuse_upgradeNodeReadLockToWriteLock(node);
+	(void)fi;
 
-	tnode = (struct procfuse_transactionnode *)hash_table_lookup(node->transactions, &tid);
-	if(tnode!=NULL){
-		switch(node->onpodevent.type){
-			case T_PROC_POD_INT:
-				node->onpodevent.value.i = strtol(tnode->writebuffer, NULL, 0);
-				break;
-			case T_PROC_POD_INT64:
-				node->onpodevent.value.l = strtol(tnode->writebuffer, NULL, 0);
-				break;
-			case T_PROC_POD_FLOAT:
-				node->onpodevent.value.f = strtof(tnode->writebuffer, NULL);
-				break;
-			case T_PROC_POD_DOUBLE:
-				node->onpodevent.value.d = strtod(tnode->writebuffer, NULL);
-				break;
-			case T_PROC_POD_LONGDOUBLE:
-				node->onpodevent.value.ld = strtold(tnode->writebuffer, NULL);
-				break;
-			default: break;
-		}
+	if(ino==FUSE_ROOT_ID){
+		procfuse_fillStat(NULL, &st);
+		fuse_reply_attr(req, &st, 0.0);
+		procfuse_LLend();
+		return;
+	}
 
-		hash_table_remove(node->transactions, &tid);
+	node = procfuse_acquireAccessToInode(pf, ino);
+	if(node==NULL){
+		fuse_reply_err(req, ENOENT);
+		procfuse_LLend();
+		return;
 	}
 
-	procfuse_downgradeNodeWriteLockToReadLock(node);
+	if(to_set & FUSE_SET_ATTR_SIZE){
+		procfuse_nodeTruncate(pf, node, node->absolutepath, attr->st_size, &pollers);
+	}
 
-    return rval;
+	procfuse_releaseAccessToNode(pf, node);
+
+	procfuse_notifyPollers(pollers);
+
+	/* the attributes are filled like procfuse_LLgetattr() does, procfuse_nodeSize() needs pf->lock */
+	pthread_rwlock_rdlock(&pf->lock);
+	node = procfuse_inoToNode(pf, ino);
+	if(node!=NULL){
+		procfuse_fillStat(node, &st);
+		sized = procfuse_pinAppSize(node);
+		timeout = node->cache.attr_timeout;
+	}
+	pthread_rwlock_unlock(&pf->lock);
+
+	procfuse_fillAppSize(pf, sized, &st);
+
+	if(node!=NULL){
+		fuse_reply_attr(req, &st, timeout);
+	}
+	else{
+		fuse_reply_err(req, ENOENT);
+	}
+	procfuse_LLend();
+}
+void procfuse_LLopen(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi){
+	int rval = -EISDIR;
+	struct procfuse_hashnode *node = NULL;
+	struct procfuse *pf = procfuse_LLbegin(req);
+
+	if(ino!=FUSE_ROOT_ID){
+		node = procfuse_acquireAccessToInode(pf, ino);
+		rval = procfuse_openFileHandle(pf, node, fi);
+	}
+
+	if(rval<0){
+		fuse_reply_err(req, -rval);
+	}
+	else{
+		/* only POD and backed files have a known size, which reading through the page cache needs
+		 * files opened for writing bypass it, the written value is visible after the release only
+		 */
+		if(node->passthrough==PROCFUSE_YES && procfuse_nodeBackingFd(node)>=0){
+			/* writes through the page cache are sent here as well, so its content stays the one of the backing file */
+			fi->keep_cache = 1;
+		}
+		else if(node->cache.keep_cache==PROCFUSE_YES && procfuse_hasNodeSize(node) && (fi->flags & O_ACCMODE)==O_RDONLY){
+			fi->keep_cache = 1;
+		}
+		else{
+			/* the path based backend gets this by the direct_io mount option */
+			fi->direct_io = 1;
+		}
+		fuse_reply_open(req, fi);
+	}
+	procfuse_LLend();
 }
-
-/* FUSE functions */
-int procfuse_FUSEgetattr(const char *path, struct stat *stbuf)
-{
+void procfuse_LLread(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi){
 	int rval = 0;
-	struct procfuse_hashnode *node = NULL;
-	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
+	char *buf = NULL;
+	const char *data = NULL;
+	struct fuse_bufvec bufv;
+	struct procfuse_filehandle *handle = procfuse_fileHandle(fi);
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-	node = procfuse_acquireAccessToNode(pf, path);
+	(void)ino;
 
-	memset(stbuf, 0, sizeof(struct stat));
-	if(node!=NULL){
-		stbuf->st_gid = node->gid;
-		stbuf->st_uid = node->uid;
-		stbuf->st_atime = node->access.tv_sec;
-		stbuf->st_mtime = node->modify.tv_sec;
+	if(handle!=NULL){
+		/* fills the page cache of files kept in it */
+		procfuse_nodeFetched(handle->node);
 	}
-
-	if(node!=NULL && node->subdirs==NULL){
-		stbuf->st_mode = S_IFREG;
-		if(node->onevent.onFuseRead){
-		    stbuf->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
+	if(handle!=NULL && procfuse_nodeBackingFd(handle->node)>=0){
+		if(off==0){
+			procfuse_markSeen(handle);
 		}
-		if(node->onevent.onFuseWrite){
-			stbuf->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
+		/* the node lock is held until the data has been spliced, so a concurrent write isn't seen partially */
+		pthread_rwlock_rdlock(&handle->node->lock);
+		rval = procfuse_nodeReadBuf(handle->node, &bufv, size, off);
+		if(rval<0){
+			fuse_reply_err(req, -rval);
 		}
+		else{
+			fuse_reply_data(req, &bufv, FUSE_BUF_SPLICE_MOVE);
+		}
+		pthread_rwlock_unlock(&handle->node->lock);
+		procfuse_LLend();
+		return;
+	}
+	if(handle!=NULL && handle->snapshot!=NULL){
+		/* replied straight from the snapshot without copying it */
+		pthread_mutex_lock(&handle->snapshotlock);
+		rval = procfuse_snapshotRange(pf, handle, size, off, &data);
+		if(rval<0){
+			fuse_reply_err(req, -rval);
+		}
+		else{
+			fuse_reply_buf(req, data, rval);
+		}
+		pthread_mutex_unlock(&handle->snapshotlock);
+		procfuse_LLend();
+		return;
+	}
 
-		stbuf->st_nlink = 1;
+	buf = (char*)malloc(size>0 ? size : 1);
+	if(buf==NULL){
+		fuse_reply_err(req, ENOMEM);
+		procfuse_LLend();
+		return;
 	}
-	else if(node!=NULL || strcmp(path, "/")==0){
-		stbuf->st_mode = S_IFDIR | (S_IRWXU | S_IRWXG | S_IRWXO);
 
-		stbuf->st_nlink = 2;
+	rval = procfuse_readFileHandle(pf, fi, buf, size, off);
+
+	if(rval<0){
+		fuse_reply_err(req, -rval);
 	}
 	else{
-		rval = -ENOENT;
+		fuse_reply_buf(req, buf, rval);
 	}
+	free(buf);
+	procfuse_LLend();
+}
+void procfuse_LLwrite(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t off, struct fuse_file_info *fi){
+	int rval = 0;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-	procfuse_releaseAccessToNode(pf, node);
+	(void)ino;
 
-	return rval;
+	rval = procfuse_writeFileHandle(pf, fi, buf, size, off);
+
+	if(rval<0){
+		fuse_reply_err(req, -rval);
+	}
+	else{
+		fuse_reply_write(req, rval);
+	}
+	procfuse_LLend();
 }
+void procfuse_LLpoll(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, struct fuse_pollhandle *ph){
+	unsigned int revents = 0;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-int procfuse_FUSEreaddir(const char *path, void *buf, fuse_fill_dir_t filler, off_t off, struct fuse_file_info *fi){
-	HashTable *htable = NULL;
+	(void)ino;
+
+	revents = procfuse_pollFileHandle(pf, fi, ph);
+
+	fuse_reply_poll(req, revents);
+	procfuse_LLend();
+}
+void procfuse_LLwriteBuf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *bufv, off_t off, struct fuse_file_info *fi){
 	int rval = 0;
-	HashTableIterator iterator;
-	struct procfuse_hashnode *node = NULL;
-	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-	(void)fi;
-	(void)off;
+	(void)ino;
 
-	node = procfuse_acquireAccessToNode(pf, path);
+	rval = procfuse_writeBufFileHandle(pf, fi, bufv, off);
 
-    if(node==NULL && strcmp(path,"/")==0){
-    	htable = pf->root;
-    }
-    else if(node!=NULL && node->subdirs!=NULL){
-    	htable = node->subdirs;
-    }
-    else{
-    	rval = -ENOTDIR;
-    }
+	if(rval<0){
+		fuse_reply_err(req, -rval);
+	}
+	else{
+		fuse_reply_write(req, rval);
+	}
+	procfuse_LLend();
+}
+void procfuse_LLrelease(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi){
+	int modified = PROCFUSE_NO;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-    if(rval==0){
-        struct stat st;
-        memset(&st, 0, sizeof(st));
-        st.st_size = 0;
-
-	    hash_table_iterate(htable, &iterator);
-	    while (hash_table_iter_has_more(&iterator)) {
-		    struct procfuse_hashnode *value = (struct procfuse_hashnode *)hash_table_iter_next(&iterator);
-
-		    if(value==HASH_TABLE_NULL){
-			    break;
-		    }
-		    /* don't list files which shall have been unlinked, this reflects standard linux filesystem behaviour */
-		    if(value->pendingforunlink==PROCFUSE_YES){
-		    	continue;
-		    }
-
-		    st.st_mode = 0;
-
-		    if(value->subdirs==NULL){
-			    st.st_mode = S_IFREG;
-			    if(value->onevent.onFuseRead){
-				    st.st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
-			    }
-			    if(value->onevent.onFuseWrite){
-				    st.st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
-			    }
-		    }
-		    else{
-			    st.st_mode = S_IFDIR | (S_IRWXU | S_IRWXG | S_IRWXO);
-		    }
-
-            if (filler(buf, value->key, &st, 0)){
-                break;
-            }
-	    }
-    }
+	/* a write transaction is committed by the release, readers may have cached the old value */
+	if((fi->flags & O_ACCMODE)!=O_RDONLY && procfuse_cachedInode(procfuse_fileHandle(fi)->node)!=0){
+		modified = PROCFUSE_YES;
+	}
 
-	procfuse_releaseAccessToNode(pf, node);
+	procfuse_closeFileHandle(pf, fi);
 
-    return rval;
-}
+	fuse_reply_err(req, 0);
 
-int procfuse_FUSEopen(const char *path, struct fuse_file_info *fi){
-	int rval = 0;
+	if(modified==PROCFUSE_YES){
+		procfuse_invalidateInode(pf, ino);
+	}
+	procfuse_LLend();
+}
 
+/* the caller has to hold pf->lock, returns NULL and sets errno if ino isn't a directory */
+struct procfuse_dirindex* procfuse_inoToDirIndex(struct procfuse *pf, fuse_ino_t ino){
 	struct procfuse_hashnode *node = NULL;
-	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
 
-	node = procfuse_acquireAccessToNode(pf, path);
-
-	if(node==NULL || node->subdirs!=NULL || node->pendingforunlink==PROCFUSE_YES){
-		rval = -ENOENT;
+	if(ino==FUSE_ROOT_ID){
+		return &pf->rootindex;
 	}
-	else if(!node->onevent.onFuseRead && ((fi->flags & O_RDONLY) || (fi->flags & O_RDWR))){
-		rval = -EACCES;
+	node = procfuse_inoToNode(pf, ino);
+	if(node==NULL || node->subdirs==NULL){
+		errno = (node==NULL) ? ENOENT : ENOTDIR;
+		return NULL;
 	}
-	else if(!node->onevent.onFuseWrite && ((fi->flags & O_WRONLY) || (fi->flags & O_RDWR))){
-		rval = -EACCES;
+
+	return &node->index;
+}
+void procfuse_LLopendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi){
+	int rval = 0;
+	struct procfuse *pf = procfuse_LLbegin(req);
+
+	/* nothing is kept per open directory, readdir continues after the inode number passed as offset */
+	pthread_rwlock_rdlock(&pf->lock);
+	if(procfuse_inoToDirIndex(pf, ino)==NULL){
+		rval = errno;
+	}
+	pthread_rwlock_unlock(&pf->lock);
+
+	if(rval!=0){
+		fuse_reply_err(req, rval);
 	}
 	else{
-		pf->tidcounter++;
-		fi->fh = pf->tidcounter;
+		fi->fh = 0;
+		fuse_reply_open(req, fi);
+	}
+	procfuse_LLend();
+}
+void procfuse_LLreaddir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *fi){
+	struct procfuse_dirindex *index = NULL;
+	struct procfuse_hashnode *value = NULL;
+	struct stat st;
+	size_t i = 0, used = 0, entsize = 0;
+	char *buffer = NULL;
+	int rval = 0;
+	struct procfuse *pf = procfuse_LLbegin(req);
 
-		if(node->onevent.onFuseOpen){
-			const void *appdata = pf->appdata;
-			if(node->onpodevent.type!=T_PROC_POD_NO)
-				appdata = (const void*)node;
-			node->onevent.onFuseOpen(pf, path, fi->fh, appdata);
-		}
+	(void)fi;
 
+	buffer = (char*)malloc(size>0 ? size : 1);
+	if(buffer==NULL){
+		fuse_reply_err(req, ENOMEM);
+		procfuse_LLend();
+		return;
 	}
+	memset(&st, 0, sizeof(st));
 
-	procfuse_releaseAccessToNode(pf, node);
+	pthread_rwlock_rdlock(&pf->lock);
 
-	return rval;
-}
-int procfuse_FUSEmknod(const char *path, mode_t mode, dev_t dev){
-	(void)path;
-	(void)mode;
-	(void)dev;
+	index = procfuse_inoToDirIndex(pf, ino);
+	if(index==NULL){
+		rval = errno;
+	}
+	else{
+		for(i=procfuse_dirIndexSeek(index, (fuse_ino_t)off);i<index->count;i++){
+			value = index->entries[i].node;
+			if(value==NULL || procfuse_isPendingForUnlink(value)){
+				continue;
+			}
 
-	return 0;
+			procfuse_fillDirentStat(value, &st);
+
+			entsize = fuse_add_direntry(req, buffer+used, size-used, value->key->name, &st, (off_t)value->ino);
+			if(entsize>size-used){
+				break;
+			}
+			used += entsize;
+		}
+	}
+
+	pthread_rwlock_unlock(&pf->lock);
+
+	if(rval!=0){
+		fuse_reply_err(req, rval);
+	}
+	else{
+		fuse_reply_buf(req, buffer, used);
+	}
+	free(buffer);
+	procfuse_LLend();
 }
-int procfuse_FUSEcreate(const char *path, mode_t mode, struct fuse_file_info *fi){
-	(void)path;
-	(void)mode;
-	(void)fi;
+void procfuse_LLreleasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi){
+	(void)ino;
 
-	return 0;
+	fi->fh = 0;
+	fuse_reply_err(req, 0);
 }
-int procfuse_FUSEtruncate(const char *path, off_t off){
-	struct procfuse_hashnode *node = NULL;
+/* EOF - End of Fuse low level */
 
-	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
+struct procfuse_workerpool;
 
-	node = procfuse_acquireAccessToNode(pf, path);
+/* a thread of the worker pool of the low level backend, see procfuse_setWorkers() */
+struct procfuse_worker{
+	struct procfuse_workerpool *pool;
+	pthread_t thread;
+	struct fuse_chan *chan; /* pf->chan or a clone of it owned by the worker */
+	int cpu; /* -1 if the worker isn't pinned */
+};
+struct procfuse_workerpool{
+	struct procfuse *pf;
+	sem_t finished; /* posted by every worker leaving its loop */
+	unsigned int count;
+	struct procfuse_worker *workers;
+};
 
-	if(node!=NULL && node->subdirs==NULL && node->onevent.onFuseTruncate!=NULL){
-		const void *appdata = pf->appdata;
-		if(node->onpodevent.type!=T_PROC_POD_NO)
-			appdata = (const void*)node;
-		node->onevent.onFuseTruncate(pf, path, off, appdata);
-	}
+/* channel operations of a cloned fuse device, the same the kernel channel created by fuse_mount() has */
+int procfuse_receiveCloned(struct fuse_chan **chp, char *buf, size_t size){
+	ssize_t res = 0;
+	int err = 0;
+	struct procfuse *pf = (struct procfuse *)fuse_chan_data(*chp);
 
-	procfuse_releaseAccessToNode(pf, node);
+	do{
+		res = read(fuse_chan_fd(*chp), buf, size);
+		err = errno;
+		/* ENOENT means the request has been interrupted, it's safe to read the next one */
+	}while(res==-1 && err==ENOENT && !fuse_session_exited(pf->session));
 
+	if(fuse_session_exited(pf->session)){
+		return 0;
+	}
+	if(res==-1){
+		/* the filesystem has been unmounted */
+		if(err==ENODEV){
+			fuse_session_exit(pf->session);
+			return 0;
+		}
+		return -err;
+	}
+	return (int)res;
+}
+int procfuse_sendCloned(struct fuse_chan *ch, const struct iovec iov[], size_t count){
+	if(iov!=NULL && writev(fuse_chan_fd(ch), iov, count)==-1){
+		return -errno;
+	}
 	return 0;
 }
+void procfuse_destroyCloned(struct fuse_chan *ch){
+	close(fuse_chan_fd(ch));
+}
 
-int procfuse_FUSEread(const char *path, char *buf, size_t size, off_t offset,
-                         struct fuse_file_info *fi)
-{
-	int rval = 0;
-	struct procfuse_hashnode *node = NULL;
-	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
-
+/* returns a channel on a new fuse device file descriptor reading the requests of pf->chan's connection,
+ * NULL if the kernel doesn't support cloning (before linux 4.2)
+ * the replies to requests have to be written to the descriptor they have been read from
+ */
+struct fuse_chan* procfuse_cloneChan(struct procfuse *pf){
+	static struct fuse_chan_ops ops = { procfuse_receiveCloned, procfuse_sendCloned, procfuse_destroyCloned };
+	struct fuse_chan *ch = NULL;
+	uint32_t masterfd = fuse_chan_fd(pf->chan);
+	int fd = -1;
+
+	fd = open("/dev/fuse", O_RDWR | O_CLOEXEC);
+	if(fd==-1){
+		return NULL;
+	}
+	if(ioctl(fd, FUSE_DEV_IOC_CLONE, &masterfd)==-1){
+		close(fd);
+		return NULL;
+	}
 
-	node = procfuse_acquireAccessToNode(pf, path);
+	ch = fuse_chan_new(&ops, fd, fuse_chan_bufsize(pf->chan), pf);
+	if(ch==NULL){
+		close(fd);
+	}
+	return ch;
+}
 
-	if(node==NULL || node->subdirs!=NULL){
-		rval = -ENOENT;
+void *procfuse_workerThread(void *ptr){
+	struct procfuse_worker *worker = (struct procfuse_worker *)ptr;
+	struct procfuse *pf = worker->pool->pf;
+	struct fuse_chan *ch = NULL;
+	struct fuse_buf fbuf;
+	size_t bufsize = fuse_chan_bufsize(worker->chan);
+	char *mem = NULL;
+	int res = 0;
+	cpu_set_t cpus;
+
+	/* the worker may only be cancelled while waiting for a request */
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+	if(worker->cpu>=0){
+		CPU_ZERO(&cpus);
+		CPU_SET(worker->cpu, &cpus);
+		/* the worker runs unpinned if the cpu has been taken away from the process meanwhile */
+		if(pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)!=0){
+			worker->cpu = -1;
+		}
 	}
-	else if(!node->onevent.onFuseRead){
-		rval = -EBADF;
+
+	/* allocated and touched after pinning, so the pages are placed on the numa node of the worker's cpu */
+	mem = (char*)malloc(bufsize);
+	if(mem!=NULL){
+		memset(mem, '\0', bufsize);
 	}
-	else{
-		if(node->onevent.onFuseRead!=NULL){
-			const void *appdata = pf->appdata;
-			if(node->onpodevent.type!=T_PROC_POD_NO)
-				appdata = (const void*)node;
-			rval = node->onevent.onFuseRead(pf, path, buf, size, offset, fi->fh, appdata);
+	pthread_cleanup_push(free, mem);
+
+	while(mem!=NULL && !fuse_session_exited(pf->session)){
+		memset(&fbuf, '\0', sizeof(fbuf));
+		fbuf.mem = mem;
+		fbuf.size = bufsize;
+		ch = worker->chan;
+
+		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+		res = fuse_session_receive_buf(pf->session, &fbuf, &ch);
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+
+		if(res==-EINTR){
+			continue;
 		}
+		if(res<=0){
+			if(res<0){
+				fuse_session_exit(pf->session);
+			}
+			break;
+		}
+
+		fuse_session_process_buf(pf->session, &fbuf, ch);
 	}
 
-	procfuse_releaseAccessToNode(pf, node);
+	pthread_cleanup_pop(1);
 
-	return rval;
+	sem_post(&worker->pool->finished);
+	return NULL;
 }
 
-int procfuse_FUSEwrite(const char *path, const char *buf, size_t size,
-                          off_t offset, struct fuse_file_info *fi)
-{
-	int rval = 0;
-	struct procfuse_hashnode *node = NULL;
-	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
-	const void *appdata = NULL;
-
-	node = procfuse_acquireAccessToNode(pf, path);
+/* the n-th cpu the process may run on modulo their number, -1 if it can't be determined
+ * taskset, cpusets and offline cpus leave gaps in the numbers, so they're taken from the affinity mask
+ */
+int procfuse_allowedCpu(const cpu_set_t *allowed, unsigned int n){
+	int cpu = 0, count = CPU_COUNT(allowed);
 
-	if(node==NULL || node->subdirs!=NULL){
-		rval = -ENOENT;
+	if(count<=0){
+		return -1;
 	}
-	else if(!node->onevent.onFuseWrite){
-		rval = -EBADF;
+	n %= (unsigned int)count;
+	for(cpu=0;cpu<CPU_SETSIZE;cpu++){
+		if(CPU_ISSET(cpu, allowed) && n--==0){
+			return cpu;
+		}
 	}
-	else{
-		if(node->onevent.onFuseWrite){
-			appdata = pf->appdata;
-			if(node->onpodevent.type!=T_PROC_POD_NO){
-				appdata = (void*)node;
-			}
-			rval = node->onevent.onFuseWrite(pf, path, buf, size, offset, fi->fh, appdata);
+	return -1;
+}
 
-			if(rval==0){
-				rval = -EIO;
+/* replaces fuse_session_loop_mt() if procfuse_setWorkers() has been called
+ * returns when the session has exited, all workers have been stopped then
+ */
+int procfuse_runWorkers(struct procfuse *pf){
+	struct procfuse_workerpool pool;
+	struct procfuse_worker *worker = NULL;
+	unsigned int i = 0;
+	cpu_set_t allowed;
+	int clonefd = pf->fuse_clonefd;
+
+	CPU_ZERO(&allowed);
+	if(pf->fuse_pincpu==PROCFUSE_YES && sched_getaffinity(0, sizeof(allowed), &allowed)!=0){
+		CPU_ZERO(&allowed);
+	}
+
+	memset(&pool, '\0', sizeof(pool));
+	pool.pf = pf;
+	pool.workers = (struct procfuse_worker *)calloc(pf->fuse_workers, sizeof(struct procfuse_worker));
+	if(pool.workers==NULL || sem_init(&pool.finished, 0, 0)!=0){
+		free(pool.workers);
+		return 0;
+	}
+
+	for(i=0;i<pf->fuse_workers;i++){
+		worker = &pool.workers[i];
+		worker->pool = &pool;
+		worker->cpu = procfuse_allowedCpu(&allowed, i);
+
+		/* the first worker reads from the mounted descriptor, the others get a clone of it
+		 * if the kernel can't clone, the remaining workers share the mounted descriptor
+		 */
+		worker->chan = pf->chan;
+		if(i>0 && clonefd==PROCFUSE_YES && (worker->chan = procfuse_cloneChan(pf))==NULL){
+			worker->chan = pf->chan;
+			clonefd = PROCFUSE_NO;
+		}
+
+		if(pthread_create(&worker->thread, NULL, procfuse_workerThread, worker)!=0){
+			if(worker->chan!=pf->chan){
+				fuse_chan_destroy(worker->chan);
 			}
+			break;
 		}
+		pool.count++;
 	}
 
-	procfuse_releaseAccessToNode(pf, node);
+	/* the session ends with the first worker leaving its loop, the others are blocked reading their descriptor */
+	if(pool.count>0){
+		while(sem_wait(&pool.finished)==-1 && errno==EINTR);
+	}
+	fuse_session_exit(pf->session);
 
+	for(i=0;i<pool.count;i++){
+		pthread_cancel(pool.workers[i].thread);
+	}
+	for(i=0;i<pool.count;i++){
+		pthread_join(pool.workers[i].thread, NULL);
+		if(pool.workers[i].chan!=pf->chan){
+			fuse_chan_destroy(pool.workers[i].chan);
+		}
+	}
 
-	return rval;
-}
+	sem_destroy(&pool.finished);
+	free(pool.workers);
 
-int procfuse_FUSErelease(const char *path, struct fuse_file_info *fi){
-	struct procfuse_hashnode *node = NULL;
-	struct procfuse *pf = (struct procfuse *)fuse_get_context()->private_data;
+	return (pool.count>0) ? 1 : 0;
+}
 
-	node = procfuse_acquireAccessToNode(pf, path);
+void *procfuse_threadLowLevel(struct procfuse *pf){
+	struct fuse_args args = FUSE_ARGS_INIT(pf->fuseArgc, (char**)pf->fuseArgv);
+	char *mountpoint=NULL;
+	int multithreaded=0, foreground=0;
+
+	/* this is what fuse_setup() does for the high level api */
+	if(fuse_parse_cmdline(&args, &mountpoint, &multithreaded, &foreground)!=-1 &&
+	   (pf->chan = fuse_mount(mountpoint, &args))!=NULL){
+		pf->session = fuse_lowlevel_new(&args, &pf->procFS_lloper, sizeof(pf->procFS_lloper), pf);
+		if(pf->session!=NULL){
+			fuse_session_add_chan(pf->session, pf->chan);
+		}
+		else{
+			fuse_unmount(mountpoint, pf->chan);
+			pf->chan = NULL;
+		}
+	}
+	pthread_mutex_unlock(&pf->fuselock);
 
-	if(node!=NULL && node->subdirs==NULL){
-		if(node->onevent.onFuseRelease){
-			const void *appdata = pf->appdata;
-			if(node->onpodevent.type!=T_PROC_POD_NO)
-				appdata = (const void*)node;
-			node->onevent.onFuseRelease(pf, path, fi->fh, appdata);
+	if(pf->session!=NULL){
+		if(pf->fuse_workers>0){
+			procfuse_runWorkers(pf);
 		}
+		else if (multithreaded){
+			fuse_session_loop_mt(pf->session);
+		}else{
+			fuse_session_loop(pf->session);
+		}
+
+		pthread_mutex_lock(&pf->fuselock);
+		fuse_session_remove_chan(pf->chan);
+		fuse_session_destroy(pf->session);
+		fuse_unmount(mountpoint, pf->chan);
+		pf->session = NULL;
+		pf->chan = NULL;
+		pf->running = 0;
+		pthread_mutex_unlock(&pf->fuselock);
 	}
 
-	fi->fh = 0;
-	procfuse_releaseAccessToNode(pf, node);
+	free(mountpoint);
+	fuse_opt_free_args(&args);
 
-	return 0;
+	return NULL;
 }
-/* EOF - End of Fuse */
 
 void *procfuse_thread( void *ptr ){
 	struct procfuse *pf = (struct procfuse *)ptr;
@@ -2852,6 +8632,10 @@ void *procfuse_thread( void *ptr ){
 	sigfillset(&set);
 	pthread_sigmask(SIG_SETMASK, &set, NULL);
 
+	if(pf->fuse_lowlevel){
+		return procfuse_threadLowLevel(pf);
+	}
+
 	pf->fuse = fuse_setup(pf->fuseArgc, (char**)pf->fuseArgv, &pf->procFS_oper, sizeof(pf->procFS_oper),
 						  &mountpoint, &multithreaded, pf);
 	pthread_mutex_unlock(&pf->fuselock);
@@ -2885,7 +8669,12 @@ void procfuse_teardown(struct procfuse *pf){
 	}
 
 	pthread_mutex_lock(&pf->fuselock);
-	if(pf->fuse==NULL){
+	if(pf->session!=NULL){
+		if(!fuse_session_exited(pf->session)){
+			fuse_session_exit(pf->session);
+		}
+	}
+	else if(pf->fuse==NULL){
 		errno = EINVAL;
 	}
 	else if(!fuse_exited(pf->fuse)){
@@ -2897,7 +8686,21 @@ void procfuse_teardown(struct procfuse *pf){
 }
 
 void procfuse_caller(uid_t *u, gid_t *g, pid_t *p, mode_t *mask){
-	struct fuse_context *ctx = fuse_get_context();
+	struct fuse_context *ctx = NULL;
+	const struct fuse_ctx *llctx = NULL;
+	fuse_req_t req = NULL;
+
+	pthread_once(&procfuse_key_request_once, procfuse_createRequestKey);
+	req = (fuse_req_t)pthread_getspecific(procfuse_key_request);
+	if(req!=NULL && (llctx = fuse_req_ctx(req))!=NULL){
+		if(u!=NULL) *u = llctx->uid;
+		if(g!=NULL) *g = llctx->gid;
+		if(p!=NULL) *p = llctx->pid;
+		if(mask!=NULL) *mask = llctx->umask;
+		return;
+	}
+
+	ctx = fuse_get_context();
 	if(ctx==NULL) return;
 	if(u!=NULL) *u = ctx->uid;
 	if(g!=NULL) *g = ctx->gid;
@@ -2912,6 +8715,24 @@ int procfuse_setSingleThreaded(struct procfuse *pf, int yes_or_no){
 	pf->fuse_singlethreaded = yes_or_no;
 	return 1;
 }
+int procfuse_setWorkers(struct procfuse *pf, unsigned int workers, int clonefd, int pincpu){
+	if(pf==NULL || pf->running){
+		errno = EINVAL;
+		return 0;
+	}
+	pf->fuse_workers = workers;
+	pf->fuse_clonefd = clonefd;
+	pf->fuse_pincpu = pincpu;
+	return 1;
+}
+int procfuse_setLowLevel(struct procfuse *pf, int yes_or_no){
+	if(pf==NULL || pf->running){
+		errno = EINVAL;
+		return 0;
+	}
+	pf->fuse_lowlevel = yes_or_no;
+	return 1;
+}
 
 void procfuse_run(struct procfuse *pf, int blocking){
 	if(pf==NULL || pf->running){
@@ -2929,7 +8750,34 @@ void procfuse_run(struct procfuse *pf, int blocking){
     pf->procFS_oper.truncate = procfuse_FUSEtruncate;
     pf->procFS_oper.read	 = procfuse_FUSEread;
     pf->procFS_oper.write	 = procfuse_FUSEwrite;
+    pf->procFS_oper.read_buf = procfuse_FUSEread_buf;
+    pf->procFS_oper.write_buf = procfuse_FUSEwrite_buf;
+    pf->procFS_oper.init     = procfuse_FUSEinit;
     pf->procFS_oper.release	 = procfuse_FUSErelease;
+    pf->procFS_oper.poll     = procfuse_FUSEpoll;
+    pf->procFS_oper.getxattr = procfuse_FUSEgetxattr;
+    pf->procFS_oper.listxattr = procfuse_FUSElistxattr;
+    /* read, write and release find the node by fi->fh, libfuse doesn't need to build their paths */
+    pf->procFS_oper.flag_nullpath_ok = 1;
+    pf->procFS_oper.flag_nopath      = 1;
+
+    pf->procFS_lloper.init         = procfuse_LLinit;
+    pf->procFS_lloper.lookup       = procfuse_LLlookup;
+    pf->procFS_lloper.forget       = procfuse_LLforget;
+    pf->procFS_lloper.forget_multi = procfuse_LLforgetMulti;
+    pf->procFS_lloper.getattr      = procfuse_LLgetattr;
+    pf->procFS_lloper.setattr      = procfuse_LLsetattr;
+    pf->procFS_lloper.open         = procfuse_LLopen;
+    pf->procFS_lloper.read         = procfuse_LLread;
+    pf->procFS_lloper.write        = procfuse_LLwrite;
+    pf->procFS_lloper.write_buf    = procfuse_LLwriteBuf;
+    pf->procFS_lloper.release      = procfuse_LLrelease;
+    pf->procFS_lloper.poll         = procfuse_LLpoll;
+    pf->procFS_lloper.getxattr     = procfuse_LLgetxattr;
+    pf->procFS_lloper.listxattr    = procfuse_LLlistxattr;
+    pf->procFS_lloper.opendir      = procfuse_LLopendir;
+    pf->procFS_lloper.readdir      = procfuse_LLreaddir;
+    pf->procFS_lloper.releasedir   = procfuse_LLreleasedir;
 
     pf->fuseArgc=2;
     if(pf->fuse_singlethreaded){
@@ -2937,11 +8785,14 @@ void procfuse_run(struct procfuse *pf, int blocking){
     }
     pf->fuseArgv[pf->fuseArgc++] = "-f"; /* foreground */
     pf->fuseArgv[pf->fuseArgc++] = "-o";
+    /* direct_io is an option of the high level api only, the low level backend sets it per open file */
     if(pf->fuse_option==NULL || strstr(pf->fuse_option, "allow_")==NULL){
-    	pf->fuseArgv[pf->fuseArgc++] = "direct_io,big_writes,default_permissions,nonempty,allow_other";
+    	pf->fuseArgv[pf->fuseArgc++] = pf->fuse_lowlevel ? "big_writes,default_permissions,nonempty,allow_other"
+    	                                                 : "direct_io,big_writes,default_permissions,nonempty,allow_other";
     }
     else{
-    	pf->fuseArgv[pf->fuseArgc++] = "direct_io,big_writes,default_permissions,nonempty";
+    	pf->fuseArgv[pf->fuseArgc++] = pf->fuse_lowlevel ? "big_writes,default_permissions,nonempty"
+    	                                                 : "direct_io,big_writes,default_permissions,nonempty";
     }
     if(pf->fuse_option!=NULL){
     	pf->fuseArgv[pf->fuseArgc++] = "-o";
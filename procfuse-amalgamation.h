@@ -356,8 +356,7 @@ typedef void *HashTableValue;
 
 struct _HashTableIterator {
 	HashTable *hash_table;
-	HashTableEntry *next_entry;
-	int next_chain;
+	unsigned int next_slot;
 };
 
 /**
@@ -522,6 +521,366 @@ HashTableValue hash_table_iter_next(HashTableIterator *iterator);
 
 #endif /* #ifndef ALGORITHM_HASH_TABLE_H */
 
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file slab.h
+ *
+ * @brief Allocator for objects of one fixed size.
+ *
+ * A slab hands out objects of the size given to @ref slab_new. Memory is
+ * taken from the system in chunks of many objects, and objects given back
+ * with @ref slab_release are kept in a free list and reused by the next
+ * @ref slab_alloc instead of being returned to the system.
+ *
+ * All memory of a slab, including objects which have not been released,
+ * is freed by @ref slab_free.
+ *
+ * The functions of one slab may be called from several threads at once.
+ */
+
+#ifndef SLAB_H_
+#define SLAB_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A slab structure.
+ */
+
+typedef struct _Slab Slab;
+
+/**
+ * Create a new slab.
+ *
+ * @param object_size          Size in bytes of the objects allocated from
+ *                             the slab.
+ * @param chunk_objects        Number of objects taken from the system at
+ *                             once.
+ * @return                     A new slab, or NULL if it was not possible to
+ *                             allocate it.
+ */
+
+Slab *slab_new(size_t object_size, unsigned int chunk_objects);
+
+/**
+ * Destroy a slab and all objects allocated from it.
+ *
+ * @param slab                 The slab to free.
+ */
+
+void slab_free(Slab *slab);
+
+/**
+ * Allocate an object from a slab.
+ *
+ * @param slab                 The slab.
+ * @return                     A zero initialised object, or NULL if it was
+ *                             not possible to allocate memory.
+ */
+
+void *slab_alloc(Slab *slab);
+
+/**
+ * Give an object back to the slab it has been allocated from.
+ *
+ * @param slab                 The slab.
+ * @param object               The object to release, may be NULL.
+ */
+
+void slab_release(Slab *slab, void *object);
+
+/**
+ * Number of objects currently allocated from a slab.
+ *
+ * @param slab                 The slab.
+ * @return                     Number of objects allocated and not released.
+ */
+
+unsigned int slab_num_objects(Slab *slab);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLAB_H_ */
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file format-number.h
+ *
+ * @brief Conversion of numbers to decimal text.
+ *
+ * Integers are written exactly like printf's "%d" and "%" PRId64 write
+ * them, two digits at a time.
+ *
+ * Floating point numbers are written with the fewest significant digits
+ * which read back to the same value, the way printf's "%g" lays them out:
+ * in scientific notation if the decimal exponent is below -4 or at least
+ * @ref FORMAT_DOUBLE_PRECISION (@ref FORMAT_FLOAT_PRECISION for floats),
+ * in fixed notation otherwise. The digits are found with the Ryu
+ * algorithm, without multiple precision arithmetic.
+ *
+ * None of the functions allocate memory or depend on the locale. They
+ * may be called from several threads at once.
+ */
+
+#ifndef FORMAT_NUMBER_H_
+#define FORMAT_NUMBER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Size of a buffer which holds the text of any number written by the
+ * functions below, the terminating null byte included.
+ */
+
+#define FORMAT_NUMBER_MAX 32
+
+/**
+ * Decimal exponent from which doubles are written in scientific notation.
+ */
+
+#define FORMAT_DOUBLE_PRECISION 17
+
+/**
+ * Decimal exponent from which floats are written in scientific notation.
+ */
+
+#define FORMAT_FLOAT_PRECISION 9
+
+/**
+ * Write a 32 bit integer.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_int32(int32_t value, char *buffer);
+
+/**
+ * Write a 64 bit integer.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_int64(int64_t value, char *buffer);
+
+/**
+ * Write an unsigned 64 bit integer.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_uint64(uint64_t value, char *buffer);
+
+/**
+ * Write a double with the fewest digits which read back to it.
+ *
+ * Infinities and NaNs are written as "inf", "-inf", "nan" and "-nan".
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_double(double value, char *buffer);
+
+/**
+ * Write a float with the fewest digits which read back to it as a float.
+ *
+ * @param value                The value to write.
+ * @param buffer               Buffer of at least @ref FORMAT_NUMBER_MAX
+ *                             bytes.
+ * @return                     Number of characters written, not counting
+ *                             the terminating null byte.
+ */
+
+size_t format_float(float value, char *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef FORMAT_NUMBER_H_ */
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file parse-number.h
+ *
+ * @brief Conversion of decimal text to numbers.
+ *
+ * The functions read a number from the beginning of the characters
+ * between first and last, which don't need to be null terminated. Unlike
+ * strtol and strtod they don't skip leading blanks and report what went
+ * wrong instead of returning 0:
+ *
+ * @li 0 if a number was read, *end points behind it.
+ * @li EINVAL if first doesn't start with a number, *end is first and the
+ *     value is left alone.
+ * @li ERANGE if the number doesn't fit into the type, *end points behind
+ *     it and the value is left alone.
+ *
+ * Integers are a '+' or '-' followed by decimal digits, eight of them are
+ * checked and converted at once. Floating point numbers are decimal
+ * digits with an optional decimal point and exponent, or "inf",
+ * "infinity" and "nan" in any case, each with an optional sign. They are
+ * rounded correctly: exactly representable cases are computed in floating
+ * point, the others with the Eisel-Lemire algorithm, and numbers with
+ * more than 19 significant digits are handed to strtod.
+ *
+ * The functions may be called from several threads at once.
+ */
+
+#ifndef PARSE_NUMBER_H_
+#define PARSE_NUMBER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Read a 32 bit integer.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL or ERANGE.
+ */
+
+int parse_int32(const char *first, const char *last, int32_t *value, const char **end);
+
+/**
+ * Read a 64 bit integer.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL or ERANGE.
+ */
+
+int parse_int64(const char *first, const char *last, int64_t *value, const char **end);
+
+/**
+ * Read a double, rounded to nearest.
+ *
+ * Numbers too large for a double are ERANGE, too small ones are read as
+ * zero.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL, ERANGE or ENOMEM if a number
+ *                             with many digits couldn't be copied for
+ *                             strtod.
+ */
+
+int parse_double(const char *first, const char *last, double *value, const char **end);
+
+/**
+ * Read a float, rounded to nearest from the decimal text and not from
+ * the nearest double.
+ *
+ * @param first                The first character of the text.
+ * @param last                 The end of the text.
+ * @param value                Where to store the value.
+ * @param end                  If not NULL, where to store the end of the
+ *                             number.
+ * @return                     0, EINVAL, ERANGE or ENOMEM.
+ */
+
+int parse_float(const char *first, const char *last, float *value, const char **end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef PARSE_NUMBER_H_ */
 
 /*  
     ProcFuse is a C library which can be used to register string paths
@@ -554,6 +913,7 @@ extern "C" {
 #define _GNU_SOURCE
 #endif
 #include <sys/types.h>
+#include <stdint.h>
 #include <utime.h>
 
 #define PROCFUSE_VERSION "0.0.1"
@@ -579,6 +939,10 @@ typedef int (*procfuse_onFuseTruncate)(const struct procfuse *pf, const char *pa
 typedef int (*procfuse_onFuseRead)(const struct procfuse *pf, const char *path, char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
 typedef int (*procfuse_onFuseWrite)(const struct procfuse *pf, const char *path, const char *buffer, size_t size, off_t offset, int64_t tid, const void* appdata);
 typedef int (*procfuse_onFuseRelease)(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata);
+/* the number of bytes reading the file returns, negative if unknown - reported as st_size
+ * it's called without any procfuse lock held, so it may create or unlink files
+ */
+typedef off_t (*procfuse_onFuseSize)(const struct procfuse *pf, const char *path, const void* appdata);
 
 typedef int (*procfuse_onModify_c)(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata, char newvalue);
 typedef int (*procfuse_onModify_i)(const struct procfuse *pf, const char *path, int64_t tid, const void* appdata, int newvalue);
@@ -596,6 +960,21 @@ struct procfuse_accessor{
     procfuse_onFuseWrite onFuseWrite;
 
 	procfuse_onFuseRelease onFuseRelease;
+
+	/* optional, not set by procfuse_accessor() - files without it have a size of 0 */
+	procfuse_onFuseSize onFuseSize;
+};
+
+/* how long the kernel may cache what it learned about a file, only honoured by the low level backend
+ * keep_cache keeps the content of a POD file in the page cache across opens, the cache is invalidated
+ * whenever the value changes, so the file always shows the current value
+ * files and directories created below a directory get its policy, with attr_timeout>0 listing them with
+ * attributes costs one lookup per entry instead of a lookup and a getattr
+ */
+struct procfuse_cachepolicy{
+	double attr_timeout; /* seconds */
+	double entry_timeout; /* seconds */
+	int keep_cache; /* PROCFUSE_YES or PROCFUSE_NO */
 };
 
 struct procfuse* procfuse_ctor(const char *filesystemname, const char *mountpoint, const char *fuse_option, const void *appdata);
@@ -606,6 +985,9 @@ struct procfuse_accessor procfuse_accessor(procfuse_onFuseOpen onFuseOpen, procf
                                            procfuse_onFuseRelease onFuseRelease);
 int procfuse_create(struct procfuse *pf, const char *absolutepath, struct procfuse_accessor access);
 
+struct procfuse_cachepolicy procfuse_cachepolicy(double attr_timeout, double entry_timeout, int keep_cache);
+int procfuse_setCachePolicy(struct procfuse *pf, const char *absolutepath, struct procfuse_cachepolicy policy);
+
 int procfuse_createPOD_c(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_c onModify);
 int procfuse_createPOD_i(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_i onModify);
 int procfuse_createPOD_i64(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_i64 onModify);
@@ -614,6 +996,22 @@ int procfuse_createPOD_d(struct procfuse *pf, const char *absolutepath, int flag
 int procfuse_createPOD_ld(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_ld onModify);
 int procfuse_createPOD_s(struct procfuse *pf, const char *absolutepath, int flags, procfuse_onModify_s onModify);
 
+/* a file whose content is the one of fd, procfuse doesn't close fd
+ * flags is one of O_RDONLY, O_WRONLY or O_RDWR
+ */
+int procfuse_createBacked(struct procfuse *pf, const char *absolutepath, int fd, int flags);
+/* serve open files of a string POD or backed node from the kernel's page cache, filled by splicing from the
+ * backing file - only honoured by the low level backend
+ * changes made through procfuse invalidate the cache, changes made to a backing fd directly are not noticed
+ */
+int procfuse_setPassthrough(struct procfuse *pf, const char *absolutepath, int yes_or_no);
+/* render the content of a file once when it's opened for reading instead of on every read, reads see a consistent
+ * snapshot and large generated files aren't rendered again for every chunk
+ * the snapshot is rendered again if the file is read from the beginning after it changed, see procfuse_notify()
+ * reads of fd backed files are consistent anyway, they return EINVAL
+ */
+int procfuse_setSnapshot(struct procfuse *pf, const char *absolutepath, int yes_or_no);
+
 int procfuse_readPOD_c(struct procfuse *pf, const char *absolutepath, char *value);
 int procfuse_readPOD_i(struct procfuse *pf, const char *absolutepath, int *value);
 int procfuse_readPOD_i64(struct procfuse *pf, const char *absolutepath, int64_t *value);
@@ -630,6 +1028,121 @@ int procfuse_writePOD_d(struct procfuse *pf, const char *absolutepath, double va
 int procfuse_writePOD_ld(struct procfuse *pf, const char *absolutepath, long double value);
 int procfuse_writePOD_s(struct procfuse *pf, const char *absolutepath, char *value, int64_t length);
 
+/* a handle pins a POD, the application updates it without any lookup
+ * a store through a handle costs an atomic store of the value and an atomic increment of the change counter of the
+ * node, reads and polls see the change when they come
+ * procfuse_notifyPODHandle() wakes the files waiting in poll and drops the kernel's cache of the node if anything
+ * was stored since its last call, it takes locks and writes to the fuse device, so call it once per batch of stores
+ * - without it cached attributes and content stay until their timeout and a waiting poll isn't woken
+ */
+struct procfuse_podhandle;
+
+struct procfuse_podhandle* procfuse_openPODHandle(struct procfuse *pf, const char *absolutepath);
+void procfuse_closePODHandle(struct procfuse_podhandle *handle);
+int procfuse_notifyPODHandle(struct procfuse_podhandle *handle);
+int procfuse_writePODHandle_c(struct procfuse_podhandle *handle, char newvalue);
+int procfuse_writePODHandle_i(struct procfuse_podhandle *handle, int newvalue);
+int procfuse_writePODHandle_i64(struct procfuse_podhandle *handle, int64_t newvalue);
+int procfuse_writePODHandle_f(struct procfuse_podhandle *handle, float newvalue);
+int procfuse_writePODHandle_d(struct procfuse_podhandle *handle, double newvalue);
+int procfuse_writePODHandle_ld(struct procfuse_podhandle *handle, long double newvalue);
+int procfuse_readPODHandle_c(struct procfuse_podhandle *handle, char *value);
+int procfuse_readPODHandle_i(struct procfuse_podhandle *handle, int *value);
+int procfuse_readPODHandle_i64(struct procfuse_podhandle *handle, int64_t *value);
+int procfuse_readPODHandle_f(struct procfuse_podhandle *handle, float *value);
+int procfuse_readPODHandle_d(struct procfuse_podhandle *handle, double *value);
+int procfuse_readPODHandle_ld(struct procfuse_podhandle *handle, long double *value);
+int procfuse_addPODHandle_i(struct procfuse_podhandle *handle, int delta, int *newvalue);
+int procfuse_addPODHandle_i64(struct procfuse_podhandle *handle, int64_t delta, int64_t *newvalue);
+int procfuse_addPODHandle_f(struct procfuse_podhandle *handle, float delta, float *newvalue);
+int procfuse_addPODHandle_d(struct procfuse_podhandle *handle, double delta, double *newvalue);
+
+/* a POD of length elements of the same type, the file shows one element per line and only the lines of changed
+ * elements are rendered again when it's read
+ * writes to the file start at the beginning of a line and set one element per line, the length is fixed so truncating
+ * the file changes nothing, a length whose text can't be addressed fails with EINVAL
+ * the element functions fail with EINVAL if the type doesn't match or index is out of range, handles opened with
+ * procfuse_openPODHandle() work with the procfuse_*PODArrayHandle_*() functions
+ */
+int procfuse_createPODArray_i(struct procfuse *pf, const char *absolutepath, int flags, size_t length);
+int procfuse_createPODArray_i64(struct procfuse *pf, const char *absolutepath, int flags, size_t length);
+int procfuse_createPODArray_f(struct procfuse *pf, const char *absolutepath, int flags, size_t length);
+int procfuse_createPODArray_d(struct procfuse *pf, const char *absolutepath, int flags, size_t length);
+int procfuse_readPODArray_i(struct procfuse *pf, const char *absolutepath, size_t index, int *value);
+int procfuse_readPODArray_i64(struct procfuse *pf, const char *absolutepath, size_t index, int64_t *value);
+int procfuse_readPODArray_f(struct procfuse *pf, const char *absolutepath, size_t index, float *value);
+int procfuse_readPODArray_d(struct procfuse *pf, const char *absolutepath, size_t index, double *value);
+int procfuse_writePODArray_i(struct procfuse *pf, const char *absolutepath, size_t index, int value);
+int procfuse_writePODArray_i64(struct procfuse *pf, const char *absolutepath, size_t index, int64_t value);
+int procfuse_writePODArray_f(struct procfuse *pf, const char *absolutepath, size_t index, float value);
+int procfuse_writePODArray_d(struct procfuse *pf, const char *absolutepath, size_t index, double value);
+int procfuse_writePODArrayHandle_i(struct procfuse_podhandle *handle, size_t index, int newvalue);
+int procfuse_writePODArrayHandle_i64(struct procfuse_podhandle *handle, size_t index, int64_t newvalue);
+int procfuse_writePODArrayHandle_f(struct procfuse_podhandle *handle, size_t index, float newvalue);
+int procfuse_writePODArrayHandle_d(struct procfuse_podhandle *handle, size_t index, double newvalue);
+int procfuse_readPODArrayHandle_i(struct procfuse_podhandle *handle, size_t index, int *value);
+int procfuse_readPODArrayHandle_i64(struct procfuse_podhandle *handle, size_t index, int64_t *value);
+int procfuse_readPODArrayHandle_f(struct procfuse_podhandle *handle, size_t index, float *value);
+int procfuse_readPODArrayHandle_d(struct procfuse_podhandle *handle, size_t index, double *value);
+int procfuse_addPODArrayHandle_i(struct procfuse_podhandle *handle, size_t index, int delta, int *newvalue);
+int procfuse_addPODArrayHandle_i64(struct procfuse_podhandle *handle, size_t index, int64_t delta, int64_t *newvalue);
+int procfuse_addPODArrayHandle_f(struct procfuse_podhandle *handle, size_t index, float delta, float *newvalue);
+int procfuse_addPODArrayHandle_d(struct procfuse_podhandle *handle, size_t index, double delta, double *newvalue);
+
+/* a record POD shows the fields of a struct of the application as "name value" lines, one node for all of them
+ * writing "name=value" lines changes the fields, a write with an unknown name or a bad value changes none of them
+ * the lines have to come in one write at the start of the file, a write at any other offset fails with EINVAL
+ * procfuse keeps a copy of the fields, record has to stay valid until the node is unlinked
+ * the application changes the fields with the record locked through a handle opened with procfuse_openPODHandle(),
+ * readers see them after unlocking it
+ */
+#define PROCFUSE_FIELD_CHAR       1
+#define PROCFUSE_FIELD_INT        2
+#define PROCFUSE_FIELD_INT64      3
+#define PROCFUSE_FIELD_FLOAT      4
+#define PROCFUSE_FIELD_DOUBLE     5
+#define PROCFUSE_FIELD_LONGDOUBLE 6
+
+struct procfuse_field{
+	const char *name; /* without blanks and '=' */
+	int type; /* PROCFUSE_FIELD_* */
+	size_t offset; /* of the field in the record, see offsetof() */
+};
+
+int procfuse_createRecord(struct procfuse *pf, const char *absolutepath, int flags, const struct procfuse_field *fields, size_t count, void *record);
+int procfuse_lockRecord(struct procfuse_podhandle *handle);
+int procfuse_unlockRecord(struct procfuse_podhandle *handle);
+
+/* a binary view of the values of PODs, in the native byte order and layout of the machine
+ * the extended attribute PROCFUSE_BINARY_XATTR of a numeric, array or record POD holds its value, the elements of
+ * the array or the fields of the record in field order, every value aligned to its size
+ * procfuse_setBinaryView() adds the file PROCFUSE_BINARY_FILE to a directory, it holds all values of the PODs in the
+ * directory: a procfuse_binaryheader, one procfuse_binaryentry per POD or field of a record POD, the terminated
+ * names of the entries, and aligned to 16 bytes the values
+ * the view is rendered when the file is opened, a read shows the values of that moment
+ */
+#define PROCFUSE_BINARY_XATTR "user.procfuse.bin"
+#define PROCFUSE_BINARY_FILE ".bin"
+/* written in native byte order like everything else, the file starts with "PFB1" on a little endian machine and with
+ * "1BFP" on a big endian one - a reader whose byte order differs finds the magic byte swapped
+ */
+#define PROCFUSE_BINARY_MAGIC 0x31424650u
+
+struct procfuse_binaryheader{
+	uint32_t magic;
+	uint32_t count; /* of the entries following the header */
+	uint32_t names; /* offset of the names in the file */
+	uint32_t values; /* offset of the values in the file */
+};
+struct procfuse_binaryentry{
+	uint32_t name; /* offset of the name from the first name, "file" or "file.field" */
+	uint32_t type; /* PROCFUSE_FIELD_* */
+	uint32_t offset; /* of the first value from the first value */
+	uint32_t count; /* of the values, the length of an array */
+};
+
+int procfuse_setBinaryView(struct procfuse *pf, const char *absolutedirectorypath, int yes_or_no);
+
 int procfuse_isPOD(struct procfuse *pf, const char *absolutepath);
 int procfuse_exists(struct procfuse *pf, const char *absolutepath);
 int procfuse_chmod(struct procfuse *pf, const char *absolutepath, mode_t mode);
@@ -640,11 +1153,22 @@ int procfuse_utimes(struct procfuse *pf, const char *absolutepath, const struct
 struct procfuse_error* procfuse_error(struct procfuse *pf);
 
 int procfuse_unlink(struct procfuse *pf, const char *absolutepath);
+/* tells procfuse that the content of a file created by procfuse_create() or procfuse_createBacked() changed
+ * open files polling it are woken and the kernel's cache of it is dropped, POD files do this on every write
+ */
+int procfuse_notify(struct procfuse *pf, const char *absolutepath);
 
 
 void procfuse_run(struct procfuse *pf, int blocking);
 void procfuse_caller(uid_t *u, gid_t *g, pid_t *p, mode_t *mask);
 int procfuse_setSingleThreaded(struct procfuse *pf, int yes_or_no);
+int procfuse_setLowLevel(struct procfuse *pf, int yes_or_no);
+/* the low level backend serves requests with a pool of workers threads instead of libfuse's multi threaded loop
+ * clonefd==PROCFUSE_YES gives every worker its own clone of the fuse device if the kernel supports it (linux 4.2)
+ * pincpu==PROCFUSE_YES binds worker i to the i-th cpu the process may run on, modulo their number, its buffer is allocated on that cpu's numa node
+ * workers==0 restores libfuse's loop, has to be called before procfuse_run()
+ */
+int procfuse_setWorkers(struct procfuse *pf, unsigned int workers, int clonefd, int pincpu);
 void procfuse_teardown(struct procfuse *pf);
 
 #ifdef __cplusplus
@@ -0,0 +1,171 @@
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Fixed size object allocator */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "slab.h"
+
+/* objects are aligned for any type procfuse stores in them, long double included */
+#define SLAB_ALIGN 16
+
+typedef struct _SlabChunk SlabChunk;
+
+/* a chunk header, the objects follow it */
+struct _SlabChunk {
+	SlabChunk *next;
+	char padding[SLAB_ALIGN - sizeof(SlabChunk *)];
+};
+
+/* released objects are linked through their first bytes */
+typedef struct _SlabFreeObject SlabFreeObject;
+
+struct _SlabFreeObject {
+	SlabFreeObject *next;
+};
+
+struct _Slab {
+	pthread_mutex_t lock;
+	size_t object_size;
+	unsigned int chunk_objects;
+	SlabChunk *chunks;
+	SlabFreeObject *free_list;
+	char *unused;         /* objects of the newest chunk which haven't been handed out yet */
+	char *unused_end;
+	unsigned int objects;
+};
+
+Slab *slab_new(size_t object_size, unsigned int chunk_objects)
+{
+	Slab *slab;
+
+	if (object_size == 0 || chunk_objects == 0) {
+		return NULL;
+	}
+
+	slab = (Slab *) calloc(1, sizeof(Slab));
+
+	if (slab == NULL) {
+		return NULL;
+	}
+
+	if (object_size < sizeof(SlabFreeObject)) {
+		object_size = sizeof(SlabFreeObject);
+	}
+	slab->object_size = (object_size + SLAB_ALIGN - 1) & ~((size_t) SLAB_ALIGN - 1);
+	slab->chunk_objects = chunk_objects;
+
+	pthread_mutex_init(&slab->lock, NULL);
+
+	return slab;
+}
+
+void slab_free(Slab *slab)
+{
+	SlabChunk *chunk;
+	SlabChunk *next;
+
+	if (slab == NULL) {
+		return;
+	}
+
+	for (chunk = slab->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+
+	pthread_mutex_destroy(&slab->lock);
+	free(slab);
+}
+
+void *slab_alloc(Slab *slab)
+{
+	void *object = NULL;
+	SlabChunk *chunk;
+
+	pthread_mutex_lock(&slab->lock);
+
+	if (slab->free_list != NULL) {
+		object = slab->free_list;
+		slab->free_list = slab->free_list->next;
+	} else {
+		if (slab->unused == slab->unused_end) {
+
+			/* Take a new chunk from the system, its objects are handed
+			 * out in order */
+
+			chunk = (SlabChunk *) malloc(sizeof(SlabChunk)
+			            + slab->object_size * slab->chunk_objects);
+
+			if (chunk == NULL) {
+				pthread_mutex_unlock(&slab->lock);
+				return NULL;
+			}
+
+			chunk->next = slab->chunks;
+			slab->chunks = chunk;
+			slab->unused = (char *) (chunk + 1);
+			slab->unused_end = slab->unused
+			                 + slab->object_size * slab->chunk_objects;
+		}
+
+		object = slab->unused;
+		slab->unused += slab->object_size;
+	}
+
+	++slab->objects;
+
+	pthread_mutex_unlock(&slab->lock);
+
+	memset(object, 0, slab->object_size);
+
+	return object;
+}
+
+void slab_release(Slab *slab, void *object)
+{
+	SlabFreeObject *free_object = (SlabFreeObject *) object;
+
+	if (object == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&slab->lock);
+
+	free_object->next = slab->free_list;
+	slab->free_list = free_object;
+	--slab->objects;
+
+	pthread_mutex_unlock(&slab->lock);
+}
+
+unsigned int slab_num_objects(Slab *slab)
+{
+	unsigned int objects;
+
+	pthread_mutex_lock(&slab->lock);
+	objects = slab->objects;
+	pthread_mutex_unlock(&slab->lock);
+
+	return objects;
+}
@@ -0,0 +1,105 @@
+/*
+    ProcFuse is a C library which can be used to register string paths
+    representing a file of your own filesystem like /proc used by *nix
+    Copyright (C) 2015 - vrcif0@gmail.com
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * @file slab.h
+ *
+ * @brief Allocator for objects of one fixed size.
+ *
+ * A slab hands out objects of the size given to @ref slab_new. Memory is
+ * taken from the system in chunks of many objects, and objects given back
+ * with @ref slab_release are kept in a free list and reused by the next
+ * @ref slab_alloc instead of being returned to the system.
+ *
+ * All memory of a slab, including objects which have not been released,
+ * is freed by @ref slab_free.
+ *
+ * The functions of one slab may be called from several threads at once.
+ */
+
+#ifndef SLAB_H_
+#define SLAB_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A slab structure.
+ */
+
+typedef struct _Slab Slab;
+
+/**
+ * Create a new slab.
+ *
+ * @param object_size          Size in bytes of the objects allocated from
+ *                             the slab.
+ * @param chunk_objects        Number of objects taken from the system at
+ *                             once.
+ * @return                     A new slab, or NULL if it was not possible to
+ *                             allocate it.
+ */
+
+Slab *slab_new(size_t object_size, unsigned int chunk_objects);
+
+/**
+ * Destroy a slab and all objects allocated from it.
+ *
+ * @param slab                 The slab to free.
+ */
+
+void slab_free(Slab *slab);
+
+/**
+ * Allocate an object from a slab.
+ *
+ * @param slab                 The slab.
+ * @return                     A zero initialised object, or NULL if it was
+ *                             not possible to allocate memory.
+ */
+
+void *slab_alloc(Slab *slab);
+
+/**
+ * Give an object back to the slab it has been allocated from.
+ *
+ * @param slab                 The slab.
+ * @param object               The object to release, may be NULL.
+ */
+
+void slab_release(Slab *slab, void *object);
+
+/**
+ * Number of objects currently allocated from a slab.
+ *
+ * @param slab                 The slab.
+ * @return                     Number of objects allocated and not released.
+ */
+
+unsigned int slab_num_objects(Slab *slab);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLAB_H_ */